@@ -0,0 +1,107 @@
+// action_track.c — action id ring; see action_track.h
+
+#include "action_track.h"
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static action_record_t s_ring[ACTION_TRACK_SLOTS];
+static uint32_t s_next_id = 1;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline action_record_t *slot(uint32_t id) {
+  return &s_ring[id % ACTION_TRACK_SLOTS];
+}
+
+uint32_t action_track_new(int act, uint32_t ms) {
+  const int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_mux);
+  const uint32_t id = s_next_id++;
+  if (s_next_id == 0) {
+    s_next_id = 1;
+  }
+  *slot(id) = (action_record_t){.id = id,
+                                .act = (int16_t)act,
+                                .ms = ms,
+                                .state = ACTION_STATE_QUEUED,
+                                .queued_us = now};
+  portEXIT_CRITICAL(&s_mux);
+  return id;
+}
+
+void action_track_start(uint32_t id) {
+  const int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_mux);
+  action_record_t *r = slot(id);
+  if (r->id == id) {
+    r->state = ACTION_STATE_RUNNING;
+    r->started_us = now;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void action_track_finish(uint32_t id, bool ok, action_record_t *out) {
+  const int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_mux);
+  action_record_t *r = slot(id);
+  if (r->id == id) {
+    r->state = ok ? ACTION_STATE_DONE : ACTION_STATE_FAILED;
+    if (r->started_us == 0) {
+      r->started_us = now;
+    }
+    r->finished_us = now;
+    if (out) {
+      *out = *r;
+    }
+  } else if (out) {
+    *out = (action_record_t){.id = id, .state = ACTION_STATE_FAILED};
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool action_track_get(uint32_t id, action_record_t *out) {
+  if (id == 0) {
+    return false;
+  }
+  portENTER_CRITICAL(&s_mux);
+  const action_record_t r = *slot(id);
+  portEXIT_CRITICAL(&s_mux);
+  if (r.id != id) {
+    return false;
+  }
+  if (out) {
+    *out = r;
+  }
+  return true;
+}
+
+const char *action_state_name(action_state_t s) {
+  switch (s) {
+  case ACTION_STATE_QUEUED:
+    return "queued";
+  case ACTION_STATE_RUNNING:
+    return "running";
+  case ACTION_STATE_DONE:
+    return "done";
+  case ACTION_STATE_FAILED:
+    return "failed";
+  default:
+    return "?";
+  }
+}
+
+static uint32_t span_ms(int64_t from_us, int64_t to_us) {
+  if (from_us == 0 || to_us < from_us) {
+    return 0;
+  }
+  const int64_t ms = (to_us - from_us) / 1000;
+  return ms > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
+}
+
+uint32_t action_record_wait_ms(const action_record_t *r, int64_t now_us) {
+  return span_ms(r->queued_us, r->started_us ? r->started_us : now_us);
+}
+
+uint32_t action_record_run_ms(const action_record_t *r, int64_t now_us) {
+  return span_ms(r->started_us, r->finished_us ? r->finished_us : now_us);
+}
@@ -0,0 +1,62 @@
+// action_track.h — ids and lifecycle of queued actions for GET /actions/<id>
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every queued action gets an id. Ids start at 1, go up by one and are never
+ * 0. The action's record lives in a ring of ACTION_TRACK_SLOTS slots, so
+ * the last ACTION_TRACK_SLOTS ids can be looked up. That covers a full
+ * action queue plus the one running, with room to read the result back
+ * afterwards. Older ids are gone (lookup returns false).
+ *
+ * The enqueuer calls action_track_new(). The worker calls
+ * action_track_start() and action_track_finish(). Anyone may call
+ * action_track_get().
+ */
+
+#define ACTION_TRACK_SLOTS 32
+
+typedef enum {
+  ACTION_STATE_QUEUED = 0,
+  ACTION_STATE_RUNNING,
+  ACTION_STATE_DONE,
+  ACTION_STATE_FAILED, // unknown action, or never reached the queue
+} action_state_t;
+
+typedef struct {
+  uint32_t id;
+  int16_t act; // actions_t
+  uint32_t ms; // TOGGLE on-time as queued
+  action_state_t state;
+  int64_t queued_us; // esp_timer times; 0 until that point is reached
+  int64_t started_us;
+  int64_t finished_us;
+} action_record_t;
+
+/** Claim the next id for act and record it as queued. */
+uint32_t action_track_new(int act, uint32_t ms);
+
+void action_track_start(uint32_t id);
+
+/** Record the outcome; out (optional) receives the final record. */
+void action_track_finish(uint32_t id, bool ok, action_record_t *out);
+
+/** Copy id's record; false once it has been overwritten, or never existed. */
+bool action_track_get(uint32_t id, action_record_t *out);
+
+/** "queued", "running", "done" or "failed". */
+const char *action_state_name(action_state_t s);
+
+/** ms spent waiting in the queue, and running; up to now while still open. */
+uint32_t action_record_wait_ms(const action_record_t *r, int64_t now_us);
+uint32_t action_record_run_ms(const action_record_t *r, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,351 @@
+// actuator.c — relay output service; see actuator.h
+// - Sole writer of the actor pins after actuator_start()
+// - Pending commands are coalesced into one write per wake-up
+// - Change history is a small ring read under a spinlock
+// - Usage counters are saved to NVS from this task, on a fixed period, and
+//   from REBOOT; s_usage_lock keeps the two saves apart
+// - Pulses end on per-actor esp_timer one-shots that queue the clear
+
+#include "actuator.h"
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+#include "event_bus.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "soc/gpio_reg.h"
+#include <string.h>
+
+#define ACTUATOR_QUEUE_LEN 16
+#define ACTUATOR_TASK_STACK 3072
+#define ACTUATOR_TASK_PRIO 6 // above run_program/action_worker (5)
+#define USAGE_NVS_NS "actuator"
+#define USAGE_NVS_KEY "usage"
+#define USAGE_VERSION 1
+#define PULSE_RETRY_US 10000 // queue was full when a pulse ended; try again
+
+static QueueHandle_t s_queue = NULL;
+static TaskHandle_t s_task = NULL;
+static uint64_t s_shadow = 0; // guarded by s_mux
+
+static actuator_change_t s_hist[ACTUATOR_HISTORY];
+static uint32_t s_hist_total = 0; // changes since boot; newest at total-1
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct {
+  uint32_t version;
+  actor_usage_t actors[ACTOR_COUNT];
+} usage_blob_t;
+static esp_timer_handle_t s_pulse_timer[ACTOR_COUNT];
+static uint64_t s_pulse_armed = 0; // guarded by s_mux
+static volatile bool s_usage_loaded = false;
+static usage_blob_t s_usage_saved; // last blob written or read
+static SemaphoreHandle_t s_usage_lock = NULL; // save; made by usage_load
+
+static inline uint64_t fold(uint64_t cur, const actuator_cmd_t *c) {
+  return (((cur & ~c->clear) | c->set) ^ c->toggle) & ALL_ACTORS;
+}
+
+// Write only the bits that differ. The relays sit on both GPIO banks
+// (25-27 and 32-33), so a transition is one W1TS/W1TC pair per bank; raising
+// before clearing means no instant with both old and new actors off.
+static void IRAM_ATTR write_diff(uint64_t before, uint64_t after) {
+  const uint64_t rise = after & ~before;
+  const uint64_t fall = before & ~after;
+  if ((uint32_t)rise)
+    REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)rise);
+  if ((uint32_t)(rise >> 32))
+    REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(rise >> 32));
+  if ((uint32_t)fall)
+    REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)fall);
+  if ((uint32_t)(fall >> 32))
+    REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(fall >> 32));
+}
+
+static void record_change(uint64_t before, uint64_t after) {
+  actuator_change_t ch = {.t_us = esp_timer_get_time(),
+                          .mask = after,
+                          .rose = after & ~before,
+                          .fell = before & ~after};
+  portENTER_CRITICAL(&s_mux);
+  s_hist[s_hist_total % ACTUATOR_HISTORY] = ch;
+  s_hist_total++;
+  portEXIT_CRITICAL(&s_mux);
+  gpio_mask_note_edges(before, after);
+  ActiveStatus.ActiveDeviceMask = after;
+  bus_event_t ev = {
+      .type = BUS_EV_ACTUATOR,
+      .actuator = {.mask = after, .rose = ch.rose, .fell = ch.fell}};
+  event_bus_publish(&ev);
+}
+
+static void actuator_task(void *arg) {
+  (void)arg;
+  actuator_cmd_t c;
+  TickType_t next_save =
+      xTaskGetTickCount() + pdMS_TO_TICKS(ACTUATOR_USAGE_SAVE_MS);
+  for (;;) {
+    const TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(now - next_save) >= 0) {
+      actuator_usage_save();
+      next_save = now + pdMS_TO_TICKS(ACTUATOR_USAGE_SAVE_MS);
+    }
+    if (xQueueReceive(s_queue, &c, next_save - now) != pdTRUE) {
+      continue;
+    }
+    portENTER_CRITICAL(&s_mux);
+    const uint64_t before = s_shadow;
+    portEXIT_CRITICAL(&s_mux);
+    uint64_t next = fold(before, &c);
+    // Coalesce whatever else is already queued into the same write
+    while (xQueueReceive(s_queue, &c, 0) == pdTRUE) {
+      next = fold(next, &c);
+    }
+    if (next == before) {
+      continue;
+    }
+    write_diff(before, next);
+    portENTER_CRITICAL(&s_mux);
+    s_shadow = next;
+    portEXIT_CRITICAL(&s_mux);
+    record_change(before, next);
+    _LOG_D("actuators 0x%llx -> 0x%llx", (unsigned long long)before,
+           (unsigned long long)next);
+  }
+}
+
+static bool submit(const actuator_cmd_t *cmd, TickType_t wait) {
+  if (!s_queue || !cmd) {
+    _LOG_W("actuator not started; dropping command");
+    return false;
+  }
+  if (xQueueSend(s_queue, cmd, wait) != pdTRUE) {
+    _LOG_W("actuator queue full; dropping command");
+    return false;
+  }
+  return true;
+}
+
+// Drop pending pulse deadlines for the actors in mask
+static void pulse_cancel(uint64_t mask) {
+  portENTER_CRITICAL(&s_mux);
+  const uint64_t armed = s_pulse_armed & mask;
+  s_pulse_armed &= ~armed;
+  portEXIT_CRITICAL(&s_mux);
+  for (int i = 0; armed && i < ACTOR_COUNT; i++) {
+    if (armed & actor_bit((actor_id_t)i)) {
+      esp_timer_stop(s_pulse_timer[i]);
+    }
+  }
+}
+
+// esp_timer task: the deadline of one actor's pulse
+static void pulse_expired(void *arg) {
+  const int i = (int)(intptr_t)arg;
+  const uint64_t bit = actor_bit((actor_id_t)i);
+  // Test and disarm in one step, so a pulse re-armed after this point keeps
+  // its own deadline
+  portENTER_CRITICAL(&s_mux);
+  const bool armed = (s_pulse_armed & bit) != 0;
+  s_pulse_armed &= ~bit;
+  portEXIT_CRITICAL(&s_mux);
+  if (!armed) {
+    return; // taken over by another command meanwhile
+  }
+  const actuator_cmd_t c = {.clear = bit};
+  if (!submit(&c, pdMS_TO_TICKS(20))) {
+    // Never leave a pulsed relay on: retry until the off is queued
+    portENTER_CRITICAL(&s_mux);
+    s_pulse_armed |= bit;
+    portEXIT_CRITICAL(&s_mux);
+    esp_timer_start_once(s_pulse_timer[i], PULSE_RETRY_US);
+    return;
+  }
+  _LOG_D("pulse end: %s", actor_name((actor_id_t)i));
+}
+
+esp_err_t actuator_start(void) {
+  if (s_task) {
+    return ESP_OK;
+  }
+  gpio_mask_config_outputs(ALL_ACTORS);
+  REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)ALL_ACTORS);
+  REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(ALL_ACTORS >> 32));
+  s_shadow = 0;
+  ActiveStatus.ActiveDeviceMask = 0;
+
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    const esp_timer_create_args_t args = {
+        .callback = pulse_expired,
+        .arg = (void *)(intptr_t)i,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "act_pulse",
+    };
+    if (esp_timer_create(&args, &s_pulse_timer[i]) != ESP_OK) {
+      _LOG_E("failed to create pulse timer");
+      return ESP_ERR_NO_MEM;
+    }
+  }
+
+  s_queue = xQueueCreate(ACTUATOR_QUEUE_LEN, sizeof(actuator_cmd_t));
+  if (!s_queue) {
+    _LOG_E("failed to create actuator queue");
+    return ESP_ERR_NO_MEM;
+  }
+  if (xTaskCreate(actuator_task, "actuator", ACTUATOR_TASK_STACK, NULL,
+                  ACTUATOR_TASK_PRIO, &s_task) != pdPASS) {
+    _LOG_E("failed to create actuator task");
+    vQueueDelete(s_queue);
+    s_queue = NULL;
+    s_task = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+bool actuator_submit(const actuator_cmd_t *cmd, TickType_t wait) {
+  if (cmd) {
+    pulse_cancel((cmd->set | cmd->clear | cmd->toggle) & ALL_ACTORS);
+  }
+  return submit(cmd, wait);
+}
+
+esp_err_t actuator_pulse(uint64_t mask, uint32_t ms) {
+  mask &= ALL_ACTORS;
+  if (!mask || ms == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  // Stop old deadlines first so none can fire between the on and re-arming
+  pulse_cancel(mask);
+  // Arm before the set is queued: a command that takes these actors over
+  // from here on clears the bits in actuator_submit, and the off is dropped
+  portENTER_CRITICAL(&s_mux);
+  s_pulse_armed |= mask;
+  portEXIT_CRITICAL(&s_mux);
+  const actuator_cmd_t c = {.set = mask};
+  if (!submit(&c, portMAX_DELAY)) {
+    pulse_cancel(mask);
+    return ESP_ERR_INVALID_STATE;
+  }
+  // Timers start after the set is queued, so the clear can never overtake
+  // it. One that fires for an actor taken over meanwhile finds it disarmed.
+  portENTER_CRITICAL(&s_mux);
+  const uint64_t still = s_pulse_armed & mask;
+  portEXIT_CRITICAL(&s_mux);
+  for (int i = 0; still && i < ACTOR_COUNT; i++) {
+    if (still & actor_bit((actor_id_t)i)) {
+      esp_timer_start_once(s_pulse_timer[i], (uint64_t)ms * 1000ULL);
+    }
+  }
+  _LOG_D("pulse 0x%llx for %lu ms", (unsigned long long)mask,
+         (unsigned long)ms);
+  return ESP_OK;
+}
+
+uint64_t actuator_get_pulsing(void) {
+  portENTER_CRITICAL(&s_mux);
+  const uint64_t m = s_pulse_armed;
+  portEXIT_CRITICAL(&s_mux);
+  return m;
+}
+
+uint64_t actuator_get_mask(void) {
+  // 64-bit loads are two words on this core; read under the lock
+  portENTER_CRITICAL(&s_mux);
+  const uint64_t m = s_shadow;
+  portEXIT_CRITICAL(&s_mux);
+  return m;
+}
+
+size_t actuator_get_changes(actuator_change_t *out, size_t max,
+                            uint32_t *total) {
+  size_t n = 0;
+  portENTER_CRITICAL(&s_mux);
+  const uint32_t t = s_hist_total;
+  const uint32_t avail = (t < ACTUATOR_HISTORY) ? t : ACTUATOR_HISTORY;
+  while (out && n < max && n < avail) {
+    out[n] = s_hist[(t - 1 - n) % ACTUATOR_HISTORY];
+    n++;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (total) {
+    *total = t;
+  }
+  return n;
+}
+
+esp_err_t actuator_usage_load(void) {
+  nvs_handle_t h;
+  usage_blob_t blob = {0};
+  size_t len = sizeof(blob);
+  esp_err_t err = nvs_open(USAGE_NVS_NS, NVS_READONLY, &h);
+  if (err == ESP_OK) {
+    err = nvs_get_blob(h, USAGE_NVS_KEY, &blob, &len);
+    nvs_close(h);
+  }
+  if (err == ESP_OK && len == sizeof(blob) && blob.version == USAGE_VERSION) {
+    actor_usage_add(blob.actors);
+    _LOG_I("actuator usage restored (HEAT %llu s, %lu cycles)",
+           (unsigned long long)(blob.actors[ACTOR_HEAT].on_us / 1000000),
+           (unsigned long)blob.actors[ACTOR_HEAT].cycles);
+  } else if (err == ESP_ERR_NVS_NOT_FOUND || err == ESP_OK) {
+    _LOG_I("actuator usage: no saved counters, starting from zero");
+  } else {
+    // Leave saving off so a transient read error cannot wipe the totals
+    _LOG_W("actuator usage: read failed (%s)", esp_err_to_name(err));
+    return err;
+  }
+  if (!s_usage_lock) {
+    s_usage_lock = xSemaphoreCreateMutex();
+    if (!s_usage_lock) {
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  blob.version = USAGE_VERSION;
+  actor_usage_get(blob.actors);
+  s_usage_saved = blob;
+  s_usage_loaded = true;
+  return ESP_OK;
+}
+
+// s_usage_lock held
+static esp_err_t usage_save_locked(void) {
+  usage_blob_t blob;
+  memset(&blob, 0, sizeof(blob));
+  blob.version = USAGE_VERSION;
+  actor_usage_get(blob.actors);
+  bool same = true;
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    same = same && blob.actors[i].on_us == s_usage_saved.actors[i].on_us &&
+           blob.actors[i].cycles == s_usage_saved.actors[i].cycles;
+  }
+  if (same) {
+    return ESP_OK; // idle: no flash write
+  }
+  nvs_handle_t h;
+  esp_err_t err = nvs_open(USAGE_NVS_NS, NVS_READWRITE, &h);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(h, USAGE_NVS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+      err = nvs_commit(h);
+    }
+    nvs_close(h);
+  }
+  if (err != ESP_OK) {
+    _LOG_W("actuator usage: save failed (%s)", esp_err_to_name(err));
+    return err;
+  }
+  s_usage_saved = blob;
+  return ESP_OK;
+}
+
+esp_err_t actuator_usage_save(void) {
+  if (!s_usage_loaded) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  xSemaphoreTake(s_usage_lock, portMAX_DELAY);
+  const esp_err_t err = usage_save_locked();
+  xSemaphoreGive(s_usage_lock);
+  return err;
+}
@@ -0,0 +1,103 @@
+// actuator.h — single owner of the relay outputs (HEAT/SPRAY/INLET/DRAIN/SOAP)
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every relay write goes through one task that keeps a shadow of the actor
+ * mask. Callers queue commands; the task folds everything pending into one
+ * target mask and writes only the differences with W1TS/W1TC, so a step
+ * transition never passes through an all-off state and a relay that stays on
+ * is never touched. Each change is timestamped for telemetry and reported to
+ * gpio_mask_note_edges() for ADC blanking.
+ *
+ * A command is applied as: next = ((shadow & ~clear) | set) ^ toggle,
+ * restricted to ALL_ACTORS.
+ */
+typedef struct {
+  uint64_t set;
+  uint64_t clear;
+  uint64_t toggle;
+} actuator_cmd_t;
+
+/** One applied change. */
+typedef struct {
+  int64_t t_us;  // esp_timer time of the register writes
+  uint64_t mask; // actor levels after the change
+  uint64_t rose; // bits switched on
+  uint64_t fell; // bits switched off
+} actuator_change_t;
+
+#define ACTUATOR_HISTORY 16 // changes kept for actuator_get_changes()
+
+/** Configure the relay pins as outputs (all off) and start the task. */
+esp_err_t actuator_start(void);
+
+/** Queue one command. Returns false if the queue stayed full for wait. */
+bool actuator_submit(const actuator_cmd_t *cmd, TickType_t wait);
+
+/** Drive the actors in mask to the levels in levels (others untouched). */
+static inline bool actuator_apply(uint64_t mask, uint64_t levels) {
+  const actuator_cmd_t c = {
+      .set = mask & levels, .clear = mask & ~levels, .toggle = 0};
+  return actuator_submit(&c, portMAX_DELAY);
+}
+static inline bool actuator_set(uint64_t mask) {
+  const actuator_cmd_t c = {.set = mask};
+  return actuator_submit(&c, portMAX_DELAY);
+}
+static inline bool actuator_clear(uint64_t mask) {
+  const actuator_cmd_t c = {.clear = mask};
+  return actuator_submit(&c, portMAX_DELAY);
+}
+static inline bool actuator_toggle(uint64_t mask) {
+  const actuator_cmd_t c = {.toggle = mask};
+  return actuator_submit(&c, portMAX_DELAY);
+}
+
+/**
+ * Switch the actors in mask on now and off again after ms, timed by one
+ * esp_timer one-shot per actor (no task polls for the deadline). Pulsing an
+ * actor that is already pulsing restarts its deadline; any other command
+ * that touches it (set/clear/toggle/apply) cancels the pending off, so a
+ * program step that takes an actor over keeps it.
+ */
+esp_err_t actuator_pulse(uint64_t mask, uint32_t ms);
+
+/** Actors with a pulse deadline pending. */
+uint64_t actuator_get_pulsing(void);
+
+/** Shadow of the actor outputs as last written. */
+uint64_t actuator_get_mask(void);
+
+/**
+ * Usage counters (actor_usage_get()) survive reboots: the task writes them to
+ * NVS every ACTUATOR_USAGE_SAVE_MS while they change. Call
+ * actuator_usage_load() once after nvs_flash_init(); nothing is saved before
+ * that, so a boot cannot overwrite the stored totals with zeros.
+ */
+#define ACTUATOR_USAGE_SAVE_MS (10 * 60 * 1000)
+
+esp_err_t actuator_usage_load(void);
+
+/** Write the counters now if they changed since the last save. Any task. */
+esp_err_t actuator_usage_save(void);
+
+/**
+ * Copy up to max most recent changes, newest first. Returns the number
+ * copied; *total (optional) receives the number of changes since boot.
+ */
+size_t actuator_get_changes(actuator_change_t *out, size_t max,
+                            uint32_t *total);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,9 @@
 // analog.c — Option A drop‑in replacement (ESP-IDF 5.x)
-// - Collects full sample stats every SAMPLE_PERIOD_MS
-// - Logs only every _LOG_FREQ_ seconds
-// - Disables temperature sampling/logging while no program is active
-//   (ActiveStatus.Program must be non-empty to run)
+// - Collects full sample stats at an adaptive cadence (see select_mode()):
+//   slow while idle, fast on heater-controlled steps and near thresholds,
+//   fewer reads per collection when raw_std shows a quiet signal
+// - Logs only every _LOG_FREQ_ seconds; ADC_DUTY per-mode savings every
+//   _DUTY_LOG_FREQ_ seconds
 // - Preserves legacy line: "Current ADC reading: <int>" at the chosen log
 // cadence
 // - Uses ADC calibration (line or curve fitting) when available
@@ -13,14 +14,20 @@
 // temp),
 //   false if Thermistor→GND, Rk→Vsupply (counts fall with temp).
 
+#include "analog.h"
+#include "analog_convert.h"
 #include "dishwasher_programs.h" // for ActiveStatus.Program
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "event_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "ring_buffer.h"
+#include "run_capture.h"
+#include "temp_history.h"
 #include <math.h>
 #include <stdint.h>
 #include <string.h>
@@ -34,8 +41,41 @@
 #define ANALOG_ADC_ATTEN ADC_ATTEN_DB_11 // ~3.3V full-scale on ADC1
 #define ANALOG_BITWIDTH ADC_BITWIDTH_DEFAULT
 
-#define SAMPLE_PERIOD_MS 100 // collect at 10 Hz
-#define OVERSAMPLE_N 16      // readings per collection
+// Adaptive cadence: period / oversample depth per sampler mode
+//   IDLE   — no program running; just keep CurrentTemp fresh
+//   ACTIVE — program running, step not under thermostat control
+//   HEAT   — heater-controlled step, or temperature near a step threshold
+#define IDLE_PERIOD_MS 1000
+#define IDLE_OVERSAMPLE_N 4
+#define ACTIVE_PERIOD_MS 500
+#define ACTIVE_OVERSAMPLE_N 8
+#define HEAT_PERIOD_MS 100 // legacy fixed rate (10 Hz)
+#define HEAT_OVERSAMPLE_N 16
+
+#define OVERSAMPLE_MAX 16 // upper bound of any mode (buffer size)
+#define OVERSAMPLE_MIN 4  // floor when the signal is quiet
+#define QUIET_STD_RAW 2.0f  // raw_std below this halves the oversample depth
+#define NOISY_STD_RAW 8.0f  // raw_std above this forces OVERSAMPLE_MAX
+#define NEAR_THRESHOLD_F 5  // ±°F around step min/max temp that forces HEAT mode
+
+// Actuator blanking: reads taken within this window after any relay/pump edge
+// (g_actuator_edge_us) are discarded; runtime-adjustable via
+// analog_set_blanking_ms()
+#ifndef ANALOG_BLANK_MS
+#define ANALOG_BLANK_MS 50
+#endif
+
+// Baseline the duty-cycle savings are measured against (old fixed sampler)
+#define BASELINE_PERIOD_MS 100
+#define BASELINE_OVERSAMPLE_N 16
+#define _DUTY_LOG_FREQ_ 60 // seconds between ADC_DUTY prints
+
+// Heating-rate estimator: least-squares fit of tempF over a rolling window
+#define TREND_POINT_MS 2000 // one regression point per 2 s of samples
+#define TREND_POINTS 60     // 60 points → 2 min window
+#define TREND_MIN_POINTS 8  // fewer points than this → trend not valid
+#define TREND_MIN_RATE 0.05f // °F/min below which no ETA is projected
+
 #define EWMA_ALPHA 0.10f     // weighted-average smoothing factor [0..1]
 #define _LOG_FREQ_ 10        // seconds between log prints
 
@@ -66,14 +106,41 @@ typedef struct SampleStats {
   float Rth_ohm; // computed thermistor resistance from divider
   float tempC;   // Beta model
   float tempF;
+  float tempF_lin; // unrounded linear-fit °F (feeds the trend estimator)
 } SampleStats;
 
+// Rolling (t, °F) window for the heating-rate fit; each point is the mean of
+// all collections inside one TREND_POINT_MS slot, so cost is independent of
+// the sampler mode. The window keeps min/max and regression sums itself, so
+// a refit is O(1).
+RING_BUFFER_WINDOW_DEFINE(trend_win, float, TREND_POINTS);
+
+typedef struct {
+  trend_win pts;
+  int64_t slot_start_ms;
+  float slot_sum;
+  uint32_t slot_n;
+} TrendWindow;
+
 static adc_oneshot_unit_handle_t s_adc = NULL;
 static adc_cali_handle_t s_cali = NULL;
 static bool s_cal_ok = false;
 static TaskHandle_t s_task = NULL;
 static volatile bool s_running = false;
 static float s_ewma = NAN; // persisted EWMA across samples
+static float s_last_std = NAN; // raw_std of the previous collection
+static volatile uint32_t s_blank_ms = ANALOG_BLANK_MS;
+
+static analog_sampler_stats_t s_stats = {0};
+static analog_trend_t s_trend = {.secs_to_min_temp = -1,
+                                 .secs_to_max_temp = -1};
+static TrendWindow s_window = {0};
+static latency_hist s_jitter;     // sampler start lateness (µs)
+static p2_quantile_t s_noise_p95; // raw_std per collection
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const MODE_NAMES[ANALOG_MODE_COUNT] = {"idle", "active",
+                                                          "heat"};
 
 // ──────────────────────────────────────────────────────────────────────────────
 // Helpers
@@ -83,9 +150,71 @@ static inline uint32_t now_ms(void) {
 }
 
 static inline bool program_running(void) {
-  // Treat non-empty Program string as "running"; adjust if you use a sentinel
-  // like "None".
-  return (ActiveStatus.Program[0] != '\0');
+  // Program keeps its name after completion, so key off the cycle label:
+  // init_status() sets "Off" and the last line of every program is "fini".
+  const char *c = (const char *)ActiveStatus.Cycle;
+  return c[0] != '\0' && strcmp(c, "Off") != 0 && strcmp(c, "fini") != 0;
+}
+
+// Line currently executed by run_program(), or NULL
+static const ProgramLineStruct *active_line(void) {
+  const Program_Entry *p = (const Program_Entry *)&ActiveStatus.Active_Program;
+  const int32_t idx = ActiveStatus.StepIndex;
+  if (!p->lines || idx < 1 || (size_t)idx > p->num_lines)
+    return NULL;
+  return &p->lines[idx - 1];
+}
+
+// True while inside the blanking window that follows an actuator edge
+static inline bool in_blanking_window(void) {
+  const int64_t edge = g_actuator_edge_us;
+  return edge > 0 &&
+         (esp_timer_get_time() - edge) < (int64_t)s_blank_ms * 1000;
+}
+
+static inline bool near_threshold(int temp_f, int threshold_f) {
+  return threshold_f > 0 && abs(temp_f - threshold_f) <= NEAR_THRESHOLD_F;
+}
+
+static analog_mode_t select_mode(void) {
+  if (!program_running())
+    return ANALOG_MODE_IDLE;
+  if (ActiveStatus.HEAT_REQUESTED)
+    return ANALOG_MODE_HEAT;
+  const ProgramLineStruct *ln = active_line();
+  const int t = ActiveStatus.CurrentTemp;
+  if (ln && (near_threshold(t, ln->min_temp) || near_threshold(t, ln->max_temp)))
+    return ANALOG_MODE_HEAT;
+  return ANALOG_MODE_ACTIVE;
+}
+
+static uint32_t mode_period_ms(analog_mode_t m) {
+  switch (m) {
+  case ANALOG_MODE_IDLE:
+    return IDLE_PERIOD_MS;
+  case ANALOG_MODE_ACTIVE:
+    return ACTIVE_PERIOD_MS;
+  default:
+    return HEAT_PERIOD_MS;
+  }
+}
+
+// Oversample depth: mode default, halved on a quiet signal, maxed when noisy
+static int mode_oversample_n(analog_mode_t m) {
+  int n = (m == ANALOG_MODE_IDLE)     ? IDLE_OVERSAMPLE_N
+          : (m == ANALOG_MODE_ACTIVE) ? ACTIVE_OVERSAMPLE_N
+                                      : HEAT_OVERSAMPLE_N;
+  if (!isnan(s_last_std)) {
+    if (s_last_std < QUIET_STD_RAW)
+      n /= 2;
+    else if (s_last_std > NOISY_STD_RAW)
+      n = OVERSAMPLE_MAX;
+  }
+  if (n < OVERSAMPLE_MIN)
+    n = OVERSAMPLE_MIN;
+  if (n > OVERSAMPLE_MAX)
+    n = OVERSAMPLE_MAX;
+  return n;
 }
 
 static inline int raw_to_mv(int raw) {
@@ -178,37 +307,55 @@ static esp_err_t init_adc_oneshot(void) {
 }
 
 // ──────────────────────────────────────────────────────────────────────────────
-// Collector: reads once, fills SampleStats; no logging here (Option A)
+// Collector: reads up to n times, fills SampleStats; no logging here (Option A)
+// Reads that land in an actuator blanking window are dropped; returns the
+// number of reads kept (0 → whole collection rejected, *out untouched).
 // ──────────────────────────────────────────────────────────────────────────────
-static void collect_full_sample(SampleStats *out) {
-  int buf[OVERSAMPLE_N];
+static int collect_full_sample(SampleStats *out, int req_n, int *reads_taken) {
+  int buf[OVERSAMPLE_MAX];
   int min_raw = INT_MAX, max_raw = INT_MIN;
   int64_t sum = 0;
+  int n = 0;
+
+  if (req_n < 1)
+    req_n = 1;
+  if (req_n > OVERSAMPLE_MAX)
+    req_n = OVERSAMPLE_MAX;
+  *reads_taken = 0;
 
-  for (int i = 0; i < OVERSAMPLE_N; ++i) {
+  // Collection starts inside a blanking window: don't spend ADC reads on it
+  if (in_blanking_window())
+    return 0;
+
+  for (int i = 0; i < req_n; ++i) {
     int r = 0;
     esp_err_t er = adc_oneshot_read(s_adc, ANALOG_ADC_CH, &r);
+    (*reads_taken)++;
     if (er != ESP_OK) {
       _LOG_W("adc_oneshot_read error=%d", (int)er);
       r = 0;
     }
-    buf[i] = r;
+    if (in_blanking_window())
+      continue; // an actuator switched mid-collection
+    buf[n++] = r;
     if (r < min_raw)
       min_raw = r;
     if (r > max_raw)
       max_raw = r;
     sum += r;
   }
+  if (n == 0)
+    return 0;
 
-  const float mean_raw_f = (float)sum / (float)OVERSAMPLE_N;
+  const float mean_raw_f = (float)sum / (float)n;
 
   // Exact stddev
   double acc = 0.0;
-  for (int i = 0; i < OVERSAMPLE_N; ++i) {
+  for (int i = 0; i < n; ++i) {
     const double d = (double)buf[i] - (double)mean_raw_f;
     acc += d * d;
   }
-  const float std_raw = sqrtf((float)(acc / (double)OVERSAMPLE_N));
+  const float std_raw = sqrtf((float)(acc / (double)n));
 
   // EWMA based on mean
   if (isnan(s_ewma))
@@ -216,9 +363,9 @@ static void collect_full_sample(SampleStats *out) {
   else
     s_ewma = (1.0f - EWMA_ALPHA) * s_ewma + EWMA_ALPHA * mean_raw_f;
 
-  float temp_f_linear = 0.059031f * (float)raw_to_mv(mean_raw_f) + 27.381f;
+  float temp_f_linear = analog_temp_f_from_mv(raw_to_mv(mean_raw_f));
   // Populate struct
-  out->raw_inst = buf[OVERSAMPLE_N - 1];
+  out->raw_inst = buf[n - 1];
   out->raw_min = min_raw;
   out->raw_max = max_raw;
   out->raw_mean = (int)lroundf(mean_raw_f);
@@ -227,14 +374,153 @@ static void collect_full_sample(SampleStats *out) {
   out->mv_mean = raw_to_mv(out->raw_mean);
   out->ewma = s_ewma;
   out->Rth_ohm = compute_rth_ohms_from_mv((float)out->mv_mean);
-  out->tempF=(int)(temp_f_linear + 0.5f); // round to nearest int
+  out->tempF_lin = temp_f_linear;
+  out->tempF = analog_temp_f_round(temp_f_linear); // round to nearest int
   out->tempC = ((out->tempF) - 32) * 5/9;
+  return n;
+}
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Heating-rate estimator
+// ──────────────────────────────────────────────────────────────────────────────
+// Seconds until temp reaches target at rate; 0 if already there, -1 if the
+// target is unset or not being approached.
+static int32_t project_secs(float temp_f, float rate_f_per_min, int target_f) {
+  if (target_f <= 0)
+    return -1;
+  if (temp_f >= (float)target_f)
+    return 0;
+  if (rate_f_per_min < TREND_MIN_RATE)
+    return -1;
+  return (int32_t)lroundf(((float)target_f - temp_f) / rate_f_per_min * 60.0f);
+}
+
+// Least-squares slope, window extremes and overshoot past the step's
+// max_temp, all from the window's running state.
+static void trend_fit(void) {
+  const trend_win *w = &s_window.pts;
+  analog_trend_t tr = {.secs_to_min_temp = -1, .secs_to_max_temp = -1};
+  double slope, fitted;
+
+  if (trend_win_size(w) >= TREND_MIN_POINTS &&
+      trend_win_fit(w, &slope, &fitted)) {
+    tr.valid = true;
+    tr.rate_f_per_min = (float)(slope * 60000.0); // slope is °F per ms
+    tr.fitted_temp_f = (float)fitted;
+    tr.window_s =
+        (uint32_t)((trend_win_newest_t(w) - trend_win_oldest_t(w)) / 1000);
+    tr.window_min_f = trend_win_min(w);
+    tr.window_max_f = trend_win_max(w);
+
+    const ProgramLineStruct *ln = active_line();
+    if (ln) {
+      tr.secs_to_min_temp =
+          project_secs(tr.fitted_temp_f, tr.rate_f_per_min, ln->min_temp);
+      tr.secs_to_max_temp =
+          project_secs(tr.fitted_temp_f, tr.rate_f_per_min, ln->max_temp);
+      if (ln->max_temp > 0 && tr.window_max_f > (float)ln->max_temp) {
+        tr.overshoot_f = tr.window_max_f - (float)ln->max_temp;
+      }
+    }
+  }
 
+  portENTER_CRITICAL(&s_stats_mux);
+  s_trend = tr;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+// Fold one collection into the current slot; close the slot into a window
+// point (and refit) every TREND_POINT_MS.
+static void trend_add(int64_t t_ms, float temp_f) {
+  TrendWindow *w = &s_window;
+  if (w->slot_n == 0)
+    w->slot_start_ms = t_ms;
+  w->slot_sum += temp_f;
+  w->slot_n++;
+  if ((t_ms - w->slot_start_ms) < TREND_POINT_MS)
+    return;
+
+  trend_win_push(&w->pts, w->slot_sum / (float)w->slot_n,
+                 w->slot_start_ms + (t_ms - w->slot_start_ms) / 2);
+  w->slot_sum = 0.0f;
+  w->slot_n = 0;
+
+  trend_fit();
 }
 
 // ──────────────────────────────────────────────────────────────────────────────
-// Sampler task: collects at fixed rate, logs only every _LOG_FREQ_ seconds
+// Duty-cycle accounting
+// ──────────────────────────────────────────────────────────────────────────────
+static void account_sample(analog_mode_t m, int reads, int kept,
+                           uint32_t busy_us) {
+  portENTER_CRITICAL(&s_stats_mux);
+  s_stats.per_mode[m].samples++;
+  s_stats.per_mode[m].adc_reads += (uint32_t)reads;
+  s_stats.per_mode[m].busy_us += busy_us;
+  s_stats.reads_blanked += (uint32_t)(reads - kept);
+  if (kept == 0)
+    s_stats.samples_blanked++;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+// Lateness of a collection start against its due time
+static void account_jitter(int64_t late_us) {
+  const uint32_t v = (late_us <= 0)                  ? 0
+                     : (late_us > (int64_t)UINT32_MAX) ? UINT32_MAX
+                                                       : (uint32_t)late_us;
+  portENTER_CRITICAL(&s_stats_mux);
+  latency_hist_record(&s_jitter, v);
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void account_noise(float raw_std) {
+  p2_add(&s_noise_p95, raw_std); // sampler task only
+  const float p95 = p2_value(&s_noise_p95);
+  portENTER_CRITICAL(&s_stats_mux);
+  s_stats.raw_std_p95 = p95;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void account_time(analog_mode_t m, uint32_t period_ms, int n,
+                         uint32_t dt_ms) {
+  portENTER_CRITICAL(&s_stats_mux);
+  s_stats.mode = m;
+  s_stats.period_ms = period_ms;
+  s_stats.oversample_n = n;
+  s_stats.per_mode[m].time_ms += dt_ms;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+// One line per mode: reads/s actually taken vs. the old fixed 10 Hz × 16
+static void log_duty(void) {
+  analog_sampler_stats_t st;
+  analog_get_sampler_stats(&st);
+  for (int m = 0; m < ANALOG_MODE_COUNT; ++m) {
+    const analog_mode_stats_t *p = &st.per_mode[m];
+    if (p->time_ms == 0)
+      continue;
+    const double secs = (double)p->time_ms / 1000.0;
+    const double baseline =
+        secs * (1000.0 / BASELINE_PERIOD_MS) * BASELINE_OVERSAMPLE_N;
+    const double saved =
+        baseline > 0.0 ? 100.0 * (1.0 - (double)p->adc_reads / baseline) : 0.0;
+    const double cpu = 100.0 * (double)p->busy_us / ((double)p->time_ms * 1000.0);
+    _LOG_I("ADC_DUTY {mode:%s,time_s:%.0f,samples:%u,reads:%u,reads_per_s:%.1f,"
+           "adc_saved_pct:%.1f,cpu_pct:%.2f}",
+           MODE_NAMES[m], secs, (unsigned)p->samples, (unsigned)p->adc_reads,
+           (double)p->adc_reads / secs, saved, cpu);
+  }
+
+  static latency_hist jit; // sampler task only
+  analog_get_jitter(&jit);
+  _LOG_I("ADC_JITTER {n:%u,p50_us:%u,p99_us:%u,max_us:%u,noise_p95:%.1f}",
+         (unsigned)jit.count, (unsigned)latency_hist_quantile(&jit, 0.50),
+         (unsigned)latency_hist_quantile(&jit, 0.99), (unsigned)jit.max,
+         (double)st.raw_std_p95);
+}
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Sampler task: cadence follows select_mode(), logs every _LOG_FREQ_ seconds
 // ──────────────────────────────────────────────────────────────────────────────
 static void temp_sampler_task(void *arg) {
   (void)arg;
@@ -245,52 +531,92 @@ static void temp_sampler_task(void *arg) {
   }
   s_running = true;
   s_ewma = NAN;
+  s_last_std = NAN;
+  p2_init(&s_noise_p95, 0.95);
 
   uint32_t last_log_ms = 0;
+  uint32_t last_duty_ms = now_ms();
+  analog_mode_t last_mode = ANALOG_MODE_COUNT;
+  int64_t next_due_us = 0;
 
   while (s_running) {
     const uint32_t t_loop = now_ms();
 
-    //if (!program_running()) {
-            if (false) {
-      // idle: do not collect or log; sleep a bit, clear EWMA so we don't carry
-      // stale state
-      if (!isnan(s_ewma))
-        s_ewma = NAN;
-      vTaskDelay(pdMS_TO_TICKS(250));
-    } else {
-      SampleStats st = {0};
-      collect_full_sample(&st);
-
-      // only print every _LOG_FREQ_ seconds
-      const uint32_t now = now_ms();
-      if ((now - last_log_ms) >= (_LOG_FREQ_ * 1000)) {
-        last_log_ms = now;
-
-        // Legacy line for scripts: Current ADC reading (EWMA)
-        //_LOG_I("Current ADC reading: %d", (int)lroundf(st.ewma));
-
-        // Rich structured line for detailed analysis
-ActiveStatus.CurrentTemp=st.tempF;
-        _LOG_I("ADC_SAMPLE "
-               "{raw_inst:%d,mv_inst:%d,raw_mean:%d,mv_mean:%d,raw_min:%d,raw_"
-               "max:%d,raw_std:%.1f,ewma:%.1f,atten_db:%d,bit:%d,vs_mv:%.0f,"
-               "top:%d,Rk_ohm:%.0f,Rth_ohm:%.0f,tempC:%.2f,tempF:%.2f,ReportedTemp:%d,os_n:%d}",
-               st.raw_inst, st.mv_inst, st.raw_mean, st.mv_mean, st.raw_min,
-               st.raw_max, (double)st.raw_std, (double)st.ewma,
-               (int)ANALOG_ADC_ATTEN, (int)ANALOG_BITWIDTH, (double)VSUPPLY_MV,
-               THERM_ON_TOP ? 1 : 0, (double)R_KNOWN_OHMS, (double)st.Rth_ohm,
-               (double)st.tempC, (double)st.tempF, ActiveStatus.CurrentTemp, OVERSAMPLE_N);
-
-//         _LOG_I("update_current_temp_from_adc(): mv_mean=%d → Temp=%d°F", st.mv_mean, ActiveStatus.CurrentTemp);               
-      }
+    const analog_mode_t mode = select_mode();
+    const uint32_t period_ms = mode_period_ms(mode);
+    const int64_t t_start_us = esp_timer_get_time();
+    if (next_due_us) {
+      account_jitter(t_start_us - next_due_us);
+    }
+    next_due_us = t_start_us + (int64_t)period_ms * 1000;
+    const int n = mode_oversample_n(mode);
+    if (mode != last_mode) {
+      _LOG_I("sampler mode -> %s (period=%ums, oversample<=%d)",
+             MODE_NAMES[mode], (unsigned)period_ms, n);
+      last_mode = mode;
+    }
 
-      // pacing to maintain collection cadence
+    SampleStats st = {0};
+    int reads = 0;
+    const int64_t t0_us = esp_timer_get_time();
+    const int kept = collect_full_sample(&st, n, &reads);
+    account_sample(mode, reads, kept, (uint32_t)(esp_timer_get_time() - t0_us));
+    if (kept == 0) {
+      // blanked: keep the previous CurrentTemp, retry next period
       const uint32_t elapsed = now_ms() - t_loop;
-      const uint32_t wait_ms =
-          (elapsed >= SAMPLE_PERIOD_MS) ? 1 : (SAMPLE_PERIOD_MS - elapsed);
-      vTaskDelay(pdMS_TO_TICKS(wait_ms));
+      vTaskDelay(pdMS_TO_TICKS(elapsed >= period_ms ? 1 : period_ms - elapsed));
+      account_time(mode, period_ms, n, now_ms() - t_loop);
+      continue;
+    }
+    s_last_std = st.raw_std;
+    account_noise(st.raw_std);
+
+    // Publish every sample so the thermostat sees the faster cadence
+    ActiveStatus.CurrentTemp = st.tempF;
+    trend_add(esp_timer_get_time() / 1000, st.tempF_lin);
+    temp_history_add(st.tempF_lin);
+    run_capture_sample(st.raw_mean, st.mv_mean);
+    bus_event_t ev = {.type = BUS_EV_TEMP,
+                      .temp = {.temp_f = st.tempF_lin,
+                               .temp_f_int = (int16_t)st.tempF,
+                               .mv = (int16_t)st.mv_mean}};
+    event_bus_publish(&ev);
+
+    // only print every _LOG_FREQ_ seconds
+    const uint32_t now = now_ms();
+    if ((now - last_log_ms) >= (_LOG_FREQ_ * 1000)) {
+      last_log_ms = now;
+
+      // Legacy line for scripts: Current ADC reading (EWMA)
+      //_LOG_I("Current ADC reading: %d", (int)lroundf(st.ewma));
+
+      // Rich structured line for detailed analysis
+      _LOG_I("ADC_SAMPLE "
+             "{raw_inst:%d,mv_inst:%d,raw_mean:%d,mv_mean:%d,raw_min:%d,raw_"
+             "max:%d,raw_std:%.1f,ewma:%.1f,atten_db:%d,bit:%d,vs_mv:%.0f,"
+             "top:%d,Rk_ohm:%.0f,Rth_ohm:%.0f,tempC:%.2f,tempF:%.2f,ReportedTemp:%d,os_n:%d,"
+             "mode:%s,period_ms:%u,rate_f_min:%.2f,kept:%d,reads_blanked:%u,"
+             "samples_blanked:%u}",
+             st.raw_inst, st.mv_inst, st.raw_mean, st.mv_mean, st.raw_min,
+             st.raw_max, (double)st.raw_std, (double)st.ewma,
+             (int)ANALOG_ADC_ATTEN, (int)ANALOG_BITWIDTH, (double)VSUPPLY_MV,
+             THERM_ON_TOP ? 1 : 0, (double)R_KNOWN_OHMS, (double)st.Rth_ohm,
+             (double)st.tempC, (double)st.tempF, ActiveStatus.CurrentTemp, n,
+             MODE_NAMES[mode], (unsigned)period_ms,
+             (double)s_trend.rate_f_per_min, kept,
+             (unsigned)s_stats.reads_blanked, (unsigned)s_stats.samples_blanked);
     }
+    if ((now - last_duty_ms) >= (_DUTY_LOG_FREQ_ * 1000)) {
+      last_duty_ms = now;
+      log_duty();
+    }
+
+    // pacing to maintain collection cadence
+    const uint32_t elapsed = now_ms() - t_loop;
+    const uint32_t wait_ms =
+        (elapsed >= period_ms) ? 1 : (period_ms - elapsed);
+    vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    account_time(mode, period_ms, n, now_ms() - t_loop);
   }
 
   vTaskDelete(NULL);
@@ -316,6 +642,37 @@ void _start_temp_monitor(void) {
   }
 }
 
+void analog_get_sampler_stats(analog_sampler_stats_t *out) {
+  if (!out)
+    return;
+  portENTER_CRITICAL(&s_stats_mux);
+  *out = s_stats;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+void analog_set_blanking_ms(uint32_t ms) {
+  s_blank_ms = ms;
+  _LOG_I("ADC blanking window after actuator edges: %ums", (unsigned)ms);
+}
+
+uint32_t analog_get_blanking_ms(void) { return s_blank_ms; }
+
+void analog_get_trend(analog_trend_t *out) {
+  if (!out)
+    return;
+  portENTER_CRITICAL(&s_stats_mux);
+  *out = s_trend;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
+void analog_get_jitter(latency_hist *out) {
+  if (!out)
+    return;
+  portENTER_CRITICAL(&s_stats_mux);
+  *out = s_jitter;
+  portEXIT_CRITICAL(&s_stats_mux);
+}
+
 void _stop_temp_monitor(void) {
   s_running = false;
   vTaskDelay(pdMS_TO_TICKS(20));
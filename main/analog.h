@@ -1,13 +1,61 @@
 // analog_temp_monitor.h
 #pragma once
 
+#include "histogram.h"
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Sampler cadence modes (see analog.c for period / oversample per mode). */
+typedef enum {
+  ANALOG_MODE_IDLE = 0, // no program running
+  ANALOG_MODE_ACTIVE,   // program running, no thermostat on this step
+  ANALOG_MODE_HEAT,     // heater-controlled step or near a temp threshold
+  ANALOG_MODE_COUNT
+} analog_mode_t;
+
+/** Cumulative cost of one sampler mode since boot. */
+typedef struct {
+  uint32_t samples;   // collections taken
+  uint32_t adc_reads; // adc_oneshot_read() calls
+  uint64_t busy_us;   // time spent inside collect_full_sample()
+  uint64_t time_ms;   // wall time spent in this mode
+} analog_mode_stats_t;
+
+typedef struct {
+  analog_mode_t mode;    // current mode
+  uint32_t period_ms;    // current collection period
+  int oversample_n;      // current reads per collection
+  uint32_t reads_blanked;   // reads dropped inside an actuator blanking window
+  uint32_t samples_blanked; // collections with no usable read (temp not updated)
+  float raw_std_p95;        // streaming p95 of per-collection raw_std (noise)
+  analog_mode_stats_t per_mode[ANALOG_MODE_COUNT];
+} analog_sampler_stats_t;
+
+/**
+ * Heating-rate estimate: least-squares fit of temperature against time over
+ * the last ~2 minutes, refreshed every 2 s from samples already collected.
+ * ETAs refer to the step run_program() is executing; -1 means unknown
+ * (no target, or not heating toward it), 0 means already reached.
+ */
+typedef struct {
+  bool valid;               // enough points for a fit
+  float rate_f_per_min;     // °F/min, positive while heating
+  float fitted_temp_f;      // fit evaluated at the newest point
+  uint32_t window_s;        // time span covered by the fit
+  int32_t secs_to_min_temp; // projected seconds to the step's min_temp
+  int32_t secs_to_max_temp; // projected seconds to the step's max_temp
+  float window_min_f;       // lowest point in the fit window
+  float window_max_f;       // highest point in the fit window
+  float overshoot_f;        // window_max_f above the step's max_temp, else 0
+} analog_trend_t;
+
 /**
  * Start the GPIO34 (ADC1_CH6) temperature monitor.
- * - Samples raw ADC at 10 Hz.
+ * - Samples raw ADC at 1–10 Hz depending on program phase.
  * - Maintains a 60 s rolling, recency-weighted average.
  * - Logs every 30 s: _LOG_I(TAG, "Current ADC reading: %d", avg);
  *
@@ -21,6 +69,29 @@ void _start_temp_monitor(void);
  */
 void _stop_temp_monitor(void);
 
+/**
+ * Copy the sampler's duty-cycle counters. ADC/CPU savings of a mode are
+ * adc_reads and busy_us compared with time_ms at the old fixed 10 Hz × 16.
+ */
+void analog_get_sampler_stats(analog_sampler_stats_t *out);
+
+/**
+ * Blanking window applied after every actuator edge recorded by the GPIO mask
+ * layer (g_actuator_edge_us). Reads inside the window are discarded and
+ * counted in reads_blanked / samples_blanked. 0 disables blanking.
+ */
+void analog_set_blanking_ms(uint32_t ms);
+uint32_t analog_get_blanking_ms(void);
+
+/** Copy the latest heating-rate estimate (no extra ADC reads). */
+void analog_get_trend(analog_trend_t *out);
+
+/**
+ * Copy the sampler loop jitter histogram: µs between when a collection was
+ * due (previous start + period) and when it actually started.
+ */
+void analog_get_jitter(latency_hist *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,16 @@
+// analog_convert.h — pure mV → °F conversion used by collect_full_sample()
+// and the host replay tool (tools/replay). Must not include ESP-IDF headers.
+#pragma once
+
+// Linear fit of the divider node voltage to water temperature (°F)
+#define TEMP_F_PER_MV 0.059031f
+#define TEMP_F_OFFSET 27.381f
+
+static inline float analog_temp_f_from_mv(int mv) {
+  return TEMP_F_PER_MV * (float)mv + TEMP_F_OFFSET;
+}
+
+// Value published as CurrentTemp: nearest whole °F
+static inline int analog_temp_f_round(float temp_f) {
+  return (int)(temp_f + 0.5f);
+}
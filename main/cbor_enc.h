@@ -0,0 +1,140 @@
+// cbor_enc.h — minimal CBOR (RFC 8949) encoder into a caller-owned buffer
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Only what the HTTP endpoints emit: unsigned/negative integers, text,
+   booleans, null, float32, and definite or indefinite arrays/maps. Integers
+   always use the shortest head, as deterministic encoding asks for.
+
+   Usage:
+   uint8_t buf[256];
+   cbor_enc_t e = CBOR_ENC_INIT(buf, sizeof(buf));
+   cbor_map(&e, 2);
+   cbor_uint(&e, 0); cbor_text(&e, "Normal");
+   cbor_uint(&e, 1); cbor_int(&e, -40);
+   if (!e.overflow) send(buf, e.len);
+
+   Once anything does not fit, overflow is set and later calls write nothing.
+   To stream, send buf[0..len) and cbor_reset() before encoding more. */
+
+typedef struct {
+  uint8_t *buf;
+  size_t cap;
+  size_t len;
+  bool overflow;
+} cbor_enc_t;
+
+#define CBOR_ENC_INIT(b, c) {.buf = (b), .cap = (c), .len = 0, .overflow = false}
+
+enum {
+  CBOR_MAJOR_UINT = 0,
+  CBOR_MAJOR_NINT = 1,
+  CBOR_MAJOR_TEXT = 3,
+  CBOR_MAJOR_ARRAY = 4,
+  CBOR_MAJOR_MAP = 5,
+};
+
+static inline void cbor_reset(cbor_enc_t *e) { e->len = 0; }
+
+static inline bool cbor_reserve(cbor_enc_t *e, size_t n) {
+  if (e->overflow || e->cap - e->len < n) {
+    e->overflow = true;
+    return false;
+  }
+  return true;
+}
+
+static inline void cbor_byte(cbor_enc_t *e, uint8_t b) {
+  if (cbor_reserve(e, 1)) {
+    e->buf[e->len++] = b;
+  }
+}
+
+// Initial byte plus big-endian argument in the shortest form
+static inline void cbor_head(cbor_enc_t *e, uint8_t major, uint64_t v) {
+  const uint8_t m = (uint8_t)(major << 5);
+  int n;
+  uint8_t ai; // additional info: 24..27 = 1, 2, 4, 8 argument bytes
+  if (v < 24) {
+    cbor_byte(e, (uint8_t)(m | v));
+    return;
+  } else if (v <= UINT8_MAX) {
+    n = 1;
+    ai = 24;
+  } else if (v <= UINT16_MAX) {
+    n = 2;
+    ai = 25;
+  } else if (v <= UINT32_MAX) {
+    n = 4;
+    ai = 26;
+  } else {
+    n = 8;
+    ai = 27;
+  }
+  if (!cbor_reserve(e, 1 + (size_t)n)) {
+    return;
+  }
+  e->buf[e->len++] = (uint8_t)(m | ai);
+  for (int i = n - 1; i >= 0; i--) {
+    e->buf[e->len++] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+static inline void cbor_uint(cbor_enc_t *e, uint64_t v) {
+  cbor_head(e, CBOR_MAJOR_UINT, v);
+}
+
+static inline void cbor_int(cbor_enc_t *e, int64_t v) {
+  if (v >= 0) {
+    cbor_head(e, CBOR_MAJOR_UINT, (uint64_t)v);
+  } else {
+    cbor_head(e, CBOR_MAJOR_NINT, (uint64_t)(-1 - v));
+  }
+}
+
+static inline void cbor_text_n(cbor_enc_t *e, const char *s, size_t n) {
+  cbor_head(e, CBOR_MAJOR_TEXT, n);
+  if (cbor_reserve(e, n)) {
+    memcpy(e->buf + e->len, s, n);
+    e->len += n;
+  }
+}
+
+static inline void cbor_text(cbor_enc_t *e, const char *s) {
+  cbor_text_n(e, s ? s : "", s ? strlen(s) : 0);
+}
+
+static inline void cbor_bool(cbor_enc_t *e, bool b) {
+  cbor_byte(e, b ? 0xf5 : 0xf4);
+}
+
+static inline void cbor_null(cbor_enc_t *e) { cbor_byte(e, 0xf6); }
+
+static inline void cbor_float(cbor_enc_t *e, float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  if (!cbor_reserve(e, 5)) {
+    return;
+  }
+  e->buf[e->len++] = 0xfa;
+  for (int i = 3; i >= 0; i--) {
+    e->buf[e->len++] = (uint8_t)(bits >> (8 * i));
+  }
+}
+
+static inline void cbor_array(cbor_enc_t *e, size_t n) {
+  cbor_head(e, CBOR_MAJOR_ARRAY, n);
+}
+
+static inline void cbor_map(cbor_enc_t *e, size_t pairs) {
+  cbor_head(e, CBOR_MAJOR_MAP, pairs);
+}
+
+// Indefinite-length array: items follow, cbor_break() closes it
+static inline void cbor_array_open(cbor_enc_t *e) { cbor_byte(e, 0x9f); }
+
+static inline void cbor_break(cbor_enc_t *e) { cbor_byte(e, 0xff); }
@@ -1,3 +1,4 @@
+#include "actuator.h"
 #include "analog.h"
 #include "driver/gpio.h"
 #include "esp_attr.h"
@@ -26,7 +27,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "ring_buffer.h"
+#include "event_bus.h"
+#include "run_capture.h"
+#include "step_control.h"
 #ifndef STEP_ID_FMT
 #define STEP_ID_FMT "P=%s C#=%d/%d S#=%d/%d"
 #endif
@@ -38,11 +41,79 @@ static inline void log_time_window(const char* phase, time_t start,
          phase, (long)start, (long)min_until, (long)max_until);
 }
 
-RING_BUFFER_DEFINE(prevTemp_rb, int, 16);   // type=int, capacity=16 (power-of-two → fast wrap)
-
-prevTemp_rb temps;  
 volatile status_struct ActiveStatus;
 
+volatile int64_t g_actuator_edge_us = 0;
+volatile uint32_t g_actuator_edge_count = 0;
+
+// DRAM: read from gpio_mask_note_edges(), which must not touch flash
+static const DRAM_ATTR uint64_t s_actor_bits[ACTOR_COUNT] = {
+    HEAT, SPRAY, INLET, DRAIN, SOAP};
+static const char *const s_actor_names[ACTOR_COUNT] = {"HEAT", "SPRAY",
+                                                       "INLET", "DRAIN", "SOAP"};
+static actor_usage_t s_actor_usage[ACTOR_COUNT];
+static int64_t s_actor_on_since[ACTOR_COUNT]; // valid while the bit is on
+static uint64_t s_actor_on_mask = 0;
+static portMUX_TYPE s_actor_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void IRAM_ATTR gpio_mask_note_edges(uint64_t before, uint64_t after) {
+  if (before == after) {
+    return;
+  }
+  const int64_t now = esp_timer_get_time();
+  g_actuator_edge_us = now;
+  g_actuator_edge_count++;
+
+  const uint64_t changed = (before ^ after) & ALL_ACTORS;
+  if (!changed) {
+    return;
+  }
+  portENTER_CRITICAL_SAFE(&s_actor_mux);
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    const uint64_t bit = s_actor_bits[i];
+    if (!(changed & bit)) {
+      continue;
+    }
+    if (after & bit) {
+      s_actor_usage[i].cycles++;
+      s_actor_on_since[i] = now;
+    } else if (s_actor_on_mask & bit) {
+      s_actor_usage[i].on_us += (uint64_t)(now - s_actor_on_since[i]);
+    }
+  }
+  s_actor_on_mask = after & ALL_ACTORS;
+  portEXIT_CRITICAL_SAFE(&s_actor_mux);
+}
+
+uint64_t actor_bit(actor_id_t a) {
+  return ((int)a >= 0 && a < ACTOR_COUNT) ? s_actor_bits[a] : 0;
+}
+
+const char *actor_name(actor_id_t a) {
+  return ((int)a >= 0 && a < ACTOR_COUNT) ? s_actor_names[a] : "?";
+}
+
+void actor_usage_get(actor_usage_t out[ACTOR_COUNT]) {
+  const int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_actor_mux);
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    out[i] = s_actor_usage[i];
+    if (s_actor_on_mask & s_actor_bits[i]) {
+      out[i].on_us += (uint64_t)(now - s_actor_on_since[i]);
+    }
+  }
+  portEXIT_CRITICAL(&s_actor_mux);
+}
+
+void actor_usage_add(const actor_usage_t in[ACTOR_COUNT]) {
+  portENTER_CRITICAL(&s_actor_mux);
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    s_actor_usage[i].on_us += in[i].on_us;
+    s_actor_usage[i].cycles += in[i].cycles;
+  }
+  portEXIT_CRITICAL(&s_actor_mux);
+}
+
 static bool verify_program() {
   // Basic verification: check if the program has at least one line
   for (int i = 0; i < NUM_PROGRAMS; i++) {
@@ -106,6 +177,52 @@ void prepare_programs(void) {
            current.name, (long long)min_time / MIN, (long long)max_time / MIN);
   }
 }
+// Step/program-end notification from ActiveStatus
+static void publish_step(bool running) {
+  bus_event_t ev = {.type = BUS_EV_STEP};
+  ev.step.running = running;
+  ev.step.step = (int16_t)ActiveStatus.StepIndex;
+  ev.step.steps = (int16_t)ActiveStatus.StepsTotal;
+  ev.step.cycle = (int16_t)ActiveStatus.CycleIndex;
+  ev.step.cycles = (int16_t)ActiveStatus.CyclesTotal;
+  setCharArray(ev.step.cycle_name, SAFE_STR(ActiveStatus.Cycle));
+  setCharArray(ev.step.step_name, SAFE_STR(ActiveStatus.Step));
+  event_bus_publish(&ev);
+}
+
+// Sleep until the controller tick at *next_tick, or earlier when something
+// the line reacts to arrives: any dispatched action (e.g. skip) or, on a
+// thermostat line, a change of the published temperature. Returns true when
+// the tick is due (and advances *next_tick). tools/replay mirrors this.
+static bool wait_step_event(int sub, TickType_t *next_tick, bool temp_matters,
+                            int last_temp) {
+  for (;;) {
+    const TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*next_tick - now) <= 0) {
+      *next_tick += pdMS_TO_TICKS(STEP_CTL_TICK_MS);
+      if ((int32_t)(*next_tick - now) <= 0) {
+        *next_tick = now + pdMS_TO_TICKS(STEP_CTL_TICK_MS); // fell behind
+      }
+      return true;
+    }
+    bus_event_t ev;
+    if (sub < 0) {
+      vTaskDelay(*next_tick - now); // no bus slot: plain polling
+      continue;
+    }
+    if (!event_bus_receive(sub, &ev, *next_tick - now)) {
+      continue;
+    }
+    if (ev.type == BUS_EV_ACTION) {
+      return false;
+    }
+    if (ev.type == BUS_EV_TEMP && temp_matters &&
+        ev.temp.temp_f_int != last_temp) {
+      return false;
+    }
+  }
+}
+
 void run_program(void *pvParameters) {
   (void)pvParameters;
 
@@ -117,7 +234,6 @@ void run_program(void *pvParameters) {
     _LOG_E("Invalid program selected: %s", ActiveStatus.Program);
     setCharArray(ActiveStatus.Program, "INVALID");
     esp_log_level_set(TAG, ESP_LOG_INFO);
-    vTaskDelete(NULL);
     return;
   }
 
@@ -130,7 +246,20 @@ void run_program(void *pvParameters) {
   ActiveStatus.StepsTotal      = (int32_t)P->num_lines;
   ActiveStatus.CycleIndex      = 0;
   ActiveStatus.StepIndex       = 0;
-  gpio_mask_config_outputs(ALL_ACTORS);
+  ActiveStatus.SoapHasDispensed = false;
+  ActiveStatus.CancelRequested = false;
+  run_capture_begin(P->name, ActiveStatus.time_full_start);
+
+  // Kept across runs: a program force-deleted after a cancel timeout cannot
+  // unsubscribe, so the next run picks the slot up again
+  static int s_bus_sub = -1;
+  if (s_bus_sub < 0) {
+    s_bus_sub = event_bus_subscribe(
+        "run_program", BUS_EV_BIT(BUS_EV_TEMP) | BUS_EV_BIT(BUS_EV_ACTION));
+  }
+  bus_event_t stale;
+  while (event_bus_receive(s_bus_sub, &stale, 0)) {
+  }
 
   _LOG_D("Program start: %s (cycles=%d steps=%d est_max=%lld)",
          SAFE_STR(ActiveStatus.Program),
@@ -160,39 +289,35 @@ void run_program(void *pvParameters) {
 
     // Reset per-line state
     ActiveStatus.SkipStep        = false;                    // (#5)
-    ActiveStatus.HEAT_REACHED    = false;
-    ActiveStatus.HEAT_REQUESTED  = ((Line->gpio_mask & HEAT) != 0);
-    if (Line->gpio_mask & SOAP) {
+    if ((Line->gpio_mask | Line->pulse_mask) & SOAP) {
       ActiveStatus.SoapHasDispensed = true;
     }
 
     // Effective actor mask (heat handled separately by thermostat)
     uint64_t actor_mask = (Line->gpio_mask & ALL_ACTORS) & ~HEAT;
-    gpio_mask_clear(HEAT | SPRAY | INLET | DRAIN | SOAP);
-    vTaskDelay(pdMS_TO_TICKS(100));
 
-    // Base/at-temp constraints
-    int base_min = (Line->min_time > 0) ? (int)Line->min_time : 0;
-    int base_max = (Line->max_time > 0) ? (int)Line->max_time : base_min; // fallback
-    int at_min   = (Line->min_time_at_temp > 0) ? (int)Line->min_time_at_temp : 0;
-    int at_max   = (Line->max_time_at_temp > 0) ? (int)Line->max_time_at_temp : 0;
+    const time_t line_start = get_unix_epoch();
+    ActiveStatus.LastTransitionMs = line_start;
+
+    // Decisions live in step_control.c so tools/replay runs the same code
+    step_ctl_t ctl;
+    step_ctl_begin(&ctl, Line, line_start);
+    ActiveStatus.HEAT_REACHED    = false;
+    ActiveStatus.HEAT_REQUESTED  = ctl.heat_requested;
 
     // (#3) Log constraints (only if relevant)
-    if (at_max > 0 && base_min > 0 && at_max < base_min) {
-      _LOG_W("Constraint: max_time_at_temp (%d) < min_time (%d).", at_max, base_min);
+    if (ctl.at_max > 0 && ctl.base_min > 0 && ctl.at_max < ctl.base_min) {
+      _LOG_W("Constraint: max_time_at_temp (%d) < min_time (%d).", ctl.at_max,
+             ctl.base_min);
     }
 
-    const time_t line_start = get_unix_epoch();
-    ActiveStatus.LastTransitionMs = line_start;
-
     // Derived flags for this line (#6)
-    bool has_temp_targets = (Line->min_temp > 0) || (Line->max_temp > 0);
     _LOG_D("Step %d/%d: %s %s  HEAT_REQ=%d has_temp=%d "
            "(min=%d max=%d min_at=%d max_at=%d) actor_mask=0x%llx",
            ActiveStatus.StepIndex, ActiveStatus.StepsTotal,
            SAFE_STR(Line->name_cycle), SAFE_STR(Line->name_step),
-           (int)ActiveStatus.HEAT_REQUESTED, (int)has_temp_targets,
-           Line->min_time, Line->max_time, at_min, at_max,
+           (int)ActiveStatus.HEAT_REQUESTED, (int)ctl.has_temp_targets,
+           Line->min_time, Line->max_time, ctl.at_min, ctl.at_max,
            (unsigned long long)actor_mask);
 
     // (#9) Precompute step identity for greppability
@@ -200,178 +325,154 @@ void run_program(void *pvParameters) {
     int cIdx = ActiveStatus.CycleIndex, cTot = ActiveStatus.CyclesTotal;
     int sIdx = ActiveStatus.StepIndex,  sTot = ActiveStatus.StepsTotal;
 
-    // Thermostat/hysteresis
-    bool  heat_on = false;
-    const int maxT     = (Line->max_temp > 0) ? Line->max_temp : 0;
-    const int band_low = (maxT > 0) ? (maxT - 3) : 0;
-    bool  over_max_warned = false; // (#8) only warn once per line until cooled below band
-
-    // At-temp tracking
-    bool   at_temp_started = false;
-    time_t at_temp_t0      = 0;
-    int    original_remaining_at_hit = 0;
-    time_t at_temp_elapsed = 0; // (#4) report at end
-
-    // Base time window
-    time_t must_not_end_before = line_start + base_min;
-    time_t must_end_by         = line_start + base_max;
-    log_time_window("base", line_start, must_not_end_before, must_end_by); // (#3,#7)
-
-    // Assert non-heat actors
-    gpio_mask_set(actor_mask);
+    log_time_window("base", line_start, ctl.must_not_end_before,
+                    ctl.must_end_by); // (#3,#7)
+    run_capture_decision(line_start, sIdx, "BEGIN", NULL);
+
+    // Step transition: previous line's actors (and HEAT) to this line's
+    // actors in one register write, no all-off gap in between
+    actuator_apply(ALL_ACTORS, actor_mask);
+    publish_step(true);
+    if (Line->pulse_mask && Line->pulse_ms) {
+      // Timed off by the actuator; the refresh below leaves these bits alone
+      actuator_pulse(Line->pulse_mask & ~actor_mask, Line->pulse_ms);
+      _LOG_D("Pulse 0x%llx for %lu ms. " STEP_ID_FMT,
+             (unsigned long long)Line->pulse_mask,
+             (unsigned long)Line->pulse_ms, pName, cIdx, cTot, sIdx, sTot);
+    }
 
     // ---- per-line loop ----
+    TickType_t next_tick =
+        xTaskGetTickCount() + pdMS_TO_TICKS(STEP_CTL_TICK_MS);
+    bool on_tick = true; // the first pass logs like a tick
     while (true) {
-      if (ActiveStatus.SkipStep) {
+      const time_t now = get_unix_epoch();
+      const int temp = ActiveStatus.CurrentTemp;
+      if (ActiveStatus.CancelRequested) {
+        _LOG_W("Cancel requested; ending the run. " STEP_ID_FMT,
+               pName, cIdx, cTot, sIdx, sTot);
+        break;
+      }
+      const step_ctl_result_t r =
+          step_ctl_tick(&ctl, temp, now, ActiveStatus.SkipStep);
+
+      if (r.end == STEP_END_SKIPPED) {
         ActiveStatus.SkipStep = false;
         _LOG_W("Skipping step on request. " STEP_ID_FMT,
                pName, cIdx, cTot, sIdx, sTot);               // (#5,#9)
         _LOG_D("SkipStep cleared; advancing to next line. " STEP_ID_FMT,
                pName, cIdx, cTot, sIdx, sTot);               // (#5,#9)
+        run_capture_decision(now, sIdx, "END", step_end_name(r.end));
         break;
       }
 
-      if (has_temp_targets) {
-        // Mark the first time we reach min_temp
-        if (!ActiveStatus.HEAT_REACHED && Line->min_temp > 0 &&
-            ActiveStatus.CurrentTemp >= Line->min_temp) {
-          ActiveStatus.HEAT_REACHED = true;
-          _LOG_D("Min temp reached: %dF (threshold=%dF). " STEP_ID_FMT,
-                 ActiveStatus.CurrentTemp, Line->min_temp,
-                 pName, cIdx, cTot, sIdx, sTot);             // (#6,#9)
-        }
-
-        // When we FIRST reach >= min_temp, clamp windows to at-temp spec
-        if (!at_temp_started && Line->min_temp > 0 &&
-            ActiveStatus.CurrentTemp >= Line->min_temp) {
-          at_temp_started = true;
-          at_temp_t0 = get_unix_epoch();
-
-          int elapsed = (int)(at_temp_t0 - line_start);
-          original_remaining_at_hit = (base_max > 0) ? (base_max - elapsed) : 0;
-
-          time_t new_min_end = at_temp_t0 + (at_min > 0 ? at_min : 0);
-          time_t new_max_end = at_temp_t0 + (at_max > 0 ? at_max : 0);
-
-          if (at_min > 0 && base_max > 0 &&
-              (at_temp_t0 + at_min) > (line_start + base_max)) {
-            _LOG_W("min_time_at_temp (%d) extends past original max_time (%d).",
-                   at_min, base_max);                         // (#3)
-          }
-
-          if (at_min > 0 && new_min_end > must_not_end_before) {
-            must_not_end_before = new_min_end;
-          }
-          if (at_max > 0) {
-            must_end_by = new_max_end;
-          }
-
-          int adjusted_remaining = (int)(must_not_end_before - at_temp_t0);
-          if (adjusted_remaining < 0) adjusted_remaining = 0;
-
-          _LOG_I("At-temp start @ %ld: original_remaining=%d sec, adjusted_min_remaining=%d sec. "
-                 STEP_ID_FMT,
-                 (long)at_temp_t0, original_remaining_at_hit, adjusted_remaining,
-                 pName, cIdx, cTot, sIdx, sTot);
-          log_time_window("at-temp", at_temp_t0, must_not_end_before, must_end_by); // (#3,#7)
-        }
-
-        // Track at-temp elapsed for end-of-step report (#4)
-        if (at_temp_started) {
-          at_temp_elapsed = get_unix_epoch() - at_temp_t0;
-        }
-
-        // Over-max warning once per line until cooled below hysteresis band (#8)
-        if (maxT > 0) {
-          if (!over_max_warned && ActiveStatus.CurrentTemp > maxT) {
-            _LOG_W("Max temp EXCEEDED: %s C=%s S=%s max=%dF now=%dF. " STEP_ID_FMT,
-                   SAFE_STR(ActiveStatus.Program),
-                   SAFE_STR(ActiveStatus.Cycle),
-                   SAFE_STR(ActiveStatus.Step),
-                   maxT, ActiveStatus.CurrentTemp,
-                   pName, cIdx, cTot, sIdx, sTot);
-            over_max_warned = true;
-          } else if (over_max_warned && ActiveStatus.CurrentTemp <= band_low) {
-            // cooled sufficiently; allow a future warning if it spikes again
-            over_max_warned = false;
-            _LOG_D("Over-max guard reset after cooling (<=%dF). " STEP_ID_FMT,
-                   band_low, pName, cIdx, cTot, sIdx, sTot);
-          }
+      if (r.events & STEP_EV_MIN_TEMP_REACHED) {
+        ActiveStatus.HEAT_REACHED = true;
+        _LOG_D("Min temp reached: %dF (threshold=%dF). " STEP_ID_FMT,
+               temp, Line->min_temp,
+               pName, cIdx, cTot, sIdx, sTot);               // (#6,#9)
+      }
+      if (r.events & STEP_EV_AT_MIN_PAST_MAX) {
+        _LOG_W("min_time_at_temp (%d) extends past original max_time (%d).",
+               ctl.at_min, ctl.base_max);                    // (#3)
+      }
+      if (r.events & STEP_EV_AT_TEMP_STARTED) {
+        _LOG_I("At-temp start @ %ld: original_remaining=%d sec, adjusted_min_remaining=%d sec. "
+               STEP_ID_FMT,
+               (long)ctl.at_temp_t0, ctl.original_remaining_at_hit,
+               ctl.adjusted_remaining, pName, cIdx, cTot, sIdx, sTot);
+        log_time_window("at-temp", ctl.at_temp_t0, ctl.must_not_end_before,
+                        ctl.must_end_by); // (#3,#7)
+      }
+      if (r.events & STEP_EV_OVER_MAX) {
+        _LOG_W("Max temp EXCEEDED: %s C=%s S=%s max=%dF now=%dF. " STEP_ID_FMT,
+               SAFE_STR(ActiveStatus.Program),
+               SAFE_STR(ActiveStatus.Cycle),
+               SAFE_STR(ActiveStatus.Step),
+               ctl.max_t, temp,
+               pName, cIdx, cTot, sIdx, sTot);
+      }
+      if (r.events & STEP_EV_OVER_MAX_RESET) {
+        // cooled sufficiently; allow a future warning if it spikes again
+        _LOG_D("Over-max guard reset after cooling (<=%dF). " STEP_ID_FMT,
+               ctl.band_low, pName, cIdx, cTot, sIdx, sTot);
+      }
+      if (r.events & STEP_EV_HEAT_RESUMED) {
+        actuator_set(HEAT);
+        _LOG_I("HEAT RESUMED (max=%dF band_low=%dF now=%dF). " STEP_ID_FMT,
+               ctl.max_t, ctl.band_low, temp,
+               pName, cIdx, cTot, sIdx, sTot);
+        run_capture_decision(now, sIdx, "HEAT_ON", NULL);
+      } else if (r.events & STEP_EV_HEAT_PAUSED) {
+        actuator_clear(HEAT);
+        if (ctl.has_temp_targets) {
+          _LOG_I("HEAT PAUSED (max=%dF now=%dF). " STEP_ID_FMT,
+                 ctl.max_t, temp, pName, cIdx, cTot, sIdx, sTot);
         }
+        run_capture_decision(now, sIdx, "HEAT_OFF", NULL);
+      }
 
-        // Hysteresis thermostat around max_temp
-        if (maxT > 0) {
-          bool desired_heat = false;
-          if (ActiveStatus.HEAT_REQUESTED) {
-            if (!heat_on) {
-              if (ActiveStatus.CurrentTemp <= band_low) desired_heat = true;
-            } else {
-              desired_heat = (ActiveStatus.CurrentTemp < maxT);
-            }
-          }
-
-          if (desired_heat && !heat_on) {
-            gpio_mask_set(HEAT);
-            heat_on = true;
-            _LOG_I("HEAT RESUMED (max=%dF band_low=%dF now=%dF). " STEP_ID_FMT,
-                   maxT, band_low, ActiveStatus.CurrentTemp,
-                   pName, cIdx, cTot, sIdx, sTot);
-          } else if (!desired_heat && heat_on) {
-            gpio_mask_clear(HEAT);
-            heat_on = false;
-            _LOG_I("HEAT PAUSED (max=%dF now=%dF). " STEP_ID_FMT,
-                   maxT, ActiveStatus.CurrentTemp,
-                   pName, cIdx, cTot, sIdx, sTot);
+      // Refresh and progress logs on the tick only; event wake-ups just
+      // decide
+      if (on_tick) {
+        // Keep non-HEAT actors asserted (refresh; no write if unchanged)
+        actuator_set(actor_mask);
+
+        // Progress log (retain concise I; Ds elsewhere)
+        _LOG_I("%8s->%8s:%8s elapsed=%ld sec\tTargettime=%d sec",
+               SAFE_STR(ActiveStatus.Program),
+               SAFE_STR(Line->name_cycle),
+               SAFE_STR(Line->name_step),
+               (long)(get_unix_epoch() - line_start),
+               (long)(ctl.base_max))  ;
+        if (ctl.has_temp_targets) {
+          analog_trend_t tr;
+          analog_get_trend(&tr);
+          if (tr.valid) {
+            _LOG_D("Heating rate %.2fF/min, eta min_temp=%lds max_temp=%lds. "
+                   STEP_ID_FMT,
+                   (double)tr.rate_f_per_min, (long)tr.secs_to_min_temp,
+                   (long)tr.secs_to_max_temp, pName, cIdx, cTot, sIdx, sTot);
           }
         }
-      } else {
-        // No temperature targets: force HEAT off
-        if (heat_on) { gpio_mask_clear(HEAT); heat_on = false; }
       }
 
-      // Keep non-HEAT actors asserted (refresh)
-      gpio_mask_set(actor_mask);
-
-      // Progress log (retain concise I; Ds elsewhere)
-      _LOG_I("%8s->%8s:%8s elapsed=%ld sec\tTargettime=%d sec",
-             SAFE_STR(ActiveStatus.Program),
-             SAFE_STR(Line->name_cycle),
-             SAFE_STR(Line->name_step),
-             (long)(get_unix_epoch() - line_start),
-             (long)(base_max))  ;
-
       // Exit conditions
-      time_t now = get_unix_epoch();
-      bool min_satisfied = (now >= must_not_end_before);
-      bool max_reached   = (must_end_by > 0 && now >= must_end_by);
-
-      if ((max_reached && min_satisfied) ||
-          // if an explicit at_max was set, hitting it ends the step even if min not yet met
-          (max_reached && (at_max > 0))) {
+      if (r.end != STEP_END_NONE) {
         // (#4) reasoned step end
-        const char* reason =
-          (ActiveStatus.SkipStep) ? "skipped" :
-          (max_reached && (at_max > 0)) ? "max_at_reached" :
-          (max_reached && min_satisfied) ? "min_and_max_reached" :
-          "completed";
         _LOG_D("Step end: reason=%s elapsed=%lds at_temp_elapsed=%lds. " STEP_ID_FMT,
-               reason, (long)(now - line_start), (long)at_temp_elapsed,
+               step_end_name(r.end), (long)(now - line_start),
+               (long)ctl.at_temp_elapsed,
                pName, cIdx, cTot, sIdx, sTot);
+        run_capture_decision(now, sIdx, "END", step_end_name(r.end));
         break;
       }
 
-      vTaskDelay(pdMS_TO_TICKS(5000));
+      on_tick = wait_step_event(s_bus_sub, &next_tick, ctl.has_temp_targets,
+                                temp);
     } // end per-line loop
 
-    // Ensure HEAT off between lines
-    if (heat_on) { gpio_mask_clear(HEAT); heat_on = false; }
-    // Drop non-heat actors at the end of the line
-    gpio_mask_clear(actor_mask);
+    // HEAT and this line's actors are switched by the next line's
+    // transition (or below, after the last line)
+    ctl.heat_on = false;
+    if (ActiveStatus.CancelRequested) {
+      break;
+    }
   }
+  actuator_clear(ALL_ACTORS);
+  publish_step(false);
 
   _LOG_D("Program complete: %s", SAFE_STR(ActiveStatus.Program));
+  run_capture_end();
   esp_log_level_set(TAG, ESP_LOG_INFO); // (#10) restore normal verbosity
-  vTaskDelete(NULL);
+}
+
+void run_program_abandoned(void) {
+  actuator_clear(ALL_ACTORS);
+  publish_step(false);
+  _LOG_W("Program abandoned: %s", SAFE_STR(ActiveStatus.Program));
+  run_capture_end();
+  esp_log_level_set(TAG, ESP_LOG_INFO);
 }
 
 void reset_active_status(void) {
@@ -29,6 +29,7 @@
 #include "freertos/task.h"
 #include "http_utils.h"
 #include "io.h"
+#include "program_defs.h"
 #include "nvs_flash.h"
 #include "soc/gpio_reg.h"
 #include "soc/gpio_struct.h"
@@ -60,8 +61,14 @@
     (dest)[sizeof(dest) - 1] = '\0';                                           \
   } while (0)
 
+// Runs ActiveStatus.Program to its end, or until CancelRequested, then
+// returns; the caller's task deletes itself
 void run_program(void *pvParameters);
 
+// Finish a run whose task was deleted from outside (cancel timeout): actors
+// off, the end-of-run STEP event, capture closed, as run_program() would
+void run_program_abandoned(void);
+
 void prepare_programs();
 
 static inline void log_uptime_hms(void) {
@@ -84,200 +91,41 @@ static inline void gpio_mask_config_outputs(uint64_t mask) {
                       .intr_type = GPIO_INTR_DISABLE};
   gpio_config(&io);
 }
-// Set HIGH for all pins in mask
-static inline void IRAM_ATTR gpio_mask_set(uint64_t mask) {
-  uint32_t lo = (uint32_t)mask;
-  uint32_t hi = (uint32_t)(mask >> 32);
-  if (lo)
-    REG_WRITE(GPIO_OUT_W1TS_REG, lo);
-  if (hi)
-    REG_WRITE(GPIO_OUT1_W1TS_REG, hi);
-}
-// Set LOW for all pins in mask
-static inline void IRAM_ATTR gpio_mask_clear(uint64_t mask) {
-  uint32_t lo = (uint32_t)mask;
-  uint32_t hi = (uint32_t)(mask >> 32);
-  if (lo)
-    REG_WRITE(GPIO_OUT_W1TC_REG, lo);
-  if (hi)
-    REG_WRITE(GPIO_OUT1_W1TC_REG, hi);
-}
-// Write level to all pins in mask (level: 0/1)
-static inline void IRAM_ATTR gpio_mask_write(uint64_t mask, bool level) {
-  if (level)
-    gpio_mask_set(mask);
-  else
-    gpio_mask_clear(mask);
-}
-// Toggle all pins in mask
-static inline void IRAM_ATTR gpio_mask_toggle(uint64_t mask) {
-  uint32_t lo = (uint32_t)mask;
-  uint32_t hi = (uint32_t)(mask >> 32);
+// Actuator edge bookkeeping (dishwasher_programs.c). Updated only when an
+// output actually changes level; the ADC sampler blanks readings for a short
+// window after each edge to keep relay/pump switching noise out of temps.
+extern volatile int64_t g_actuator_edge_us;    // esp_timer time of last edge
+extern volatile uint32_t g_actuator_edge_count; // edges since boot
+void gpio_mask_note_edges(uint64_t before, uint64_t after);
+
+// Per-actor usage, kept by the same hook: switch-on count and energized time
+// for each relay, so heater duty and relay wear can be read back. Changes to
+// pins outside ALL_ACTORS are ignored.
+typedef enum {
+  ACTOR_HEAT = 0,
+  ACTOR_SPRAY,
+  ACTOR_INLET,
+  ACTOR_DRAIN,
+  ACTOR_SOAP,
+  ACTOR_COUNT
+} actor_id_t;
 
-  if (lo) {
-    uint32_t out_lo = GPIO.out; // current low 32 bits
-    REG_WRITE(GPIO_OUT_W1TS_REG, (~out_lo) & lo);
-    REG_WRITE(GPIO_OUT_W1TC_REG, (out_lo)&lo);
-  }
-  if (hi) {
-    uint32_t out_hi = GPIO.out1.val; // current high 32 bits
-    REG_WRITE(GPIO_OUT1_W1TS_REG, (~out_hi) & hi);
-    REG_WRITE(GPIO_OUT1_W1TC_REG, (out_hi)&hi);
-  }
-}
-
-#ifndef BIT64
-#define BIT64(n) (1ULL << (n))
-#endif
+typedef struct {
+  uint64_t on_us;  // total time energized
+  uint32_t cycles; // off -> on transitions
+} actor_usage_t;
 
-#define HEAT (BIT64(GPIO_NUM_32))
-#define SPRAY (BIT64(GPIO_NUM_33))
-#define INLET (BIT64(GPIO_NUM_25))
-#define DRAIN (BIT64(GPIO_NUM_26))
-#define SOAP (BIT64(GPIO_NUM_27))
+uint64_t actor_bit(actor_id_t a);     // HEAT, SPRAY, ... (0 if out of range)
+const char *actor_name(actor_id_t a); // "HEAT", "SPRAY", ...
+// Snapshot of all actors; an actor that is on includes its current on-period
+void actor_usage_get(actor_usage_t out[ACTOR_COUNT]);
+// Add totals carried over from a previous boot (see actuator_usage_load())
+void actor_usage_add(const actor_usage_t in[ACTOR_COUNT]);
 
 #define NUM_LEDS 8
-static const uint64_t ALL_ACTORS = HEAT | SPRAY | INLET | DRAIN | SOAP;
-#define NUM_PROGRAMS 4
-
-#define SEC (1) // 1 second is one second
-#define MIN (60)   // 60 seconds in one minute
 #define SAFE_STR(p) ((p) ? (p) : "")
 #define NUM_DEVICES 8
 
-
-
-typedef struct {
-  char *name_cycle;
-  char *name_step;
-  uint32_t min_time;
-  uint32_t max_time;
-  int min_temp;
-  int max_temp;
-  uint64_t gpio_mask; // BIT64 mask for all pins to set HIGH
-  uint32_t min_time_at_temp; // NEW: apply only when min/max temp specified (else 0)
-  uint32_t max_time_at_temp; // NEW: apply only when min/max temp specified (else 0)
-} ProgramLineStruct;
-
-
-typedef struct {
-  const char *name;
-  const ProgramLineStruct *lines;
-  size_t num_lines;
-  int64_t min_time;
-  int64_t max_time;
-  int num_cycles;  
-} Program_Entry;
-
-// Normal program
-
-static const ProgramLineStruct NormalProgramLines[] = {
-    {"init",   "setup", 1,           0,          0,   0,   0,                       0,        0},
-
-    {"Prep",   "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"Prep",   "Spray", 5 * MIN,     0,          0,   0,   SPRAY,                   0,        0},
-    {"Prep",   "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"wash",   "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"wash",   "Warm",  5 * MIN, 40 * MIN,      130, 140,  HEAT | SPRAY,           10*MIN,   20*MIN},
-    {"wash",   "soap",  1 * MIN,     0,         140, 150,  HEAT | SPRAY | SOAP,     5*MIN,   10*MIN},
-    {"wash",   "wash", 45 * MIN, 75 * MIN,     150, 150,  HEAT | SPRAY,            20*MIN,   30*MIN},
-    {"wash",   "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse1", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse1", "rinse", 5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse1", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse2", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse2", "rinse", 5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse2", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse3", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse3", "soap",  1 * MIN,     0,         140, 140,  HEAT | DRAIN | SOAP,     5*MIN,   10*MIN},
-    {"rinse3", "rinse",10 * MIN, 20 * MIN,     140, 140,  HEAT | SPRAY,            10*MIN,   20*MIN},
-    {"rinse3", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"cool",   "vent", 29 * MIN,     0,          0,   0,   HEAT,                    0,        0},
-    {"fini",   "clean", 0,           0,          0,   0,   0,                       0,        0}
-};
-
-
-static const ProgramLineStruct TesterProgramLines[] = {
-    {"init",   "setup",   1,           0,          0,   0,   0,                       0,        0},
-
-    {"Prep",   "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
-    {"Prep",   "Spray",  30 * SEC, 30 * SEC,     130, 130,  SPRAY,                    5*MIN,   10*MIN},
-    {"Prep",   "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"wash",   "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
-    {"wash",   "Warm",    0,        30 * SEC,    130, 130,  HEAT | SPRAY,             5*MIN,   10*MIN},
-    {"wash",   "soap",   30 * SEC,     0,         140, 140,  HEAT | SPRAY | SOAP,     5*MIN,   10*MIN},
-    {"wash",   "wash",   30 * SEC, 30 * SEC,     152, 152,  HEAT | SPRAY,            10*MIN,   15*MIN},
-    {"wash",   "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse1", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse1", "rinse",  30 * SEC,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse1", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse2", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse2", "rinse",  30 * SEC,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse2", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse3", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse3", "soap",   30 * SEC,     0,         140, 140,  HEAT | DRAIN | SOAP,     5*MIN,   10*MIN},
-    {"rinse3", "rinse",  30 * SEC, 30 * SEC,     140, 140,  HEAT | SPRAY,             5*MIN,   10*MIN},
-
-    {"rinse3", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-    {"cool",   "vent",   29 * MIN,     0,          0,   0,   HEAT,                    0,        0},
-    {"fini",   "clean",   0,           0,          0,   0,   0,                       0,        0}
-};
-
-static const ProgramLineStruct HiTempProgramLines[] = {
-    {"init",   "setup",  1,           0,          0,   0,   0,                       0,        0},
-
-    {"Prep",   "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"Prep",   "Spray",  5 * MIN,     0,          0,   0,   SPRAY,                   0,        0},
-    {"Prep",   "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"wash",   "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"wash",   "Warm",   0,       40 * MIN,     160, 160,  HEAT | SPRAY,            10*MIN,   20*MIN},
-    {"wash",   "soap",   1 * MIN,     0,         160, 160,  HEAT | SPRAY | SOAP,     5*MIN,   10*MIN},
-    {"wash",   "wash",  45 * MIN, 75 * MIN,     160, 160,  HEAT | SPRAY,            20*MIN,   30*MIN},
-    {"wash",   "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse1", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse1", "rinse",  5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse1", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse2", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse2", "rinse",  5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
-    {"rinse2", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"rinse3", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
-    {"rinse3", "soap",   1 * MIN,     0,         160, 160,  HEAT | DRAIN | SOAP,     5*MIN,   10*MIN},
-    {"rinse3", "rinse", 10 * MIN, 20 * MIN,     160, 160,  HEAT | SPRAY,            10*MIN,   20*MIN},
-    {"rinse3", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
-
-    {"cool",   "vent",  29 * MIN,     0,         140, 140,  HEAT,                    10*MIN,   20*MIN},
-    {"fini",   "clean",  0,           0,          0,   0,   0,                       0,        0}
-};
-
-
-static const ProgramLineStruct CancelProgramLines[] = {
-    {"Cancel", "drain", 2 * MIN, 0, 0, 0, DRAIN, 0, 0},
-    {"fini",   "clean", 0,       0, 0, 0, 0,     0, 0}
-};
-
-
-static Program_Entry Programs[NUM_PROGRAMS] = {
-    {"Tester", TesterProgramLines,
-     sizeof(TesterProgramLines) / sizeof(TesterProgramLines[0]),0},
-    {"Normal", NormalProgramLines,
-     sizeof(NormalProgramLines) / sizeof(NormalProgramLines[0]),0},
-    {"HiTemp", HiTempProgramLines,
-     sizeof(HiTempProgramLines) / sizeof(HiTempProgramLines[0]),0},
-    {"Cancel", CancelProgramLines,
-     sizeof(CancelProgramLines) / sizeof(CancelProgramLines[0]),0}};
 #define setCharArray(target, value)                                            \
   do {                                                                         \
     strncpy((target), (value), sizeof(target) - 1);                            \
@@ -339,6 +187,7 @@ typedef struct {
   int64_t time_elapsed;
   int64_t time_start;
   bool SkipStep;
+  bool CancelRequested; // run_program() ends the run at its next wake-up
   char Cycle[10];
   char Step[10];
   char IPAddress[16];     // OPTIMIZATION: Fixed size for IP
@@ -0,0 +1,146 @@
+// event_bus.c — in-process publish/subscribe; see event_bus.h
+// - Slots and their queues are static and never freed, so a publisher that
+//   raced an unsubscribe only writes into an idle queue (reset on reuse)
+// - Publish copies the type masks under a spinlock, then sends outside it
+
+#include "event_bus.h"
+
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+
+typedef struct {
+  const char *name;
+  uint32_t types; // 0 = free
+  QueueHandle_t q;
+  uint32_t delivered;
+  uint32_t dropped;
+} bus_sub_t;
+
+static bus_sub_t s_subs[EVENT_BUS_MAX_SUBS];
+static StaticQueue_t s_qbuf[EVENT_BUS_MAX_SUBS];
+static uint8_t s_qstore[EVENT_BUS_MAX_SUBS]
+                       [EVENT_BUS_DEPTH * sizeof(bus_event_t)];
+static uint32_t s_seq = 0;
+static uint32_t s_dropped_total = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline bool valid(int sub) {
+  return sub >= 0 && sub < EVENT_BUS_MAX_SUBS;
+}
+
+int event_bus_subscribe(const char *name, uint32_t types) {
+  types &= BUS_EV_ALL;
+  if (!types) {
+    return -1;
+  }
+  int slot = -1;
+  portENTER_CRITICAL(&s_mux);
+  for (int i = 0; i < EVENT_BUS_MAX_SUBS; i++) {
+    // A claimed slot without a queue yet is still being set up below
+    if (s_subs[i].types == 0 && s_subs[i].name == NULL) {
+      s_subs[i].name = name ? name : "?";
+      slot = i;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (slot < 0) {
+    _LOG_E("event bus: no free slot for '%s'", name ? name : "?");
+    return -1;
+  }
+
+  bus_sub_t *s = &s_subs[slot];
+  if (!s->q) {
+    s->q = xQueueCreateStatic(EVENT_BUS_DEPTH, sizeof(bus_event_t),
+                              s_qstore[slot], &s_qbuf[slot]);
+  } else {
+    xQueueReset(s->q);
+  }
+  portENTER_CRITICAL(&s_mux);
+  s->delivered = 0;
+  s->dropped = 0;
+  s->types = types; // live from here on
+  portEXIT_CRITICAL(&s_mux);
+  _LOG_I("event bus: '%s' subscribed (slot %d, types 0x%02lx)", s->name,
+         slot, (unsigned long)types);
+  return slot;
+}
+
+void event_bus_unsubscribe(int sub) {
+  if (!valid(sub)) {
+    return;
+  }
+  portENTER_CRITICAL(&s_mux);
+  s_subs[sub].types = 0;
+  s_subs[sub].name = NULL;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool event_bus_receive(int sub, bus_event_t *ev, TickType_t wait) {
+  if (!valid(sub) || !s_subs[sub].q || !ev) {
+    return false;
+  }
+  return xQueueReceive(s_subs[sub].q, ev, wait) == pdTRUE;
+}
+
+void event_bus_publish(bus_event_t *ev) {
+  if (!ev || ev->type >= BUS_EV_TYPE_COUNT) {
+    return;
+  }
+  const uint32_t bit = BUS_EV_BIT(ev->type);
+  uint32_t targets = 0;
+  portENTER_CRITICAL(&s_mux);
+  ev->seq = ++s_seq;
+  for (int i = 0; i < EVENT_BUS_MAX_SUBS; i++) {
+    if (s_subs[i].types & bit) {
+      targets |= 1u << i;
+    }
+  }
+  portEXIT_CRITICAL(&s_mux);
+  ev->t_us = esp_timer_get_time();
+
+  for (int i = 0; targets; i++, targets >>= 1) {
+    if (!(targets & 1u)) {
+      continue;
+    }
+    const bool ok = xQueueSend(s_subs[i].q, ev, 0) == pdTRUE;
+    portENTER_CRITICAL(&s_mux);
+    if (ok) {
+      s_subs[i].delivered++;
+    } else {
+      s_subs[i].dropped++;
+      s_dropped_total++;
+    }
+    portEXIT_CRITICAL(&s_mux);
+  }
+}
+
+bool event_bus_get_stats(int sub, event_bus_stats_t *out) {
+  if (!valid(sub) || !out) {
+    return false;
+  }
+  portENTER_CRITICAL(&s_mux);
+  const bus_sub_t s = s_subs[sub];
+  portEXIT_CRITICAL(&s_mux);
+  if (!s.types) {
+    return false;
+  }
+  out->name = s.name;
+  out->types = s.types;
+  out->delivered = s.delivered;
+  out->dropped = s.dropped;
+  out->queued = s.q ? (uint32_t)uxQueueMessagesWaiting(s.q) : 0;
+  return true;
+}
+
+void event_bus_get_totals(uint32_t *published, uint32_t *dropped) {
+  portENTER_CRITICAL(&s_mux);
+  if (published) {
+    *published = s_seq;
+  }
+  if (dropped) {
+    *dropped = s_dropped_total;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
@@ -0,0 +1,105 @@
+// event_bus.h — in-process publish/subscribe for state changes
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Producers publish one typed event when something changes; each subscriber
+ * owns a fixed-size queue (EVENT_BUS_DEPTH events, statically allocated) and
+ * only receives the types in its mask. Publishing never blocks: an event that
+ * does not fit in a subscriber's queue is dropped for that subscriber and
+ * counted, so a slow consumer cannot stall the sampler or the actuator task.
+ *
+ * Events are copied by value; string fields are truncated to fit.
+ */
+
+#define EVENT_BUS_MAX_SUBS 8
+#define EVENT_BUS_DEPTH 16
+
+typedef enum {
+  BUS_EV_STEP = 0, // program line started, or program ended
+  BUS_EV_TEMP,     // accepted temperature sample
+  BUS_EV_ACTUATOR, // relay outputs changed
+  BUS_EV_FIRMWARE, // FirmwareStatus changed
+  BUS_EV_ACTION,   // queued action dispatched
+  BUS_EV_TYPE_COUNT
+} bus_event_type_t;
+
+#define BUS_EV_BIT(t) (1u << (t))
+#define BUS_EV_ALL ((1u << BUS_EV_TYPE_COUNT) - 1)
+
+typedef struct {
+  bus_event_type_t type;
+  uint32_t seq; // bus-wide publish counter, set by event_bus_publish()
+  int64_t t_us; // esp_timer time, set by event_bus_publish()
+  union {
+    struct {
+      bool running; // false: program ended (names hold the last line)
+      int16_t step, steps, cycle, cycles;
+      char cycle_name[10];
+      char step_name[10];
+    } step;
+    struct {
+      float temp_f;
+      int16_t temp_f_int; // as published in ActiveStatus.CurrentTemp
+      int16_t mv;
+    } temp;
+    struct {
+      uint64_t mask; // levels after the change
+      uint64_t rose;
+      uint64_t fell;
+    } actuator;
+    struct {
+      char status[20];
+    } firmware;
+    struct {
+      int16_t action; // actions_t
+      bool ok;        // false: unknown action
+      uint32_t ms;
+      uint32_t id;      // action_track.h id
+      uint32_t wait_ms; // queued until started
+      uint32_t run_ms;  // started until finished
+    } action;
+  };
+} bus_event_t;
+
+typedef struct {
+  const char *name;
+  uint32_t types;
+  uint32_t delivered;
+  uint32_t dropped;
+  uint32_t queued; // waiting right now
+} event_bus_stats_t;
+
+/**
+ * Claim a subscriber slot for the event types in mask (BUS_EV_BIT()).
+ * Returns the subscriber id, or -1 when all slots are taken. name must be a
+ * string literal (kept by pointer).
+ */
+int event_bus_subscribe(const char *name, uint32_t types);
+
+/** Release a slot; pending events are discarded. */
+void event_bus_unsubscribe(int sub);
+
+/** Wait up to wait ticks for the next event of this subscriber. */
+bool event_bus_receive(int sub, bus_event_t *ev, TickType_t wait);
+
+/** Stamp seq/t_us and copy ev to every interested subscriber. Task context. */
+void event_bus_publish(bus_event_t *ev);
+
+/** Per-slot counters; false for a free or invalid slot. */
+bool event_bus_get_stats(int sub, event_bus_stats_t *out);
+
+/** Events published since boot and dropped across all subscribers. */
+void event_bus_get_totals(uint32_t *published, uint32_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,218 @@
+// histogram.h  — fixed-memory log-linear histogram "template" via macro,
+// plus a P² streaming quantile estimator
+#pragma once
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Log-linear (HDR-style) buckets over uint32_t values:
+   values below 2^SUB_BITS get one bucket each; above that every power of two
+   is split into 2^SUB_BITS equal sub-buckets, so any recorded value is
+   reported within 1/2^SUB_BITS of its true value. Values of 2^(MAX_EXP+1)
+   and above land in the last bucket and are counted in `overflow`.
+   Recording is one clz and one increment; no allocation.
+
+   Usage:
+   HISTOGRAM_DEFINE(lat_hist, 3, 26);        // 12.5% resolution, up to ~134 s in µs
+   static lat_hist h;                        // zero-initialised == empty
+
+   lat_hist_record(&h, elapsed_us);
+   lat_hist snap = h;                        // snapshot: plain struct copy
+   lat_hist_merge(&total, &snap);            // snapshots add bucket-wise
+   uint32_t p99 = lat_hist_quantile(&snap, 0.99);
+
+   Not internally locked: one writer, and readers copy the struct under the
+   owner's lock (or from the writer's own task). */
+
+#define HISTOGRAM_NUM_BUCKETS(SUB_BITS, MAX_EXP)                                      \
+  (((MAX_EXP) - (SUB_BITS) + 2) << (SUB_BITS))
+
+#define HISTOGRAM_DEFINE(NAME, SUB_BITS, MAX_EXP)                                     \
+  _Static_assert((SUB_BITS) >= 1 && (SUB_BITS) <= 8, "SUB_BITS must be 1..8");         \
+  _Static_assert((MAX_EXP) >= (SUB_BITS) && (MAX_EXP) <= 31,                          \
+                 "MAX_EXP must be SUB_BITS..31");                                     \
+  typedef struct {                                                                    \
+    uint32_t  counts[HISTOGRAM_NUM_BUCKETS(SUB_BITS, MAX_EXP)];                       \
+    uint32_t  count;        /* values recorded */                                     \
+    uint32_t  overflow;     /* values clamped into the last bucket */                 \
+    uint32_t  min;          /* exact; valid when count > 0 */                         \
+    uint32_t  max;                                                                    \
+    uint64_t  sum;          /* for the exact mean */                                  \
+  } NAME;                                                                             \
+                                                                                      \
+  static inline void NAME##_clear(NAME *h) { memset(h, 0, sizeof(*h)); }              \
+                                                                                      \
+  static inline size_t NAME##_buckets(void) {                                         \
+    return HISTOGRAM_NUM_BUCKETS(SUB_BITS, MAX_EXP);                                  \
+  }                                                                                   \
+                                                                                      \
+  /* value → bucket index */                                                          \
+  static inline size_t NAME##_index(uint32_t v) {                                     \
+    if (v < (1u << (SUB_BITS))) return v;                                             \
+    int e = 31 - __builtin_clz(v);              /* floor(log2 v) >= SUB_BITS */       \
+    if (e > (MAX_EXP)) return NAME##_buckets() - 1;                                   \
+    uint32_t sub = (v >> (e - (SUB_BITS))) & ((1u << (SUB_BITS)) - 1);               \
+    return ((size_t)(e - (SUB_BITS) + 1) << (SUB_BITS)) + sub;                        \
+  }                                                                                   \
+                                                                                      \
+  /* Smallest value that maps to bucket i */                                          \
+  static inline uint32_t NAME##_lower(size_t i) {                                     \
+    size_t grp = i >> (SUB_BITS);                                                     \
+    uint32_t sub = (uint32_t)(i & ((1u << (SUB_BITS)) - 1));                          \
+    if (grp == 0) return sub;                                                         \
+    int e = (int)grp + (SUB_BITS) - 1;                                                \
+    return ((1u << (SUB_BITS)) | sub) << (e - (SUB_BITS));                            \
+  }                                                                                   \
+                                                                                      \
+  static inline void NAME##_record(NAME *h, uint32_t v) {                             \
+    size_t i = NAME##_index(v);                                                       \
+    if ((v >> (MAX_EXP)) > 1u) h->overflow++;   /* v >= 2^(MAX_EXP+1) */              \
+    h->counts[i]++;                                                                   \
+    if (h->count == 0 || v < h->min) h->min = v;                                      \
+    if (v > h->max) h->max = v;                                                       \
+    h->count++;                                                                       \
+    h->sum += v;                                                                      \
+  }                                                                                   \
+                                                                                      \
+  /* dst += src (same NAME, so identical bucket layout) */                            \
+  static inline void NAME##_merge(NAME *dst, const NAME *src) {                       \
+    if (src->count == 0) return;                                                      \
+    for (size_t i = 0; i < NAME##_buckets(); ++i) dst->counts[i] += src->counts[i];   \
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;                  \
+    if (src->max > dst->max) dst->max = src->max;                                     \
+    dst->count += src->count;                                                         \
+    dst->overflow += src->overflow;                                                   \
+    dst->sum += src->sum;                                                             \
+  }                                                                                   \
+                                                                                      \
+  /* Value at quantile q in [0,1]: midpoint of the bucket holding rank q·count,       \
+     clamped to the exact min/max. 0 when empty. */                                   \
+  static inline uint32_t NAME##_quantile(const NAME *h, double q) {                   \
+    if (h->count == 0) return 0;                                                      \
+    if (q <= 0.0) return h->min;                                                      \
+    if (q >= 1.0) return h->max;                                                      \
+    uint64_t rank = (uint64_t)ceil(q * (double)h->count);                             \
+    uint64_t seen = 0;                                                                \
+    for (size_t i = 0; i < NAME##_buckets(); ++i) {                                   \
+      seen += h->counts[i];                                                           \
+      if (seen >= rank) {                                                             \
+        uint32_t lo = NAME##_lower(i);                                                \
+        uint32_t hi = (i + 1 < NAME##_buckets()) ? NAME##_lower(i + 1) - 1 : h->max;  \
+        uint32_t mid = lo + (hi - lo) / 2;                                            \
+        if (mid < h->min) mid = h->min;                                               \
+        if (mid > h->max) mid = h->max;                                               \
+        return mid;                                                                   \
+      }                                                                               \
+    }                                                                                 \
+    return h->max;                                                                    \
+  }                                                                                   \
+                                                                                      \
+  static inline double NAME##_mean(const NAME *h) {                                   \
+    return h->count ? (double)h->sum / (double)h->count : 0.0;                        \
+  }
+
+/* P² streaming quantile (Jain & Chlamtac, 1985): one quantile p of an
+   unbounded float stream in five markers, O(1) per sample. Use it when a
+   single quantile of a non-integer signal is wanted (e.g. ADC noise);
+   unlike the histogram it cannot be merged.
+
+   p2_quantile_t q;
+   p2_init(&q, 0.95);
+   p2_add(&q, x);
+   float p95 = p2_value(&q);                 // NAN until the first sample */
+typedef struct {
+  double p;
+  uint32_t n;    // samples seen
+  double q[5];   // marker heights
+  double pos[5]; // actual marker positions (1-based)
+  double des[5]; // desired marker positions
+  double inc[5]; // desired position increments
+} p2_quantile_t;
+
+static inline void p2_init(p2_quantile_t *s, double p) {
+  memset(s, 0, sizeof(*s));
+  s->p = p;
+  s->inc[0] = 0.0;
+  s->inc[1] = p / 2.0;
+  s->inc[2] = p;
+  s->inc[3] = (1.0 + p) / 2.0;
+  s->inc[4] = 1.0;
+  for (int i = 0; i < 5; ++i) {
+    s->pos[i] = i + 1;
+    s->des[i] = 1.0 + 4.0 * s->inc[i];
+  }
+}
+
+static inline void p2_add(p2_quantile_t *s, double x) {
+  if (s->n < 5) {
+    // insertion sort of the first five samples
+    int i = (int)s->n++;
+    while (i > 0 && s->q[i - 1] > x) {
+      s->q[i] = s->q[i - 1];
+      i--;
+    }
+    s->q[i] = x;
+    return;
+  }
+  s->n++;
+
+  int k;
+  if (x < s->q[0]) {
+    s->q[0] = x;
+    k = 0;
+  } else if (x >= s->q[4]) {
+    if (x > s->q[4])
+      s->q[4] = x;
+    k = 3;
+  } else {
+    k = 0;
+    while (k < 3 && x >= s->q[k + 1])
+      k++;
+  }
+  for (int i = k + 1; i < 5; ++i)
+    s->pos[i] += 1.0;
+  for (int i = 0; i < 5; ++i)
+    s->des[i] += s->inc[i];
+
+  // adjust the three middle markers (parabolic, else linear)
+  for (int i = 1; i <= 3; ++i) {
+    const double d = s->des[i] - s->pos[i];
+    if ((d >= 1.0 && s->pos[i + 1] - s->pos[i] > 1.0) ||
+        (d <= -1.0 && s->pos[i - 1] - s->pos[i] < -1.0)) {
+      const double sg = (d >= 0.0) ? 1.0 : -1.0;
+      const double np = s->pos[i + 1] - s->pos[i - 1];
+      const double qp =
+          s->q[i] + sg / np *
+                        ((s->pos[i] - s->pos[i - 1] + sg) *
+                             (s->q[i + 1] - s->q[i]) /
+                             (s->pos[i + 1] - s->pos[i]) +
+                         (s->pos[i + 1] - s->pos[i] - sg) *
+                             (s->q[i] - s->q[i - 1]) /
+                             (s->pos[i] - s->pos[i - 1]));
+      if (s->q[i - 1] < qp && qp < s->q[i + 1]) {
+        s->q[i] = qp;
+      } else {
+        const int j = i + (int)sg;
+        s->q[i] += sg * (s->q[j] - s->q[i]) / (s->pos[j] - s->pos[i]);
+      }
+      s->pos[i] += sg;
+    }
+  }
+}
+
+static inline float p2_value(const p2_quantile_t *s) {
+  if (s->n == 0)
+    return NAN;
+  if (s->n < 5) {
+    // exact on the sorted prefix
+    int i = (int)lround(s->p * (double)(s->n - 1));
+    return (float)s->q[i];
+  }
+  return (float)s->q[2];
+}
+
+/* Shared µs latency layout (12.5% resolution, up to ~134 s) so snapshots
+   exported by different modules can be merged with latency_hist_merge(). */
+HISTOGRAM_DEFINE(latency_hist, 3, 26);
@@ -0,0 +1,273 @@
+// http_conn.c — session table and per-client token buckets; see http_conn.h
+// - open/close callbacks and admission run on the httpd task; pinning also
+//   comes from the /events writers and the status watcher, so the tables
+//   are under s_mux
+// - A purged session is only marked closing here; httpd closes it from its
+//   own loop and http_conn_close() then frees the entry
+
+#include "http_conn.h"
+
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+
+#include <string.h>
+
+typedef struct {
+  int fd; // -1: free
+  uint32_t ip;
+  int64_t last_us; // accepted, or last request admitted
+  bool pinned;
+  bool closing; // purge requested
+} conn_t;
+
+typedef struct {
+  bool used;
+  uint32_t ip;
+  int64_t seen_us;
+  int32_t milli[HTTP_RATE_CLASS_COUNT]; // tokens x 1000
+  int64_t refill_us[HTTP_RATE_CLASS_COUNT];
+} client_t;
+
+// burst tokens, refilled at per_s tokens per second
+static const struct {
+  int32_t burst;
+  int32_t per_s;
+} RATE[HTTP_RATE_CLASS_COUNT] = {
+    [HTTP_RATE_STATUS] = {20, 10},
+    [HTTP_RATE_ACTION] = {8, 2},
+};
+
+static conn_t s_conns[HTTP_CONN_MAX_OPEN];
+static client_t s_clients[HTTP_CONN_MAX_CLIENTS];
+static uint32_t s_opened = 0;
+static uint32_t s_purged = 0;
+static uint32_t s_refused = 0;
+static uint32_t s_limited[HTTP_RATE_CLASS_COUNT];
+static bool s_init = false;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Key for the client table: the IPv4 address, also out of an IPv4-mapped
+// IPv6 peer; 0 when unknown
+static uint32_t peer_ip(int fd) {
+  struct sockaddr_storage ss;
+  socklen_t len = sizeof(ss);
+  if (getpeername(fd, (struct sockaddr *)&ss, &len) != 0) {
+    return 0;
+  }
+  if (ss.ss_family == AF_INET) {
+    return ((const struct sockaddr_in *)&ss)->sin_addr.s_addr;
+  }
+#if CONFIG_LWIP_IPV6
+  if (ss.ss_family == AF_INET6) {
+    uint32_t v;
+    memcpy(&v, &((const struct sockaddr_in6 *)&ss)->sin6_addr.s6_addr[12],
+           sizeof(v));
+    return v;
+  }
+#endif
+  return 0;
+}
+
+// s_mux held
+static void init_locked(void) {
+  if (!s_init) {
+    for (int i = 0; i < HTTP_CONN_MAX_OPEN; i++) {
+      s_conns[i].fd = -1;
+    }
+    s_init = true;
+  }
+}
+
+// s_mux held; only_ip limits the search to one client
+static conn_t *find_lru(bool only_ip, uint32_t ip) {
+  conn_t *lru = NULL;
+  for (int i = 0; i < HTTP_CONN_MAX_OPEN; i++) {
+    conn_t *c = &s_conns[i];
+    if (c->fd < 0 || c->pinned || c->closing || (only_ip && c->ip != ip)) {
+      continue;
+    }
+    if (!lru || c->last_us < lru->last_us) {
+      lru = c;
+    }
+  }
+  return lru;
+}
+
+// s_mux held
+static conn_t *find_conn(int fd) {
+  for (int i = 0; i < HTTP_CONN_MAX_OPEN; i++) {
+    if (s_conns[i].fd == fd) {
+      return &s_conns[i];
+    }
+  }
+  return NULL;
+}
+
+esp_err_t http_conn_open(httpd_handle_t hd, int sockfd) {
+  const uint32_t ip = peer_ip(sockfd);
+  const int64_t now = esp_timer_get_time();
+  int purge_fd = -1;
+  bool refuse = false;
+  portENTER_CRITICAL(&s_mux);
+  init_locked();
+  conn_t *slot = NULL;
+  int open = 0;
+  int mine = 0;
+  for (int i = 0; i < HTTP_CONN_MAX_OPEN; i++) {
+    conn_t *c = &s_conns[i];
+    if (c->fd < 0) {
+      slot = slot ? slot : c;
+    } else if (!c->closing) {
+      open++;
+      mine += (c->ip == ip);
+    }
+  }
+  conn_t *victim = NULL;
+  if (mine >= HTTP_CONN_MAX_PER_CLIENT) {
+    victim = find_lru(true, ip);
+    refuse = (victim == NULL);
+  } else if (open + 1 >= HTTP_CONN_MAX_OPEN) {
+    victim = find_lru(false, 0); // keep one session free for the next one
+  }
+  if (victim) {
+    victim->closing = true;
+    purge_fd = victim->fd;
+    s_purged++;
+  }
+  if (refuse) {
+    s_refused++;
+  } else {
+    if (slot) {
+      *slot = (conn_t){.fd = sockfd, .ip = ip, .last_us = now};
+    }
+    s_opened++;
+  }
+  portEXIT_CRITICAL(&s_mux);
+
+  if (purge_fd >= 0) {
+    _LOG_I("conn: closing idle socket %d to make room for %d", purge_fd,
+           sockfd);
+    httpd_sess_trigger_close(hd, purge_fd);
+  }
+  if (refuse) {
+    _LOG_W("conn: refusing socket %d, client at %d sessions", sockfd,
+           HTTP_CONN_MAX_PER_CLIENT);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+void http_conn_close(httpd_handle_t hd, int sockfd) {
+  (void)hd;
+  portENTER_CRITICAL(&s_mux);
+  conn_t *c = find_conn(sockfd);
+  if (c) {
+    c->fd = -1;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  close(sockfd);
+}
+
+// s_mux held; the least recently seen entry is reused for a new client
+static client_t *client_for(uint32_t ip, int64_t now) {
+  client_t *lru = &s_clients[0];
+  for (int i = 0; i < HTTP_CONN_MAX_CLIENTS; i++) {
+    client_t *cl = &s_clients[i];
+    if (cl->used && cl->ip == ip) {
+      cl->seen_us = now;
+      return cl;
+    }
+    if (!cl->used || (lru->used && cl->seen_us < lru->seen_us)) {
+      lru = cl;
+    }
+  }
+  *lru = (client_t){.used = true, .ip = ip, .seen_us = now};
+  return lru;
+}
+
+bool http_conn_admit(int sockfd, http_rate_class_t c, uint32_t *retry_s) {
+  const int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&s_mux);
+  init_locked();
+  conn_t *conn = find_conn(sockfd);
+  const bool known = (conn != NULL);
+  uint32_t ip = 0;
+  if (conn) {
+    conn->last_us = now;
+    ip = conn->ip;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (!HTTP_CONN_RATE_LIMIT || c <= HTTP_RATE_NONE ||
+      c >= HTTP_RATE_CLASS_COUNT) {
+    return true;
+  }
+  if (!known) {
+    ip = peer_ip(sockfd);
+  }
+
+  bool ok;
+  uint32_t wait_s = 0;
+  portENTER_CRITICAL(&s_mux);
+  client_t *cl = client_for(ip, now);
+  const int32_t cap = RATE[c].burst * 1000;
+  if (cl->refill_us[c] == 0) {
+    cl->milli[c] = cap;
+  } else {
+    const int64_t add = (now - cl->refill_us[c]) * RATE[c].per_s / 1000;
+    cl->milli[c] =
+        (add >= cap - cl->milli[c]) ? cap : cl->milli[c] + (int32_t)add;
+  }
+  cl->refill_us[c] = now;
+  ok = cl->milli[c] >= 1000;
+  if (ok) {
+    cl->milli[c] -= 1000;
+  } else {
+    s_limited[c]++;
+    const int32_t rate = RATE[c].per_s * 1000;
+    wait_s = (uint32_t)((1000 - cl->milli[c] + rate - 1) / rate);
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (retry_s) {
+    *retry_s = wait_s;
+  }
+  return ok;
+}
+
+void http_conn_pin(int sockfd, bool pinned) {
+  portENTER_CRITICAL(&s_mux);
+  conn_t *c = find_conn(sockfd);
+  if (c) {
+    c->pinned = pinned;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void http_conn_get_stats(http_conn_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  portENTER_CRITICAL(&s_mux);
+  init_locked();
+  for (int i = 0; i < HTTP_CONN_MAX_OPEN; i++) {
+    if (s_conns[i].fd >= 0) {
+      out->open++;
+      out->pinned += s_conns[i].pinned;
+    }
+  }
+  out->opened = s_opened;
+  out->purged = s_purged;
+  out->refused = s_refused;
+  memcpy(out->limited, s_limited, sizeof(out->limited));
+  portEXIT_CRITICAL(&s_mux);
+}
+
+const char *http_rate_class_name(http_rate_class_t c) {
+  switch (c) {
+  case HTTP_RATE_STATUS:
+    return "status";
+  case HTTP_RATE_ACTION:
+    return "action";
+  default:
+    return "none";
+  }
+}
@@ -0,0 +1,82 @@
+// http_conn.h — httpd session bookkeeping: LRU purge and per-client limits
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sessions. HTTP_CONN_MAX_OPEN httpd sessions fit in the lwIP socket pool
+ * after httpd's own 3 sockets and up to 3 for the logger, OTA client and
+ * SNTP. When a new connection would leave no free session, the idle
+ * session used least recently is closed. Before the pool fills, no one has
+ * to wait in the listen backlog. Pinned sessions are never picked; pin the
+ * detached /events streams and parked long-polls while they are owned
+ * elsewhere. A client (IP address) holding HTTP_CONN_MAX_PER_CLIENT
+ * sessions gets its own least-recent idle one closed to make room, or the
+ * new connection refused when all of them are pinned.
+ *
+ * Rate limits. Each client has a token bucket per http_rate_class_t.
+ * http_conn_admit() spends one token per request. An empty bucket means
+ * 429 until it refills. Hardware buttons do not pass through here, so
+ * they keep working while a script floods the network side.
+ *
+ * A load test from one host (tools/bench/status_load.py) runs into the
+ * status bucket within a second and then measures 429s. Build with
+ * `idf.py -DHTTP_CONN_RATE_LIMIT=0 build` for such runs: sessions are still
+ * managed, but no request is limited.
+ */
+
+#ifndef HTTP_CONN_RATE_LIMIT
+#define HTTP_CONN_RATE_LIMIT 1
+#endif
+
+// sdkconfig CONFIG_LWIP_MAX_SOCKETS minus httpd's 3 and 3 for other users
+#define HTTP_CONN_MAX_OPEN (CONFIG_LWIP_MAX_SOCKETS - 6)
+#define HTTP_CONN_MAX_PER_CLIENT 6
+#define HTTP_CONN_MAX_CLIENTS 8 // rate-limit buckets; least recent reused
+
+typedef enum {
+  HTTP_RATE_NONE = 0, // not limited
+  HTTP_RATE_STATUS,   // reads: /status, /history, /actuators, /actions/<id>
+  HTTP_RATE_ACTION,   // POST /action/..., POST /actions
+  HTTP_RATE_CLASS_COUNT
+} http_rate_class_t;
+
+typedef struct {
+  uint32_t open;     // sessions now
+  uint32_t pinned;   // of those, pinned
+  uint32_t opened;   // accepted since boot
+  uint32_t purged;   // closed to make room
+  uint32_t refused;  // closed at once: client at its limit, all pinned
+  uint32_t limited[HTTP_RATE_CLASS_COUNT]; // 429s sent
+} http_conn_stats_t;
+
+/** httpd_config_t.open_fn / close_fn (close_fn closes the socket). */
+esp_err_t http_conn_open(httpd_handle_t hd, int sockfd);
+void http_conn_close(httpd_handle_t hd, int sockfd);
+
+/**
+ * Mark the session as used now and take a token of class c from its
+ * client. False when the bucket is empty; *retry_s (optional) is then the
+ * wait in whole seconds until the next token.
+ */
+bool http_conn_admit(int sockfd, http_rate_class_t c, uint32_t *retry_s);
+
+/** Exempt a session from purging (true) or make it purgeable again. */
+void http_conn_pin(int sockfd, bool pinned);
+
+void http_conn_get_stats(http_conn_stats_t *out);
+
+/** "status", "action"; "none" for HTTP_RATE_NONE. */
+const char *http_rate_class_name(http_rate_class_t c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,201 @@
+// http_events.c — Server-Sent Events status push; see http_events.h
+
+#include "http_events.h"
+
+#include "action_track.h"
+#include "dishwasher_programs.h"
+#include "event_bus.h"
+#include "http_conn.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "http_server.h"
+#include "status_json.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SSE_TASK_STACK 3072
+#define SSE_TASK_PRIO 4 // below httpd and the action worker
+#define SSE_FRAME_PREFIX "event: status\ndata: "
+#define SSE_FRAME_MAX (sizeof(SSE_FRAME_PREFIX) + STATUS_JSON_MAX + 1)
+
+typedef struct {
+  httpd_req_t *req; // detached request; NULL while the slot is free
+  int fd;           // its socket, pinned while the stream runs
+  bool claimed;
+  int sub;
+  status_view_t sent; // what this client has been told
+  status_view_t now;
+  char frame[SSE_FRAME_MAX];
+} sse_client_t;
+
+// Kept out of the task stacks: two views and a frame per client
+static sse_client_t s_clients[HTTP_EVENTS_MAX_CLIENTS];
+static uint32_t s_opened = 0;
+static uint32_t s_frames = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool send_text(sse_client_t *c, const char *s, size_t len) {
+  if (httpd_resp_send_chunk(c->req, s, (ssize_t)len) != ESP_OK) {
+    return false;
+  }
+  portENTER_CRITICAL(&s_mux);
+  s_frames++;
+  portEXIT_CRITICAL(&s_mux);
+  return true;
+}
+
+// One "status" frame with the keys that changed since c->sent (all of them
+// when full); nothing is sent when nothing changed
+static bool send_status(sse_client_t *c, bool full) {
+  http_server_fill_status(&c->now, false);
+  const size_t pre = sizeof(SSE_FRAME_PREFIX) - 1;
+  memcpy(c->frame, SSE_FRAME_PREFIX, pre);
+  // The JSON ends in "\n"; one more closes the frame
+  const size_t len = status_json_render_delta(
+      full ? NULL : &c->sent, &c->now, c->frame + pre,
+      sizeof(c->frame) - pre - 1);
+  if (len == 0) {
+    _LOG_W("events: status frame too large");
+    return true; // keep the stream; the next change retries
+  }
+  if (!full && len == STATUS_JSON_EMPTY_LEN) {
+    return true;
+  }
+  c->frame[pre + len] = '\n';
+  if (!send_text(c, c->frame, pre + len + 1)) {
+    return false;
+  }
+  c->sent = c->now;
+  return true;
+}
+
+// One "action" frame per finished action, sent as soon as it arrives
+static bool send_action(sse_client_t *c, const bus_event_t *ev) {
+  char frame[192];
+  const int len = snprintf(
+      frame, sizeof(frame),
+      "event: action\ndata: {\"id\":%lu,\"action\":\"%s\",\"state\":\"%s\","
+      "\"wait_ms\":%lu,\"run_ms\":%lu}\n\n",
+      (unsigned long)ev->action.id,
+      http_server_action_name((actions_t)ev->action.action),
+      action_state_name(ev->action.ok ? ACTION_STATE_DONE
+                                      : ACTION_STATE_FAILED),
+      (unsigned long)ev->action.wait_ms, (unsigned long)ev->action.run_ms);
+  return send_text(c, frame, (size_t)len);
+}
+
+static void release(sse_client_t *c) {
+  event_bus_unsubscribe(c->sub);
+  portENTER_CRITICAL(&s_mux);
+  c->req = NULL;
+  c->claimed = false;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+static void sse_task(void *arg) {
+  sse_client_t *c = (sse_client_t *)arg;
+  httpd_resp_set_type(c->req, "text/event-stream");
+  httpd_resp_set_hdr(c->req, "Cache-Control", "no-cache");
+  static const char hello[] = "retry: 5000\n\n";
+  bool ok = send_text(c, hello, sizeof(hello) - 1) && send_status(c, true);
+  while (ok) {
+    bus_event_t ev;
+    if (!event_bus_receive(c->sub, &ev,
+                           pdMS_TO_TICKS(HTTP_EVENTS_KEEPALIVE_MS))) {
+      static const char ping[] = ": ping\n\n";
+      ok = send_text(c, ping, sizeof(ping) - 1);
+      continue;
+    }
+    if (ev.type == BUS_EV_ACTION) {
+      ok = send_action(c, &ev);
+      continue;
+    }
+    // Let the burst settle (a step change moves actuators and the step
+    // within a few ms), then answer all of it with one frame
+    vTaskDelay(pdMS_TO_TICKS(HTTP_EVENTS_COALESCE_MS));
+    while (ok && event_bus_receive(c->sub, &ev, 0)) {
+      if (ev.type == BUS_EV_ACTION) {
+        ok = send_action(c, &ev);
+      }
+    }
+    ok = ok && send_status(c, false);
+  }
+  _LOG_I("events: client %d gone", (int)(c - s_clients));
+  http_conn_pin(c->fd, false);
+  httpd_req_async_handler_complete(c->req);
+  release(c);
+  vTaskDelete(NULL);
+}
+
+esp_err_t http_events_handler(httpd_req_t *req) {
+  sse_client_t *c = NULL;
+  portENTER_CRITICAL(&s_mux);
+  for (int i = 0; i < HTTP_EVENTS_MAX_CLIENTS; i++) {
+    if (!s_clients[i].claimed) {
+      c = &s_clients[i];
+      c->claimed = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (!c) {
+    httpd_resp_set_hdr(req, "Retry-After", "30");
+    return httpd_resp_send_err(req, 503, "too many event streams");
+  }
+
+  c->sub = event_bus_subscribe("sse", BUS_EV_BIT(BUS_EV_STEP) |
+                                          BUS_EV_BIT(BUS_EV_TEMP) |
+                                          BUS_EV_BIT(BUS_EV_ACTUATOR) |
+                                          BUS_EV_BIT(BUS_EV_FIRMWARE) |
+                                          BUS_EV_BIT(BUS_EV_ACTION));
+  if (c->sub < 0) {
+    portENTER_CRITICAL(&s_mux);
+    c->claimed = false;
+    portEXIT_CRITICAL(&s_mux);
+    return httpd_resp_send_err(req, 503, "no event bus slot");
+  }
+
+  httpd_req_t *detached = NULL;
+  if (httpd_req_async_handler_begin(req, &detached) != ESP_OK) {
+    release(c);
+    return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                               "cannot detach request");
+  }
+  c->req = detached;
+  c->fd = httpd_req_to_sockfd(detached);
+  http_conn_pin(c->fd, true);
+  if (xTaskCreate(sse_task, "sse", SSE_TASK_STACK, c, SSE_TASK_PRIO, NULL) !=
+      pdPASS) {
+    http_conn_pin(c->fd, false);
+    httpd_resp_send_err(detached, HTTPD_500_INTERNAL_SERVER_ERROR,
+                        "no memory");
+    httpd_req_async_handler_complete(detached);
+    release(c);
+    return ESP_OK;
+  }
+  portENTER_CRITICAL(&s_mux);
+  s_opened++;
+  portEXIT_CRITICAL(&s_mux);
+  _LOG_I("events: client %d connected", (int)(c - s_clients));
+  return ESP_OK;
+}
+
+void http_events_get_counts(uint32_t *clients, uint32_t *opened,
+                            uint32_t *frames) {
+  uint32_t n = 0;
+  portENTER_CRITICAL(&s_mux);
+  for (int i = 0; i < HTTP_EVENTS_MAX_CLIENTS; i++) {
+    n += s_clients[i].req != NULL;
+  }
+  if (opened) {
+    *opened = s_opened;
+  }
+  if (frames) {
+    *frames = s_frames;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (clients) {
+    *clients = n;
+  }
+}
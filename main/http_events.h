@@ -0,0 +1,46 @@
+// http_events.h — GET /events: status pushed as Server-Sent Events
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each client gets one writer task that subscribes to the event bus (step,
+ * temperature, actuator and firmware events). On connect it sends the full
+ * /status object as an "event: status" frame. After that, every burst of bus
+ * events (collected for HTTP_EVENTS_COALESCE_MS) becomes a single frame. The
+ * frame holds only the /status keys whose values changed since the last
+ * frame that client received.
+ *
+ * A client's backlog is bounded to that one pending delta. A slow socket
+ * delays the next frame, which then carries everything that changed in the
+ * meantime; nothing queues up per event. A comment line every
+ * HTTP_EVENTS_KEEPALIVE_MS finds dead sockets.
+ *
+ * Finished actions are not coalesced. Each one is sent as its own
+ * "event: action" frame: {"id", "action", "state", "wait_ms", "run_ms"},
+ * with the id from POST /actions or the Location of POST /action/...
+ *
+ * The request is detached with httpd_req_async_handler_begin(), so the
+ * httpd task is free again as soon as the stream is set up.
+ */
+
+#define HTTP_EVENTS_MAX_CLIENTS 3
+#define HTTP_EVENTS_COALESCE_MS 200
+#define HTTP_EVENTS_KEEPALIVE_MS 15000
+
+/** URI handler for GET /events. */
+esp_err_t http_events_handler(httpd_req_t *req);
+
+/** Streams open now, opened since boot, and frames sent. */
+void http_events_get_counts(uint32_t *clients, uint32_t *opened,
+                            uint32_t *frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,10 @@
 // http_server.c — regenerated from build-248-ok with current actions and rules
 // - Wildcard POST handler ("/action/*")
-// - Grouped buttons by <GROUP> from ACTION_<GROUP>_<BUTTON>
+// - Grouped buttons by <GROUP> from ACTIONS_TABLE; the page is a gzipped
+//   flash asset (main/web) served with an ETag
 // - perform_action_<BUTTON>() stubs (weak) executed in worker task
-// - /status JSON uses full ActiveStatus; times as MM:SS; start/end as EST AM/PM
+// - /status JSON uses full ActiveStatus, rendered by status_json.c into one
+//   buffer; times as MM:SS; start/end as EST AM/PM
 // - 95% status viewport; refresh 10s or 1s after click; button pushed glow 2s
 // - Braces on all if/for; no word-wrapped code lines
 
@@ -11,6 +13,7 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 #include <stdbool.h>
@@ -19,9 +22,23 @@
 #include <string.h>
 #include <time.h>
 
+#include "action_track.h"
+#include "actuator.h"
+#include "cbor_enc.h"
+#include "analog.h"
 #include "dishwasher_programs.h"
+#include "event_bus.h"
+#include "http_conn.h"
+#include "http_events.h"
 #include "http_server.h"
 #include "local_ota.h"
+#include "metrics.h"
+#include "run_capture.h"
+#include "status_cache.h"
+#include "status_cbor.h"
+#include "status_json.h"
+#include "status_watch.h"
+#include "temp_history.h"
 
 #ifndef TAG
 #define TAG "http_server"
@@ -33,26 +50,134 @@
  *  - check_and_perform_ota() from local_ota.h
  */
 
-#define ACTION_QUEUE_LEN 16
+#define ACTION_LONG_TASK_PRIO 4 // LED test and OTA: below everything else
 #define ACTION_TASK_STACK 4096
 #define ACTION_TASK_PRIO 5
 #define RUN_PROGRAM_STACK 8192
-#define EST_OFFSET_SECONDS (-5 * 3600)
+#define ACTION_TOGGLE_DEFAULT_MS (5 * 60 * 1000) // manual on without ?ms=
+#define ACTION_PULSE_MAX_MS (30 * 60 * 1000)
+#define HISTORY_BATCH 32 // buckets copied/sent per chunk
+#define HISTORY_MAGIC "TH1"
+// "-9223372036854775808,-3276.8,-3276.8,-3276.8\n" plus NUL
+#define HISTORY_CSV_LINE_MAX 48
+#define ACTIONS_BODY_MAX 512 // POST /actions JSON
+#define ACTIONS_BODY_TIMEOUTS 2 // recv timeouts before giving up on a body
+#define PROGRAM_CANCEL_TIMEOUT_MS 3000 // then the program task is deleted
 
 static httpd_handle_t s_server = NULL;
-static QueueHandle_t s_action_queue = NULL;
-static TaskHandle_t s_action_task = NULL;
+static SemaphoreHandle_t s_enqueue_lock = NULL; // keeps a batch contiguous
+static TaskHandle_t s_action_task = NULL; // URGENT, then NORMAL
+static TaskHandle_t s_long_task = NULL;   // LONG
+// Program task lifecycle, all under s_program_lock: action_worker starts
+// and cancels, the program task and s_cancel_timer end a run
+static SemaphoreHandle_t s_program_lock = NULL;
 static TaskHandle_t s_program_task = NULL;
+static bool s_cancel_pending = false;       // run told to stop, not gone yet
+static const char *s_next_program = NULL;   // started once it is gone
+static esp_timer_handle_t s_cancel_timer = NULL; // force-delete fallback
+
+typedef struct {
+  QueueHandle_t q;
+  uint32_t enqueued;
+  uint32_t dropped;
+  latency_hist wait;
+} lane_t;
+
+// Counters and wait histograms are under s_action_mux
+static lane_t s_lanes[ACTION_LANE_COUNT];
+static portMUX_TYPE s_action_mux = portMUX_INITIALIZER_UNLOCKED;
+static const UBaseType_t LANE_LEN[ACTION_LANE_COUNT] = {
+    [ACTION_LANE_NORMAL] = 16,
+    [ACTION_LANE_URGENT] = 8,
+    [ACTION_LANE_LONG] = 4,
+};
+static const char *const LANE_NAME[ACTION_LANE_COUNT] = {
+    [ACTION_LANE_NORMAL] = "normal",
+    [ACTION_LANE_URGENT] = "urgent",
+    [ACTION_LANE_LONG] = "long",
+};
+// Actions not listed are NORMAL
+static const action_lane_t ACTION_LANE[ACTION_MAX] = {
+    [ACTION_DO_PAUSE] = ACTION_LANE_URGENT,
+    [ACTION_DO_RESUME] = ACTION_LANE_URGENT,
+    [ACTION_ADMIN_CANCEL] = ACTION_LANE_URGENT,
+    [ACTION_ADMIN_REBOOT] = ACTION_LANE_URGENT,
+    [ACTION_ADMIN_SKIP_STEP] = ACTION_LANE_URGENT,
+    [ACTION_TOGGLE_LEDS] = ACTION_LANE_LONG,
+    [ACTION_ADMIN_FIRMWARE] = ACTION_LANE_LONG,
+};
+
+// Web UI built by main/web/gen_index.py, embedded by main/CMakeLists.txt
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
+
+// Per-route handler latency; written by the httpd task, read from anywhere
+static latency_hist s_latency[HTTP_ROUTE_MAX];
+static portMUX_TYPE s_latency_mux = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct {
+  esp_err_t (*fn)(httpd_req_t *req);
+  http_route_t route;
+  http_rate_class_t rate; // per-client limit checked before fn
+} timed_route_t;
+
+// One queued action; ms is the on-time for TOGGLE actions (0 = default)
+typedef struct {
+  actions_t act;
+  uint32_t ms;
+  uint32_t id;       // action_track.h
+  int64_t queued_us; // for the lane's wait histogram
+} action_req_t;
 
 // Forward declarations
 static void action_worker(void *arg);
+static void action_long_worker(void *arg);
 static esp_err_t generic_action_handler(httpd_req_t *req);
 static esp_err_t root_get_handler(httpd_req_t *req);
 static esp_err_t handle_status(httpd_req_t *req);
+static esp_err_t handle_history(httpd_req_t *req);
+static esp_err_t handle_actuators(httpd_req_t *req);
+static esp_err_t handle_actions_post(httpd_req_t *req);
+static esp_err_t handle_action_get(httpd_req_t *req);
+
+static esp_err_t send_too_many(httpd_req_t *req, uint32_t retry_s) {
+  char retry[12];
+  snprintf(retry, sizeof(retry), "%lu", (unsigned long)(retry_s ? retry_s : 1));
+  httpd_resp_set_status(req, "429 Too Many Requests");
+  httpd_resp_set_type(req, "text/plain");
+  httpd_resp_set_hdr(req, "Retry-After", retry);
+  return httpd_resp_sendstr(req, "rate limited\n");
+}
 
-static inline int64_t now_ms(void) { return esp_timer_get_time() / 1000; }
+// Registered as every route's handler; user_ctx names the real one
+static esp_err_t timed_handler(httpd_req_t *req) {
+  const timed_route_t *r = (const timed_route_t *)req->user_ctx;
+  uint32_t retry_s;
+  if (!http_conn_admit(httpd_req_to_sockfd(req), r->rate, &retry_s)) {
+    // Counted by http_conn; kept out of the route's latency
+    return send_too_many(req, retry_s);
+  }
+  const int64_t t0 = esp_timer_get_time();
+  const esp_err_t err = r->fn(req);
+  const int64_t dt = esp_timer_get_time() - t0;
+  portENTER_CRITICAL(&s_latency_mux);
+  latency_hist_record(&s_latency[r->route],
+                      dt > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)dt);
+  portEXIT_CRITICAL(&s_latency_mux);
+  return err;
+}
 static inline unsigned queue_depth(void) {
-  return s_action_queue ? (unsigned)uxQueueMessagesWaiting(s_action_queue) : 0u;
+  unsigned n = 0;
+  for (int i = 0; i < ACTION_LANE_COUNT; i++) {
+    n += s_lanes[i].q ? (unsigned)uxQueueMessagesWaiting(s_lanes[i].q) : 0u;
+  }
+  return n;
+}
+
+static inline bool actions_ready(void) {
+  return s_enqueue_lock && s_action_task && s_long_task &&
+         s_lanes[ACTION_LANE_NORMAL].q && s_lanes[ACTION_LANE_URGENT].q &&
+         s_lanes[ACTION_LANE_LONG].q;
 }
 
 static void drain_body(httpd_req_t *req) {
@@ -81,142 +206,318 @@ static bool has_token_ci(const char *s, const char *token) {
   return false;
 }
 
-static const char *ms_to_mmss(int64_t ms, char out[8]) {
-  if (ms < 0) {
-    strcpy(out, "--:--");
-    return out;
+// Bounded copy out of ActiveStatus's fixed char arrays
+static void copy_status_str(char *dst, size_t dst_len, const volatile char *src,
+                            size_t src_len) {
+  size_t n = 0;
+  while (n + 1 < dst_len && n < src_len && src[n]) {
+    dst[n] = src[n];
+    n++;
   }
-  int64_t secs = ms / 1000;
-  int mm = (int)(secs / 60);
-  int ss = (int)(secs % 60);
-  snprintf(out, 8, "%02d:%02d", mm, ss);
-  return out;
+  dst[n] = '\0';
 }
 
-static void format_est_time_ms(int64_t epoch_ms, char out[16]) {
-  if (epoch_ms <= 0) {
-    strcpy(out, "--:--");
+#define COPY_STATUS_STR(dst, field)                                            \
+  copy_status_str((dst), sizeof(dst), ActiveStatus.field,                      \
+                  sizeof(ActiveStatus.field))
+
+// Everything /status reports, read once; the renderer never touches
+// ActiveStatus. The copy takes no lock against run_program, so a step change
+// landing mid-copy can pair fields from two steps until the next poll.
+void http_server_fill_status(status_view_t *v, bool with_latency) {
+  memset(v, 0, sizeof(*v));
+  v->version = status_watch_version();
+  // Both in epoch seconds; time_full_total is the absolute end (start plus
+  // the program's max_time), not a duration
+  const int64_t start_s = ActiveStatus.time_full_start;
+  const int64_t end_s = ActiveStatus.time_full_total;
+  COPY_STATUS_STR(v->program, Program);
+  COPY_STATUS_STR(v->cycle, Cycle);
+  COPY_STATUS_STR(v->step, Step);
+  COPY_STATUS_STR(v->devices, ActiveDevices);
+  COPY_STATUS_STR(v->leds, ActiveLEDs);
+  COPY_STATUS_STR(v->firmware_status, FirmwareStatus);
+  COPY_STATUS_STR(v->ip, IPAddress);
+  v->cycle_index = ActiveStatus.CycleIndex;
+  v->cycles_total = ActiveStatus.CyclesTotal;
+  v->step_index = ActiveStatus.StepIndex;
+  v->steps_total = ActiveStatus.StepsTotal;
+  v->last_transition = ActiveStatus.LastTransitionMs;
+  v->current_temp = ActiveStatus.CurrentTemp;
+  v->current_power = ActiveStatus.CurrentPower;
+  v->device_mask = ActiveStatus.ActiveDeviceMask;
+  v->heat_requested = ActiveStatus.HEAT_REQUESTED;
+  v->heat_reached = ActiveStatus.HEAT_REACHED;
+  v->skip_step = ActiveStatus.SkipStep;
+  v->soap_dispensed = ActiveStatus.SoapHasDispensed;
+  v->time_cycle_start = ActiveStatus.time_cycle_start;
+  v->time_cycle_total = ActiveStatus.time_cycle_total;
+
+  // -1 renders as "--:--" while no program is running
+  int64_t elapsed_ms = -1;
+  int64_t remaining_ms = -1;
+  if (start_s > 0) {
+    const int64_t now_s = (int64_t)time(NULL);
+    elapsed_ms = (now_s > start_s) ? (now_s - start_s) * 1000 : 0;
+    if (end_s > start_s) {
+      remaining_ms = (end_s > now_s) ? (end_s - now_s) * 1000 : 0;
+    }
+  }
+  v->elapsed_ms = elapsed_ms;
+  v->remaining_ms = remaining_ms;
+  v->start_epoch_ms = (start_s > 0) ? start_s * 1000 : 0;
+  v->end_epoch_ms = (start_s > 0 && end_s > start_s) ? end_s * 1000 : 0;
+
+  analog_trend_t trend;
+  analog_get_trend(&trend);
+  v->trend_valid = trend.valid;
+  v->rate_f_per_min = trend.rate_f_per_min;
+  v->secs_to_min_temp = trend.secs_to_min_temp;
+  v->secs_to_max_temp = trend.secs_to_max_temp;
+  v->overshoot_f = trend.overshoot_f;
+
+  if (!with_latency) {
     return;
   }
-  time_t t = (time_t)(epoch_ms / 1000) + EST_OFFSET_SECONDS;
-  struct tm tmv;
-  gmtime_r(&t, &tmv);
-  int hh = tmv.tm_hour % 12;
-  if (hh == 0) {
-    hh = 12;
+  // Only status_cache.c asks for latency, one build at a time, so a static
+  // snapshot is safe here
+  static latency_hist lat;
+  http_server_get_latency(HTTP_ROUTE_MAX, &lat);
+  v->http_count = lat.count;
+  if (lat.count) {
+    v->http_p50_us = latency_hist_quantile(&lat, 0.50);
+    v->http_p99_us = latency_hist_quantile(&lat, 0.99);
+    v->http_max_us = lat.max;
   }
-  const char *ampm = (tmv.tm_hour >= 12) ? "PM" : "AM";
-  snprintf(out, 16, "%02d:%02d %s", hh, tmv.tm_min, ampm);
 }
 
-// JSON helpers
-static void json_prop_str(httpd_req_t *req, bool *first, const char *key,
-                          const char *val) {
-  if (!*first) {
-    httpd_resp_sendstr_chunk(req, ",");
-  } else {
-    *first = false;
+// CBOR instead of JSON: /<route>.cbor or Accept: application/cbor
+static bool wants_cbor(httpd_req_t *req) {
+  const size_t ulen = strcspn(req->uri, "?");
+  if (ulen >= 5 && strncmp(req->uri + ulen - 5, ".cbor", 5) == 0) {
+    return true;
   }
-  httpd_resp_sendstr_chunk(req, "\"");
-  httpd_resp_sendstr_chunk(req, key);
-  httpd_resp_sendstr_chunk(req, "\":\"");
-  httpd_resp_sendstr_chunk(req, val ? val : "");
-  httpd_resp_sendstr_chunk(req, "\"");
+  char accept[64];
+  return httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) ==
+             ESP_OK &&
+         has_token_ci(accept, "application/cbor");
 }
 
-static void json_prop_int(httpd_req_t *req, bool *first, const char *key,
-                          int val) {
-  char num[24];
-  snprintf(num, sizeof(num), "%d", val);
-  if (!*first) {
-    httpd_resp_sendstr_chunk(req, ",");
-  } else {
-    *first = false;
+// Status handler using ActiveStatus (GET only): one buffer, one send.
+// ?since=N[&timeout=ms] long-polls: while the status version is still N the
+// request is handed to status_watch, which answers it on change or timeout.
+// GET /status.cbor (or Accept: application/cbor) sends status_cbor.h instead.
+static esp_err_t handle_status(httpd_req_t *req) {
+  static char body[STATUS_JSON_MAX]; // httpd task only
+  const bool cbor = wants_cbor(req);
+  char query[48];
+  char val[12];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "since", val, sizeof(val)) == ESP_OK) {
+    const uint32_t since = (uint32_t)strtoul(val, NULL, 10);
+    uint32_t timeout_ms = STATUS_WATCH_DEFAULT_TIMEOUT_MS;
+    if (httpd_query_key_value(query, "timeout", val, sizeof(val)) == ESP_OK) {
+      timeout_ms = (uint32_t)strtoul(val, NULL, 10);
+    }
+    // Parking full or unavailable: answer now, the client just polls again
+    if (since == status_watch_version() && timeout_ms > 0 &&
+        status_watch_park(req, since, timeout_ms, cbor) == ESP_OK) {
+      return ESP_OK;
+    }
   }
-  httpd_resp_sendstr_chunk(req, "\"");
-  httpd_resp_sendstr_chunk(req, key);
-  httpd_resp_sendstr_chunk(req, "\":");
-  httpd_resp_sendstr_chunk(req, num);
+  // Rendered at most once per version and STATUS_CACHE_TTL_MS for all
+  // pollers together; this only copies the bytes out
+  const size_t len = status_cache_copy(
+      cbor ? STATUS_CACHE_CBOR : STATUS_CACHE_JSON, body, sizeof(body));
+  if (len == 0) {
+    return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                               "status too large");
+  }
+  httpd_resp_set_type(req, cbor ? "application/cbor" : "application/json");
+  return httpd_resp_send(req, body, (ssize_t)len);
 }
 
-static void json_prop_bool(httpd_req_t *req, bool *first, const char *key,
-                           bool b) {
-  if (!*first) {
-    httpd_resp_sendstr_chunk(req, ",");
-  } else {
-    *first = false;
+// Actuator usage: GET /actuators
+// {"uptime_s":N,"changes":N,"actuators":[{"name":"HEAT","gpio":32,"on":false,
+//   "on_s":123.4,"cycles":56},...]}  (on_s/cycles include previous boots)
+static esp_err_t handle_actuators(httpd_req_t *req) {
+  actor_usage_t usage[ACTOR_COUNT];
+  actor_usage_get(usage);
+  const uint64_t mask = actuator_get_mask();
+  uint32_t changes = 0;
+  actuator_get_changes(NULL, 0, &changes);
+
+  char buf[160];
+  httpd_resp_set_type(req, "application/json");
+  snprintf(buf, sizeof(buf),
+           "{\"uptime_s\":%lld,\"changes\":%lu,\"actuators\":[",
+           (long long)(esp_timer_get_time() / 1000000),
+           (unsigned long)changes);
+  httpd_resp_sendstr_chunk(req, buf);
+  for (int i = 0; i < ACTOR_COUNT; i++) {
+    const uint64_t bit = actor_bit((actor_id_t)i);
+    snprintf(buf, sizeof(buf),
+             "%s{\"name\":\"%s\",\"gpio\":%d,\"on\":%s,\"on_s\":%.1f,"
+             "\"cycles\":%lu}",
+             i ? "," : "", actor_name((actor_id_t)i), __builtin_ctzll(bit),
+             (mask & bit) ? "true" : "false",
+             (double)usage[i].on_us / 1e6, (unsigned long)usage[i].cycles);
+    httpd_resp_sendstr_chunk(req, buf);
   }
-  httpd_resp_sendstr_chunk(req, "\"");
-  httpd_resp_sendstr_chunk(req, key);
-  httpd_resp_sendstr_chunk(req, "\":");
-  httpd_resp_sendstr_chunk(req, b ? "true" : "false");
+  httpd_resp_sendstr_chunk(req, "]}\n");
+  httpd_resp_send_chunk(req, NULL, 0);
+  return ESP_OK;
 }
 
-// Status handler using ActiveStatus (GET only)
-static esp_err_t handle_status(httpd_req_t *req) {
-  char runbuf[512];
-  int64_t start_ms = (ActiveStatus.time_full_start > 0)
-                         ? ActiveStatus.time_full_start
-                         : ActiveStatus.time_start;
-  int64_t total_ms = (ActiveStatus.time_full_total > 0)
-                         ? ActiveStatus.time_full_total
-                         : ActiveStatus.time_total;
-  static bool soap_sticky = false;
-  static int64_t last_prog_start = -1;
-  if (start_ms > 0 && start_ms != last_prog_start) {
-    last_prog_start = start_ms;
-    soap_sticky = false;
-  }
-  int64_t elapsed_ms = -1;
-  if (ActiveStatus.time_elapsed >= 0) {
-    elapsed_ms = ActiveStatus.time_elapsed;
-  } else if (start_ms > 0) {
-    elapsed_ms = now_ms() - start_ms;
-    if (elapsed_ms < 0) {
-      elapsed_ms = 0;
+// History handler: GET /history?tier=0|1|2&fmt=csv|bin|cbor[&since=<seq>]
+// CSV rows are "epoch_s,min_f,max_f,mean_f" (empty fields for gaps).
+// Binary is a 20-byte little-endian header followed by int16 triples:
+//   char magic[3]="TH1", u8 tier, u32 bucket_ms, u32 first_seq,
+//   u32 count, i32 first_epoch_s; then count × {min,max,mean} in 0.1 °F,
+//   INT16_MIN marks a bucket without samples.
+// CBOR (fmt=cbor, /history.cbor or Accept: application/cbor) is the map in
+// status_cbor.h.
+static int64_t history_epoch_s(const temp_history_info_t *info, uint32_t seq,
+                               time_t now_epoch) {
+  const int64_t start_ms =
+      (int64_t)info->origin_ms + (int64_t)seq * (int64_t)info->bucket_ms;
+  return (int64_t)now_epoch - ((int64_t)info->now_ms - start_ms) / 1000;
+}
+
+static esp_err_t handle_history(httpd_req_t *req) {
+  char query[64] = {0};
+  char val[16];
+  int tier = 0;
+  bool binary = false;
+  bool cbor = wants_cbor(req);
+  uint32_t since = 0;
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+    if (httpd_query_key_value(query, "tier", val, sizeof(val)) == ESP_OK) {
+      tier = atoi(val);
+    }
+    if (httpd_query_key_value(query, "fmt", val, sizeof(val)) == ESP_OK) {
+      binary = (strcmp(val, "bin") == 0);
+      cbor = (strcmp(val, "cbor") == 0);
+    }
+    if (httpd_query_key_value(query, "since", val, sizeof(val)) == ESP_OK) {
+      since = (uint32_t)strtoul(val, NULL, 10);
     }
   }
-  int64_t remaining_ms = -1;
-  if (ActiveStatus.time_total > 0 && ActiveStatus.time_elapsed >= 0) {
-    remaining_ms = ActiveStatus.time_total - ActiveStatus.time_elapsed;
-  } else if (start_ms > 0 && total_ms > 0) {
-    remaining_ms = (start_ms + total_ms) - now_ms();
+  temp_history_info_t info;
+  if (!temp_history_info(tier, &info)) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bad tier");
+    return ESP_OK;
   }
-  if (remaining_ms < 0) {
-    remaining_ms = 0;
+  const time_t now_epoch = time(NULL);
+  uint32_t seq = (since > info.first_seq) ? since : info.first_seq;
+  if (seq > info.next_seq) {
+    seq = info.next_seq;
   }
-  if (has_token_ci(ActiveStatus.ActiveDevices, "soap") ||
-      has_token_ci(ActiveStatus.Step, "soap")) {
-    soap_sticky = true;
+  const uint32_t count = info.next_seq - seq;
+
+  // httpd task only, like handle_status; off its 4 KB stack, which the
+  // float formatting below needs
+  static temp_history_bucket_t b[HISTORY_BATCH];
+  // One bucket is at most 1 + 3 × 3 bytes
+  static uint8_t cb[HISTORY_BATCH * 10 + 32];
+  cbor_enc_t e = CBOR_ENC_INIT(cb, sizeof(cb));
+  if (cbor) {
+    cbor_map(&e, 5);
+    cbor_uint(&e, HISTORY_CBOR_TIER);
+    cbor_uint(&e, (uint64_t)tier);
+    cbor_uint(&e, HISTORY_CBOR_BUCKET_MS);
+    cbor_uint(&e, info.bucket_ms);
+    cbor_uint(&e, HISTORY_CBOR_FIRST_SEQ);
+    cbor_uint(&e, seq);
+    cbor_uint(&e, HISTORY_CBOR_FIRST_EPOCH_S);
+    cbor_int(&e, history_epoch_s(&info, seq, now_epoch));
+    cbor_uint(&e, HISTORY_CBOR_BUCKETS);
+    cbor_array_open(&e);
+    httpd_resp_set_type(req, "application/cbor");
+    httpd_resp_send_chunk(req, (const char *)cb, e.len);
+  } else if (binary) {
+    uint8_t hdr[20];
+    const int32_t first_epoch = (int32_t)history_epoch_s(&info, seq, now_epoch);
+    memcpy(hdr, HISTORY_MAGIC, 3);
+    hdr[3] = (uint8_t)tier;
+    memcpy(&hdr[4], &info.bucket_ms, 4);
+    memcpy(&hdr[8], &seq, 4);
+    memcpy(&hdr[12], &count, 4);
+    memcpy(&hdr[16], &first_epoch, 4);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_send_chunk(req, (const char *)hdr, sizeof(hdr));
+  } else {
+    char line[96];
+    httpd_resp_set_type(req, "text/csv");
+    snprintf(line, sizeof(line),
+             "# tier=%d bucket_ms=%u first_seq=%u count=%u\n"
+             "epoch_s,min_f,max_f,mean_f\n",
+             tier, (unsigned)info.bucket_ms, (unsigned)seq, (unsigned)count);
+    httpd_resp_sendstr_chunk(req, line);
   }
-  httpd_resp_set_type(req, "application/json");
-  httpd_resp_sendstr_chunk(req, "{");
-  bool first = true;
-
-  snprintf(runbuf, sizeof(runbuf),
-           "%s->%s->%s Cycle %ld of %ld, step %ld of %ld", ActiveStatus.Program,
-           ActiveStatus.Cycle, ActiveStatus.Step, ActiveStatus.CycleIndex,
-           ActiveStatus.CyclesTotal, ActiveStatus.StepIndex,
-           ActiveStatus.StepsTotal);
-  json_prop_str(req, &first, "Program", runbuf);
-  json_prop_int(req, &first, "CurrentTemp", ActiveStatus.CurrentTemp);
-  char mm1[8], mm2[8], mm3[8], tstart[16], tend[16];
-
-  json_prop_str(req, &first, "since_start_mmss", ms_to_mmss(elapsed_ms, mm1));
-  json_prop_str(req, &first, "remaining_mmss", ms_to_mmss(remaining_ms, mm2));
-  json_prop_str(req, &first, "eta_finish_mmss", ms_to_mmss(remaining_ms, mm3));
-
-  format_est_time_ms(start_ms, tstart);
-  format_est_time_ms((start_ms > 0 && total_ms > 0) ? (start_ms + total_ms) : 0,
-                     tend);
-
-  json_prop_str(req, &first, "start_time_est", tstart);
-  json_prop_str(req, &first, "end_time_est", tend);
-  json_prop_bool(req, &first, "soap_has_dispensed", soap_sticky);
-
-  httpd_resp_sendstr_chunk(req, "}\n");
-  httpd_resp_send_chunk(req, NULL, 0);
-  return ESP_OK;
+
+  uint32_t sent = 0;
+  while (sent < count) {
+    uint32_t got_seq = 0;
+    size_t want = count - sent;
+    if (want > HISTORY_BATCH) {
+      want = HISTORY_BATCH;
+    }
+    size_t n = temp_history_read(tier, seq + sent, b, want, &got_seq);
+    if (n == 0 || got_seq != seq + sent) {
+      break; // ring overtook the reader; stop rather than emit a hole
+    }
+    if (cbor) {
+      cbor_reset(&e);
+      for (size_t i = 0; i < n; ++i) {
+        if (b[i].mean_df == TEMP_HISTORY_EMPTY) {
+          cbor_null(&e);
+        } else {
+          cbor_array(&e, 3);
+          cbor_int(&e, b[i].min_df);
+          cbor_int(&e, b[i].max_df);
+          cbor_int(&e, b[i].mean_df);
+        }
+      }
+      httpd_resp_send_chunk(req, (const char *)cb, e.len);
+    } else if (binary) {
+      httpd_resp_send_chunk(req, (const char *)b, n * sizeof(b[0]));
+    } else {
+      // Sized for typical lines; a batch of extreme ones goes out in
+      // more than one chunk
+      static char out[HISTORY_BATCH * 32];
+      char line[HISTORY_CSV_LINE_MAX];
+      size_t len = 0;
+      for (size_t i = 0; i < n; ++i) {
+        const long long ep =
+            (long long)history_epoch_s(&info, got_seq + i, now_epoch);
+        int w;
+        if (b[i].mean_df == TEMP_HISTORY_EMPTY) {
+          w = snprintf(line, sizeof(line), "%lld,,,\n", ep);
+        } else {
+          w = snprintf(line, sizeof(line), "%lld,%.1f,%.1f,%.1f\n", ep,
+                       b[i].min_df / 10.0, b[i].max_df / 10.0,
+                       b[i].mean_df / 10.0);
+        }
+        if (w <= 0 || (size_t)w >= sizeof(line)) {
+          continue; // cannot happen with the bound above
+        }
+        if (len + (size_t)w > sizeof(out)) {
+          httpd_resp_send_chunk(req, out, len);
+          len = 0;
+        }
+        memcpy(out + len, line, (size_t)w);
+        len += (size_t)w;
+      }
+      httpd_resp_send_chunk(req, out, len);
+    }
+    sent += n;
+  }
+  if (cbor) {
+    static const char brk = (char)0xff; // closes the bucket array
+    httpd_resp_send_chunk(req, &brk, 1);
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 // Program control helpers and stubs
@@ -232,29 +533,21 @@ static void set_program_name(const char *name) {
   ActiveStatus.Program[n] = '\0';
 }
 
-// Optional cooperative cancel hook — override elsewhere to signal your program
-// loop to exit gracefully
+// Cooperative cancel hook — run_program() checks the flag each time it wakes,
+// and the CANCEL action's bus event wakes it. Override to stop some other
+// program loop.
 __attribute__((weak)) void request_program_cancel(void) {
-  _LOG_W("request_program_cancel(): weak stub; override to signal your program "
-         "to stop");
+  ActiveStatus.CancelRequested = true;
 }
 
-static void run_program_trampoline(void *arg) {
-  (void)arg;
-  run_program(NULL);
-  s_program_task = NULL;
-  vTaskDelete(NULL);
-}
+static void run_program_trampoline(void *arg);
 
-static bool start_program_if_idle(const char *program_name) {
-  if (s_program_task && eTaskGetState(s_program_task) != eDeleted) {
-    _LOG_W("run_program already active; ignoring new start for %s",
-           program_name ? program_name : "<null>");
-    return false;
-  }
+// s_program_lock held, s_program_task NULL
+static bool spawn_program_locked(const char *program_name) {
   if (program_name) {
     set_program_name(program_name);
   }
+  // The handle is stored before the task can run
   if (xTaskCreate(run_program_trampoline, "run_program", RUN_PROGRAM_STACK,
                   NULL, ACTION_TASK_PRIO, &s_program_task) != pdPASS) {
     _LOG_E("failed to create run_program task");
@@ -264,31 +557,76 @@ static bool start_program_if_idle(const char *program_name) {
   return true;
 }
 
+// s_program_lock held: the run is over, start what CANCEL queued behind it
+static void run_ended_locked(void) {
+  s_program_task = NULL;
+  if (s_cancel_pending) {
+    s_cancel_pending = false;
+    esp_timer_stop(s_cancel_timer);
+    const char *next = s_next_program;
+    s_next_program = NULL;
+    (void)spawn_program_locked(next);
+  }
+}
+
+static void run_program_trampoline(void *arg) {
+  (void)arg;
+  run_program(NULL);
+  xSemaphoreTake(s_program_lock, portMAX_DELAY);
+  if (s_program_task == xTaskGetCurrentTaskHandle()) {
+    run_ended_locked();
+  }
+  xSemaphoreGive(s_program_lock);
+  vTaskDelete(NULL);
+}
+
+// esp_timer task: the cancelled run did not end in time
+static void cancel_timeout(void *arg) {
+  (void)arg;
+  xSemaphoreTake(s_program_lock, portMAX_DELAY);
+  if (s_cancel_pending && s_program_task) {
+    _LOG_W("program did not stop within %d ms — force deleting it",
+           PROGRAM_CANCEL_TIMEOUT_MS);
+    // Safe even if it is waiting on s_program_lock in the trampoline
+    vTaskDelete(s_program_task);
+    run_program_abandoned(); // LEDs, SSE and long-polls see the stop
+    run_ended_locked();
+  }
+  xSemaphoreGive(s_program_lock);
+}
+
+static bool start_program_if_idle(const char *program_name) {
+  xSemaphoreTake(s_program_lock, portMAX_DELAY);
+  const bool idle = (s_program_task == NULL);
+  const bool ok = idle && spawn_program_locked(program_name);
+  xSemaphoreGive(s_program_lock);
+  if (!idle) {
+    _LOG_W("run_program already active; ignoring new start for %s",
+           program_name ? program_name : "<null>");
+  }
+  return ok;
+}
+
+// Never waits for the running program: it is told to stop and program_name
+// starts when it has (or after PROGRAM_CANCEL_TIMEOUT_MS, when the
+// timer deletes it), so actions queued behind CANCEL run at once
 static bool cancel_and_start_program(const char *program_name) {
-  if (s_program_task && eTaskGetState(s_program_task) != eDeleted) {
+  bool ok = true;
+  xSemaphoreTake(s_program_lock, portMAX_DELAY);
+  if (!s_program_task) {
+    ok = spawn_program_locked(program_name);
+  } else if (s_cancel_pending) {
+    s_next_program = program_name; // a repeat: the latest start wins
+  } else {
     _LOG_I("cancel_and_start_program: requesting cancel of running program");
     request_program_cancel();
-    TickType_t start = xTaskGetTickCount();
-    const TickType_t timeout = pdMS_TO_TICKS(3000);
-    for (;;) {
-      eTaskState st = eTaskGetState(s_program_task);
-      if (st == eDeleted) {
-        break;
-      }
-      if ((xTaskGetTickCount() - start) > timeout) {
-        _LOG_W("cancel_and_start_program: cancel timeout — force deleting "
-               "program task");
-        vTaskDelete(s_program_task);
-        break;
-      }
-      vTaskDelay(pdMS_TO_TICKS(50));
-    }
-    s_program_task = NULL;
-  }
-  if (program_name) {
-    set_program_name(program_name);
+    s_cancel_pending = true;
+    s_next_program = program_name;
+    esp_timer_start_once(s_cancel_timer,
+                         PROGRAM_CANCEL_TIMEOUT_MS * 1000LL);
   }
-  return start_program_if_idle(program_name);
+  xSemaphoreGive(s_program_lock);
+  return ok;
 }
 
 // perform_action_<BUTTON>() stubs — CYCLE actions start program (guarded);
@@ -312,26 +650,33 @@ __attribute__((weak)) void perform_action_DO_RESUME(void) {
   _LOG_I("Action DO_RESUME");
 }
 
-__attribute__((weak)) void perform_action_DRAIN(void) {
-
-  _LOG_I("Action Toggle DRAIN");
-  gpio_mask_toggle(DRAIN);
+// Manual actuation never latches: switching an actor on arms an off timer
+// (ms from ?ms=, else ACTION_TOGGLE_DEFAULT_MS). Toggling an actor that is on
+// without ms switches it off; with ms it restarts the pulse.
+static void manual_toggle(uint64_t bit, const char *name, uint32_t ms) {
+  if ((actuator_get_mask() & bit) && ms == 0) {
+    _LOG_I("Action Toggle %s -> off", name);
+    actuator_clear(bit);
+    return;
+  }
+  const uint32_t on_ms = ms ? ms : ACTION_TOGGLE_DEFAULT_MS;
+  _LOG_I("Action Toggle %s -> on for %lu ms", name, (unsigned long)on_ms);
+  actuator_pulse(bit, on_ms);
 }
-__attribute__((weak)) void perform_action_FILL(void) {
-  gpio_mask_toggle(INLET);
-  _LOG_I("Action INLET");
+__attribute__((weak)) void perform_action_DRAIN(uint32_t ms) {
+  manual_toggle(DRAIN, "DRAIN", ms);
 }
-__attribute__((weak)) void perform_action_SPRAY(void) {
-  _LOG_I("Action SPRAY");
-  gpio_mask_toggle(SPRAY);
+__attribute__((weak)) void perform_action_FILL(uint32_t ms) {
+  manual_toggle(INLET, "INLET", ms);
 }
-__attribute__((weak)) void perform_action_HEAT(void) {
-  _LOG_I("Action HEAT");
-  gpio_mask_toggle(HEAT);
+__attribute__((weak)) void perform_action_SPRAY(uint32_t ms) {
+  manual_toggle(SPRAY, "SPRAY", ms);
 }
-__attribute__((weak)) void perform_action_SOAP(void) {
-  _LOG_I("Action SOAP");
-  gpio_mask_toggle(SOAP);
+__attribute__((weak)) void perform_action_HEAT(uint32_t ms) {
+  manual_toggle(HEAT, "HEAT", ms);
+}
+__attribute__((weak)) void perform_action_SOAP(uint32_t ms) {
+  manual_toggle(SOAP, "SOAP", ms);
 }
 
 __attribute__((weak)) void perform_action_LEDS(void) {
@@ -348,6 +693,7 @@ __attribute__((weak)) void perform_action_FIRMWARE(void) {
 }
 __attribute__((weak)) void perform_action_REBOOT(void) {
   _LOG_I("Action REBOOT");
+  actuator_usage_save();
   vTaskDelay(pdMS_TO_TICKS(200));
   esp_restart();
 }
@@ -357,7 +703,8 @@ __attribute__((weak)) void perform_action_SKIP_STEP(void) {
 }
 
 // Dispatch table from enum to perform_action_<BUTTON>()
-static void dispatch_action(actions_t a) {
+static bool dispatch_action(const action_req_t *r) {
+  const actions_t a = r->act;
   switch (a) {
   case ACTION_CYCLE_NORMAL:
     perform_action_NORMAL();
@@ -375,19 +722,19 @@ static void dispatch_action(actions_t a) {
     perform_action_DO_RESUME();
     break;
   case ACTION_TOGGLE_DRAIN:
-    perform_action_DRAIN();
+    perform_action_DRAIN(r->ms);
     break;
   case ACTION_TOGGLE_FILL:
-    perform_action_FILL();
+    perform_action_FILL(r->ms);
     break;
   case ACTION_TOGGLE_SPRAY:
-    perform_action_SPRAY();
+    perform_action_SPRAY(r->ms);
     break;
   case ACTION_TOGGLE_HEAT:
-    perform_action_HEAT();
+    perform_action_HEAT(r->ms);
     break;
   case ACTION_TOGGLE_SOAP:
-    perform_action_SOAP();
+    perform_action_SOAP(r->ms);
     break;
   case ACTION_TOGGLE_LEDS:
     perform_action_LEDS();
@@ -406,16 +753,59 @@ static void dispatch_action(actions_t a) {
     break;
   default:
     _LOG_W("Unknown action: %d", (int)a);
-    break;
+    return false;
   }
+  return true;
 }
 
+static void run_action(lane_t *lane, const action_req_t *r) {
+  const int64_t wait_us = esp_timer_get_time() - r->queued_us;
+  portENTER_CRITICAL(&s_action_mux);
+  latency_hist_record(&lane->wait, wait_us > (int64_t)UINT32_MAX
+                                       ? UINT32_MAX
+                                       : (uint32_t)wait_us);
+  portEXIT_CRITICAL(&s_action_mux);
+  action_track_start(r->id);
+  run_capture_action((int)r->act);
+  const bool ok = dispatch_action(r);
+  action_record_t rec;
+  action_track_finish(r->id, ok, &rec);
+  const int64_t now = esp_timer_get_time();
+  bus_event_t ev = {.type = BUS_EV_ACTION};
+  ev.action.action = (int16_t)r->act;
+  ev.action.ms = r->ms;
+  ev.action.ok = ok;
+  ev.action.id = r->id;
+  ev.action.wait_ms = action_record_wait_ms(&rec, now);
+  ev.action.run_ms = action_record_run_ms(&rec, now);
+  event_bus_publish(&ev);
+}
+
+// URGENT is emptied before each NORMAL action; the enqueuer notifies this
+// task after queueing to either lane
 static void action_worker(void *arg) {
   (void)arg;
+  lane_t *urgent = &s_lanes[ACTION_LANE_URGENT];
+  lane_t *normal = &s_lanes[ACTION_LANE_NORMAL];
+  for (;;) {
+    action_req_t r;
+    if (xQueueReceive(urgent->q, &r, 0) == pdTRUE) {
+      run_action(urgent, &r);
+    } else if (xQueueReceive(normal->q, &r, 0) == pdTRUE) {
+      run_action(normal, &r);
+    } else {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+}
+
+static void action_long_worker(void *arg) {
+  (void)arg;
+  lane_t *lane = &s_lanes[ACTION_LANE_LONG];
   for (;;) {
-    actions_t a;
-    if (xQueueReceive(s_action_queue, &a, portMAX_DELAY) == pdTRUE) {
-      dispatch_action(a);
+    action_req_t r;
+    if (xQueueReceive(lane->q, &r, portMAX_DELAY) == pdTRUE) {
+      run_action(lane, &r);
     }
   }
 }
@@ -426,24 +816,100 @@ typedef struct {
   const char *name;
   actions_t act;
 } route_t;
-static const route_t ROUTES[] = {
-    {"CYCLE", "NORMAL", ACTION_CYCLE_NORMAL},
-    {"CYCLE", "TESTER", ACTION_CYCLE_TESTER},
-    {"CYCLE", "HITEMP", ACTION_CYCLE_HITEMP},
-    {"DO", "PAUSE", ACTION_DO_PAUSE},
-    {"DO", "RESUME", ACTION_DO_RESUME},
-    {"TOGGLE", "DRAIN", ACTION_TOGGLE_DRAIN},
-    {"TOGGLE", "FILL", ACTION_TOGGLE_FILL},
-    {"TOGGLE", "SPRAY", ACTION_TOGGLE_SPRAY},
-    {"TOGGLE", "HEAT", ACTION_TOGGLE_HEAT},
-    {"TOGGLE", "SOAP", ACTION_TOGGLE_SOAP},
-    {"TOGGLE", "LEDS", ACTION_TOGGLE_LEDS},
-    {"ADMIN", "CANCEL", ACTION_ADMIN_CANCEL},
-    {"ADMIN", "FIRMWARE", ACTION_ADMIN_FIRMWARE},
-    {"ADMIN", "REBOOT", ACTION_ADMIN_REBOOT},
-    {"ADMIN", "SKIP_STEP", ACTION_ADMIN_SKIP_STEP}};
+#define ROUTE_ENTRY(group, name, token) {#group, #name, token},
+static const route_t ROUTES[] = {ACTIONS_TABLE(ROUTE_ENTRY)};
+#undef ROUTE_ENTRY
+#define NAME_ENTRY(group, name, token) [token] = #group "/" #name,
+static const char *const ACTION_NAMES[ACTION_MAX] = {ACTIONS_TABLE(NAME_ENTRY)};
+#undef NAME_ENTRY
+
+action_lane_t http_server_action_lane(actions_t a) {
+  return (a >= 0 && a < ACTION_MAX) ? ACTION_LANE[a] : ACTION_LANE_NORMAL;
+}
+
+const char *http_server_lane_name(action_lane_t lane) {
+  return (lane >= 0 && lane < ACTION_LANE_COUNT) ? LANE_NAME[lane] : "?";
+}
+
+const char *http_server_action_name(actions_t a) {
+  return (a >= 0 && a < ACTION_MAX && ACTION_NAMES[a]) ? ACTION_NAMES[a] : "?";
+}
+
+// GROUP and NAME as in /action/GROUP/NAME (lengths, not terminated)
+static const route_t *find_route(const char *group, size_t glen,
+                                 const char *name, size_t nlen) {
+  for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); ++i) {
+    if (strncmp(ROUTES[i].group, group, glen) == 0 &&
+        ROUTES[i].group[glen] == '\0' &&
+        strncmp(ROUTES[i].name, name, nlen) == 0 &&
+        ROUTES[i].name[nlen] == '\0') {
+      return &ROUTES[i];
+    }
+  }
+  return NULL;
+}
+
+bool http_server_enqueue_actions(const action_cmd_t *cmds, size_t n,
+                                 uint32_t *ids) {
+  if (!actions_ready()) {
+    _LOG_W("action queue not ready; dropping %u action(s)", (unsigned)n);
+    return false;
+  }
+  UBaseType_t need[ACTION_LANE_COUNT] = {0};
+  for (size_t i = 0; i < n; i++) {
+    need[http_server_action_lane(cmds[i].act)]++;
+  }
+  // Producers take turns here and the workers only take items out, so the
+  // space counted below is still there when the sends run
+  xSemaphoreTake(s_enqueue_lock, portMAX_DELAY);
+  bool fits = true;
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    fits = fits && uxQueueSpacesAvailable(s_lanes[l].q) >= need[l];
+  }
+  const int64_t now = esp_timer_get_time();
+  for (size_t i = 0; fits && i < n; i++) {
+    const uint32_t ms =
+        (cmds[i].ms > ACTION_PULSE_MAX_MS) ? ACTION_PULSE_MAX_MS : cmds[i].ms;
+    const action_req_t r = {.act = cmds[i].act,
+                            .ms = ms,
+                            .id = action_track_new(cmds[i].act, ms),
+                            .queued_us = now};
+    const action_lane_t lane = http_server_action_lane(r.act);
+    xQueueSend(s_lanes[lane].q, &r, 0);
+    if (ids) {
+      ids[i] = r.id;
+    }
+    _LOG_I("action %lu enqueued: %d ms=%lu lane=%s", (unsigned long)r.id,
+           (int)r.act, (unsigned long)r.ms, LANE_NAME[lane]);
+  }
+  xSemaphoreGive(s_enqueue_lock);
+  portENTER_CRITICAL(&s_action_mux);
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    if (fits) {
+      s_lanes[l].enqueued += need[l];
+    } else {
+      s_lanes[l].dropped += need[l];
+    }
+  }
+  portEXIT_CRITICAL(&s_action_mux);
+  if (!fits) {
+    _LOG_W("action lane full; dropping %u action(s)", (unsigned)n);
+    return false;
+  }
+  if (need[ACTION_LANE_URGENT] || need[ACTION_LANE_NORMAL]) {
+    xTaskNotifyGive(s_action_task);
+  }
+  _LOG_I("queue depth %u", queue_depth());
+  return true;
+}
+
+bool http_server_enqueue_action(actions_t a, uint32_t ms) {
+  const action_cmd_t c = {.act = a, .ms = ms};
+  return http_server_enqueue_actions(&c, 1, NULL);
+}
 
 // Wildcard POST /action/* → find GROUP/NAME in ROUTES
+// TOGGLE actions take ?ms=N: on for N ms, then off by timer
 static esp_err_t generic_action_handler(httpd_req_t *req) {
   const char *uri = req->uri;
   if (strncmp(uri, "/action/", 8) != 0) {
@@ -458,132 +924,319 @@ static esp_err_t generic_action_handler(httpd_req_t *req) {
   }
   size_t glen = (size_t)(slash - p);
   const char *name = slash + 1;
-  for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); ++i) {
-    if (strncmp(ROUTES[i].group, p, glen) == 0 &&
-        ROUTES[i].group[glen] == '\0' && strcmp(ROUTES[i].name, name) == 0) {
-      actions_t a = ROUTES[i].act;
-      if (!s_action_queue) {
-        httpd_resp_send_err(req, 503, "queue not ready");
-        return ESP_OK;
+  const size_t nlen = strcspn(name, "?");
+  uint32_t ms = 0;
+  char query[32];
+  char val[12];
+  if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+      httpd_query_key_value(query, "ms", val, sizeof(val)) == ESP_OK) {
+    ms = (uint32_t)strtoul(val, NULL, 10);
+  }
+  const route_t *route = find_route(p, glen, name, nlen);
+  if (!route) {
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "unknown action");
+    return ESP_OK;
+  }
+  if (!actions_ready()) {
+    httpd_resp_send_err(req, 503, "queue not ready");
+    return ESP_OK;
+  }
+  const action_cmd_t c = {.act = route->act, .ms = ms};
+  uint32_t id;
+  if (!http_server_enqueue_actions(&c, 1, &id)) {
+    httpd_resp_send_err(req, 503, "queue full");
+    return ESP_OK;
+  }
+  char loc[24];
+  snprintf(loc, sizeof(loc), "/actions/%lu", (unsigned long)id);
+  httpd_resp_set_hdr(req, "Location", loc);
+  httpd_resp_sendstr(req, "OK\n");
+  return ESP_OK;
+}
+
+static const char *skip_ws(const char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+    p++;
+  }
+  return p;
+}
+
+// A JSON string without escapes; returns the position after it, or NULL
+static const char *parse_str(const char *p, const char **s, size_t *n) {
+  if (*p != '"') {
+    return NULL;
+  }
+  const char *start = ++p;
+  while (*p && *p != '"' && *p != '\\') {
+    p++;
+  }
+  if (*p != '"') {
+    return NULL;
+  }
+  *s = start;
+  *n = (size_t)(p - start);
+  return p + 1;
+}
+
+// "GROUP/NAME" -> ROUTES entry
+static const route_t *find_route_path(const char *s, size_t n) {
+  const char *slash = memchr(s, '/', n);
+  if (!slash) {
+    return NULL;
+  }
+  const size_t glen = (size_t)(slash - s);
+  return find_route(s, glen, slash + 1, n - glen - 1);
+}
+
+// One batch item: "GROUP/NAME" or {"action":"GROUP/NAME","ms":N}
+static const char *parse_item(const char *p, action_cmd_t *out) {
+  const route_t *route = NULL;
+  const char *s;
+  size_t n;
+  out->ms = 0;
+  if (*p == '"') {
+    p = parse_str(p, &s, &n);
+    if (!p) {
+      return NULL;
+    }
+    route = find_route_path(s, n);
+  } else if (*p == '{') {
+    p = skip_ws(p + 1);
+    while (*p != '}') {
+      const char *key;
+      size_t klen;
+      p = parse_str(p, &key, &klen);
+      if (!p) {
+        return NULL;
       }
-      if (xQueueSend(s_action_queue, &a, 0) != pdTRUE) {
-        _LOG_W("action queue full; dropping %d", (int)a);
-        httpd_resp_send_err(req, 503, "queue full");
-        return ESP_OK;
+      p = skip_ws(p);
+      if (*p != ':') {
+        return NULL;
+      }
+      p = skip_ws(p + 1);
+      if (klen == 6 && strncmp(key, "action", 6) == 0) {
+        p = parse_str(p, &s, &n);
+        if (!p) {
+          return NULL;
+        }
+        route = find_route_path(s, n);
+      } else if (klen == 2 && strncmp(key, "ms", 2) == 0) {
+        if (*p < '0' || *p > '9') {
+          return NULL;
+        }
+        char *end;
+        out->ms = (uint32_t)strtoul(p, &end, 10);
+        p = end;
+      } else {
+        return NULL;
+      }
+      p = skip_ws(p);
+      if (*p == ',') {
+        p = skip_ws(p + 1);
+      } else if (*p != '}') {
+        return NULL;
       }
-      unsigned depth = queue_depth();
-      _LOG_I("action enqueued: %d (queue depth %u)", (int)a, depth);
-      httpd_resp_sendstr(req, "OK\n");
-      return ESP_OK;
     }
+    p++;
+  } else {
+    return NULL;
   }
-  httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "unknown action");
-  return ESP_OK;
+  if (!route) {
+    return NULL;
+  }
+  out->act = route->act;
+  return p;
 }
 
-// Root UI with grouped buttons and 95% width status viewport
-static esp_err_t root_get_handler(httpd_req_t *req) {
-  httpd_resp_set_type(req, "text/html");
-
-  const char *ip = ActiveStatus.IPAddress;
-  char titlebuf[160];
-  snprintf(titlebuf, sizeof(titlebuf), "Dishwasher Controller: %s %s", VERSION,
-           ip);
-
-  httpd_resp_sendstr_chunk(
-      req,
-      "<!doctype html><html><head>"
-      "<meta charset=\"utf-8\">"
-      "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-      "<title>");
-  httpd_resp_sendstr_chunk(req, titlebuf);
-  httpd_resp_sendstr_chunk(
-      req, "</title>"
-           "<style>"
-           "body{font-family:sans-serif;margin:1rem}"
-           ".row{margin:0.75rem 0}"
-           ".btn{padding:0.6rem 1rem;margin:0.25rem;border:1px solid "
-           "#ccc;border-radius:10px;cursor:pointer}"
-           ".btn.pushed{background:#ddd}"
-
-           "#status{width:95%;height:16rem;border:1px solid "
-           "#ccc;padding:0.5rem;overflow:auto}"
-           "#statTable{width:100%;border-collapse:collapse}"
-           "#statTable th,#statTable td{border:1px solid #ccc;padding:4px "
-           "8px;text-align:left;vertical-align:top}"
-           "#statTable th{background:#f5f5f5;width:36ch}"
-           "</style></head><body>");
-  httpd_resp_sendstr_chunk(req, "<h2>");
-  httpd_resp_sendstr_chunk(req, titlebuf);
-  httpd_resp_sendstr_chunk(req, "</h2>");
-  const char *current_group = NULL;
-  for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); ++i) {
-    const route_t *r = &ROUTES[i];
-    if (!current_group || strcmp(current_group, r->group) != 0) {
-      if (current_group) {
-        httpd_resp_sendstr_chunk(req, "</div>");
+// JSON array of items; returns the count, or -1 with *bad set to the index
+// of the item that did not parse
+static int parse_batch(const char *p, action_cmd_t *out, int max, int *bad) {
+  int n = 0;
+  *bad = 0;
+  p = skip_ws(p);
+  if (*p != '[') {
+    return -1;
+  }
+  p = skip_ws(p + 1);
+  while (*p != ']') {
+    *bad = n;
+    if (n == max || !(p = parse_item(p, &out[n]))) {
+      return -1;
+    }
+    n++;
+    p = skip_ws(p);
+    if (*p == ',') {
+      p = skip_ws(p + 1);
+      if (*p == ']') {
+        return -1;
       }
-      httpd_resp_sendstr_chunk(req,
-                               "<div class=\"row\"><span class=\"group\">");
-      httpd_resp_sendstr_chunk(req, r->group);
-      httpd_resp_sendstr_chunk(req, ":</span>");
-      current_group = r->group;
+    } else if (*p != ']') {
+      return -1;
     }
-    httpd_resp_sendstr_chunk(req, "<button class=\"btn\" data-uri=\"/action/");
-    httpd_resp_sendstr_chunk(req, r->group);
-    httpd_resp_sendstr_chunk(req, "/");
-    httpd_resp_sendstr_chunk(req, r->name);
-    httpd_resp_sendstr_chunk(req, "\">");
-    httpd_resp_sendstr_chunk(req, r->name);
-    httpd_resp_sendstr_chunk(req, "</button>");
-  }
-  if (current_group) {
-    httpd_resp_sendstr_chunk(req, "</div>");
-  }
-  httpd_resp_sendstr_chunk(
-      req,
-      "<h3>Status</h3><div id=\"status\"><table id=\"statTable\"></table></div>"
-      "<script>"
-      "const statTable=document.getElementById('statTable');"
-      "function esc(s){return "
-      "String(s).replace(/&/g,'&amp;').replace(/</g,'&lt;');}"
-      "function renderStatus(d){"
-      "const keys=Object.keys(d).sort();"
-      "let html='';"
-      "for(let i=0;i<keys.length;i++){"
-      "const k=keys[i];"
-      "let v=d[k];"
-      "if(v===null||v===undefined){v='';}"
-      "else if(typeof "
-      "v==='object'){try{v=JSON.stringify(v);}catch(_){v=String(v);}}"
-      "html+='<tr><th>'+esc(k)+'</th><td>'+esc(v)+'</td></tr>';"
-      "}"
-      "statTable.innerHTML=html;"
-      "}"
-      "async function refresh(){try{const r=await fetch('/status');const "
-      "j=await "
-      "r.json();renderStatus(j);}catch(e){statTable.innerHTML='<tr><td>(error "
-      "fetching /status)</td></tr>';}}"
-      "function "
-      "pushMark(btn){btn.classList.add('pushed');setTimeout(()=>btn.classList."
-      "remove('pushed'),2000);}"
-      "async function fire(uri,btn){pushMark(btn);try{await "
-      "fetch(uri,{method:'POST'});}catch(e){} setTimeout(refresh,1000);}"
-      "document.querySelectorAll('.btn').forEach(b=>b.addEventListener('click',"
-      "()=>fire(b.dataset.uri,b)));"
-      "setInterval(refresh,10000);refresh();"
-      "</script></body></html>");
-  return httpd_resp_sendstr_chunk(req, NULL);
+  }
+  *bad = n;
+  return *skip_ws(p + 1) == '\0' ? n : -1;
 }
 
+// POST /actions: JSON array of "GROUP/NAME" or {"action":..., "ms":...}.
+// All of the batch is queued back to back, or none of it; the reply lists
+// one id per item for GET /actions/<id>.
+static esp_err_t handle_actions_post(httpd_req_t *req) {
+  if (req->content_len == 0 || req->content_len > ACTIONS_BODY_MAX) {
+    char msg[64];
+    drain_body(req);
+    snprintf(msg, sizeof(msg), "body must be a JSON array of up to %d bytes",
+             ACTIONS_BODY_MAX);
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+    return ESP_OK;
+  }
+  char body[ACTIONS_BODY_MAX + 1];
+  size_t got = 0;
+  int timeouts = 0;
+  while (got < req->content_len) {
+    const int r = httpd_req_recv(req, body + got, req->content_len - got);
+    // One slow segment is retried; a client that stops sending would
+    // otherwise hold the only httpd task
+    if (r == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < ACTIONS_BODY_TIMEOUTS) {
+      continue;
+    }
+    if (r <= 0) {
+      return ESP_FAIL;
+    }
+    got += (size_t)r;
+  }
+  body[got] = '\0';
+
+  action_cmd_t cmds[HTTP_ACTIONS_BATCH_MAX];
+  int bad;
+  const int n = parse_batch(body, cmds, HTTP_ACTIONS_BATCH_MAX, &bad);
+  if (n <= 0) {
+    char msg[64];
+    if (n == 0) {
+      snprintf(msg, sizeof(msg), "empty batch");
+    } else if (bad == HTTP_ACTIONS_BATCH_MAX) {
+      snprintf(msg, sizeof(msg), "at most %d actions per batch",
+               HTTP_ACTIONS_BATCH_MAX);
+    } else {
+      snprintf(msg, sizeof(msg), "item %d is not an action", bad);
+    }
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, msg);
+    return ESP_OK;
+  }
+  uint32_t ids[HTTP_ACTIONS_BATCH_MAX];
+  if (!http_server_enqueue_actions(cmds, (size_t)n, ids)) {
+    httpd_resp_send_err(req, 503, "queue full; nothing queued");
+    return ESP_OK;
+  }
+  char out[16 + HTTP_ACTIONS_BATCH_MAX * 11];
+  size_t len = (size_t)snprintf(out, sizeof(out), "{\"ids\":[");
+  for (int i = 0; i < n; i++) {
+    len += (size_t)snprintf(out + len, sizeof(out) - len, "%s%lu",
+                            i ? "," : "", (unsigned long)ids[i]);
+  }
+  len += (size_t)snprintf(out + len, sizeof(out) - len, "]}\n");
+  httpd_resp_set_status(req, "202 Accepted");
+  httpd_resp_set_type(req, "application/json");
+  return httpd_resp_send(req, out, (ssize_t)len);
+}
+
+// GET /actions/<id>: state and timing of one queued action
+static esp_err_t handle_action_get(httpd_req_t *req) {
+  const char *p = req->uri + strlen("/actions/");
+  char *end;
+  const unsigned long id = strtoul(p, &end, 10);
+  action_record_t r;
+  if (end == p || (*end && *end != '?') ||
+      !action_track_get((uint32_t)id, &r)) {
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "unknown or expired id");
+    return ESP_OK;
+  }
+  const int64_t now = esp_timer_get_time();
+  char out[192];
+  const int len = snprintf(
+      out, sizeof(out),
+      "{\"id\":%lu,\"action\":\"%s\",\"ms\":%lu,\"state\":\"%s\","
+      "\"age_ms\":%lld,\"wait_ms\":%lu,\"run_ms\":%lu}\n",
+      id, http_server_action_name((actions_t)r.act), (unsigned long)r.ms,
+      action_state_name(r.state), (long long)((now - r.queued_us) / 1000),
+      (unsigned long)action_record_wait_ms(&r, now),
+      (unsigned long)action_record_run_ms(&r, now));
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, out, len);
+}
+
+// Root UI: main/web/index.html with the ACTIONS_TABLE buttons filled in and
+// gzipped at build time (main/CMakeLists.txt), sent straight from flash.
+// The page only changes with the firmware, so the version is its ETag.
+static esp_err_t root_get_handler(httpd_req_t *req) {
+  static const char etag[] = "\"" VERSION "\"";
+  char inm[32];
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) ==
+          ESP_OK &&
+      strcmp(inm, etag) == 0) {
+    httpd_resp_set_status(req, "304 Not Modified");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    return httpd_resp_send(req, NULL, 0);
+  }
+  httpd_resp_set_type(req, "text/html");
+  httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  httpd_resp_set_hdr(req, "ETag", etag);
+  // Revalidate every load: a reflash keeps the URL but changes the page
+  httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+  return httpd_resp_send(req, (const char *)index_html_gz_start,
+                         index_html_gz_end - index_html_gz_start);
+}
+
+// /events and long-polls are bounded by their own slot counts, the page and
+// /metrics are fetched rarely; only the pollable reads and actions are
+// rate limited per client
+static const timed_route_t TIMED_STATUS = {handle_status, HTTP_ROUTE_STATUS,
+                                           HTTP_RATE_STATUS};
+static const timed_route_t TIMED_HISTORY = {handle_history, HTTP_ROUTE_HISTORY,
+                                            HTTP_RATE_STATUS};
+static const timed_route_t TIMED_ACTION = {
+    generic_action_handler, HTTP_ROUTE_ACTION, HTTP_RATE_ACTION};
+static const timed_route_t TIMED_ROOT = {root_get_handler, HTTP_ROUTE_ROOT,
+                                         HTTP_RATE_NONE};
+static const timed_route_t TIMED_ACTUATORS = {
+    handle_actuators, HTTP_ROUTE_ACTUATORS, HTTP_RATE_STATUS};
+static const timed_route_t TIMED_EVENTS = {
+    http_events_handler, HTTP_ROUTE_EVENTS, HTTP_RATE_NONE};
+static const timed_route_t TIMED_METRICS = {metrics_handler,
+                                            HTTP_ROUTE_METRICS, HTTP_RATE_NONE};
+static const timed_route_t TIMED_ACTIONS_POST = {
+    handle_actions_post, HTTP_ROUTE_ACTIONS, HTTP_RATE_ACTION};
+static const timed_route_t TIMED_ACTION_GET = {
+    handle_action_get, HTTP_ROUTE_ACTIONS, HTTP_RATE_STATUS};
+
 void start_webserver(void) {
   if (s_server) {
     return;
   }
-  if (!s_action_queue) {
-    s_action_queue = xQueueCreate(ACTION_QUEUE_LEN, sizeof(actions_t));
-    if (!s_action_queue) {
-      _LOG_E("failed to create action queue");
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    if (!s_lanes[l].q) {
+      s_lanes[l].q = xQueueCreate(LANE_LEN[l], sizeof(action_req_t));
+      if (!s_lanes[l].q) {
+        _LOG_E("failed to create %s action queue", LANE_NAME[l]);
+        return;
+      }
+    }
+  }
+  if (!s_enqueue_lock) {
+    s_enqueue_lock = xSemaphoreCreateMutex();
+    if (!s_enqueue_lock) {
+      _LOG_E("failed to create action queue lock");
+      return;
+    }
+  }
+  if (!s_program_lock) {
+    s_program_lock = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t cancel_args = {.callback = cancel_timeout,
+                                                 .name = "prog_cancel"};
+    if (!s_program_lock ||
+        esp_timer_create(&cancel_args, &s_cancel_timer) != ESP_OK) {
+      _LOG_E("failed to create program lock or cancel timer");
       return;
     }
   }
@@ -594,8 +1247,29 @@ void start_webserver(void) {
       return;
     }
   }
+  if (!s_long_task) {
+    if (xTaskCreate(action_long_worker, "action_long", ACTION_TASK_STACK, NULL,
+                    ACTION_LONG_TASK_PRIO, &s_long_task) != pdPASS) {
+      _LOG_E("failed to create action_long");
+      return;
+    }
+  }
+  if (status_cache_init() != ESP_OK) {
+    _LOG_E("failed to create status cache locks");
+    return;
+  }
+  if (status_watch_start() != ESP_OK) {
+    _LOG_W("status long-poll unavailable; ?since= answers at once");
+  }
   httpd_config_t config = HTTPD_DEFAULT_CONFIG();
   config.uri_match_fn = httpd_uri_match_wildcard;
+  config.max_uri_handlers = 16; // default 8 is already taken
+  // http_conn.c purges idle sessions itself so it can spare the pinned
+  // /events streams and long-polls; httpd's own LRU purge stays off
+  config.max_open_sockets = HTTP_CONN_MAX_OPEN;
+  config.lru_purge_enable = false;
+  config.open_fn = http_conn_open;
+  config.close_fn = http_conn_close;
   if (httpd_start(&s_server, &config) != ESP_OK) {
     _LOG_E("httpd_start failed");
     s_server = NULL;
@@ -604,18 +1278,58 @@ void start_webserver(void) {
   // GET only for root and /status
   httpd_uri_t status_get = {.uri = "/status",
                             .method = HTTP_GET,
-                            .handler = handle_status,
-                            .user_ctx = NULL};
+                            .handler = timed_handler,
+                            .user_ctx = (void *)&TIMED_STATUS};
   httpd_register_uri_handler(s_server, &status_get);
+  httpd_uri_t status_cbor_get = {.uri = "/status.cbor",
+                                 .method = HTTP_GET,
+                                 .handler = timed_handler,
+                                 .user_ctx = (void *)&TIMED_STATUS};
+  httpd_register_uri_handler(s_server, &status_cbor_get);
+  httpd_uri_t history_get = {.uri = "/history",
+                             .method = HTTP_GET,
+                             .handler = timed_handler,
+                             .user_ctx = (void *)&TIMED_HISTORY};
+  httpd_register_uri_handler(s_server, &history_get);
+  httpd_uri_t history_cbor_get = {.uri = "/history.cbor",
+                                  .method = HTTP_GET,
+                                  .handler = timed_handler,
+                                  .user_ctx = (void *)&TIMED_HISTORY};
+  httpd_register_uri_handler(s_server, &history_cbor_get);
+  httpd_uri_t actuators_get = {.uri = "/actuators",
+                               .method = HTTP_GET,
+                               .handler = timed_handler,
+                               .user_ctx = (void *)&TIMED_ACTUATORS};
+  httpd_register_uri_handler(s_server, &actuators_get);
+  httpd_uri_t events_get = {.uri = "/events",
+                            .method = HTTP_GET,
+                            .handler = timed_handler,
+                            .user_ctx = (void *)&TIMED_EVENTS};
+  httpd_register_uri_handler(s_server, &events_get);
+  httpd_uri_t metrics_get = {.uri = "/metrics",
+                             .method = HTTP_GET,
+                             .handler = timed_handler,
+                             .user_ctx = (void *)&TIMED_METRICS};
+  httpd_register_uri_handler(s_server, &metrics_get);
   httpd_uri_t action_post = {.uri = "/action/*",
                              .method = HTTP_POST,
-                             .handler = generic_action_handler,
-                             .user_ctx = NULL};
+                             .handler = timed_handler,
+                             .user_ctx = (void *)&TIMED_ACTION};
   httpd_register_uri_handler(s_server, &action_post);
+  httpd_uri_t actions_post = {.uri = "/actions",
+                              .method = HTTP_POST,
+                              .handler = timed_handler,
+                              .user_ctx = (void *)&TIMED_ACTIONS_POST};
+  httpd_register_uri_handler(s_server, &actions_post);
+  httpd_uri_t action_get = {.uri = "/actions/*",
+                            .method = HTTP_GET,
+                            .handler = timed_handler,
+                            .user_ctx = (void *)&TIMED_ACTION_GET};
+  httpd_register_uri_handler(s_server, &action_get);
   httpd_uri_t root_get = {.uri = "/",
                           .method = HTTP_GET,
-                          .handler = root_get_handler,
-                          .user_ctx = NULL};
+                          .handler = timed_handler,
+                          .user_ctx = (void *)&TIMED_ROOT};
   httpd_register_uri_handler(s_server, &root_get);
   _LOG_I("webserver started");
 }
@@ -627,3 +1341,35 @@ void stop_webserver(void) {
   s_server = NULL;
 }
 bool http_server_is_running(void) { return s_server != NULL; }
+
+void http_server_get_lane_stats(action_lane_t lane, action_lane_stats_t *out) {
+  if (lane < 0 || lane >= ACTION_LANE_COUNT) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  out->depth =
+      s_lanes[lane].q ? (uint32_t)uxQueueMessagesWaiting(s_lanes[lane].q) : 0;
+  portENTER_CRITICAL(&s_action_mux);
+  out->enqueued = s_lanes[lane].enqueued;
+  out->dropped = s_lanes[lane].dropped;
+  out->wait = s_lanes[lane].wait;
+  portEXIT_CRITICAL(&s_action_mux);
+}
+
+void http_server_get_latency(http_route_t route, latency_hist *out) {
+  if (!out) {
+    return;
+  }
+  if (route < HTTP_ROUTE_MAX) {
+    portENTER_CRITICAL(&s_latency_mux);
+    *out = s_latency[route];
+    portEXIT_CRITICAL(&s_latency_mux);
+    return;
+  }
+  latency_hist_clear(out);
+  for (int r = 0; r < HTTP_ROUTE_MAX; ++r) {
+    portENTER_CRITICAL(&s_latency_mux);
+    latency_hist_merge(out, &s_latency[r]);
+    portEXIT_CRITICAL(&s_latency_mux);
+  }
+}
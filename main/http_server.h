@@ -3,7 +3,11 @@
 extern "C" {
 #endif
 
+#include "histogram.h"
+#include "status_json.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // ──────────────────────────────────────────────────────────────────────────────
 // Actions API (grouped) — uses your explicit enum and an ACTIONS_TABLE mapping
@@ -36,7 +40,8 @@ typedef enum {
   ACTION_MAX
 } actions_t;
 
-// Mapping used to generate UI groups, routes and dispatch switch
+// Mapping used to generate UI groups, routes and dispatch switch; also parsed
+// by main/web/gen_index.py at build time for the embedded page's buttons
 #ifndef ACTIONS_TABLE
 #define ACTIONS_TABLE(XX)                                                          \
     /* GROUP ,   NAME         , TOKEN */                                           \
@@ -52,7 +57,7 @@ typedef enum {
     XX(TOGGLE, SOAP           , ACTION_TOGGLE_SOAP)                                \
     XX(TOGGLE, LEDS           , ACTION_TOGGLE_LEDS)                                \
     XX(ADMIN , CANCEL         , ACTION_ADMIN_CANCEL)                               \
-    XX(ADMIN , FIRMWAREUPDATE , ACTION_ADMIN_FIRMWAREUPDATE)                       \
+    XX(ADMIN , FIRMWARE       , ACTION_ADMIN_FIRMWARE)                             \
     XX(ADMIN , REBOOT         , ACTION_ADMIN_REBOOT)                               \
     XX(ADMIN , SKIP_STEP      , ACTION_ADMIN_SKIP_STEP)
 #endif
@@ -64,6 +69,69 @@ void stop_webserver(void);
 // Utility so other modules can query
 bool http_server_is_running(void);
 
+// Queue an action for its lane (same path as POST /action/...). Never
+// waits for room; false before start_webserver() or when the lane is full. ms is
+// the on-time for TOGGLE actions (0 = default auto-off), ignored otherwise.
+bool http_server_enqueue_action(actions_t a, uint32_t ms);
+
+// One queued command, as read from a POST /actions batch
+typedef struct {
+  actions_t act;
+  uint32_t ms;
+} action_cmd_t;
+
+#define HTTP_ACTIONS_BATCH_MAX 8
+
+// Queue all n commands back to back, or none when a lane cannot take
+// its share. ids (optional, n entries) gets each one's action_track.h id.
+bool http_server_enqueue_actions(const action_cmd_t *cmds, size_t n,
+                                 uint32_t *ids);
+
+// "GROUP/NAME" as in the /action/ URIs; "?" when out of range
+const char *http_server_action_name(actions_t a);
+
+// Snapshot of everything /status reports (zeroes v first). Latency is only
+// filled when with_latency is set, which status_cache.c alone does.
+void http_server_fill_status(status_view_t *v, bool with_latency);
+
+// Actions are queued by lane. action_worker takes URGENT before NORMAL, so
+// cancel/skip/pause jump anything waiting; LONG actions (LED test, OTA) run
+// on their own worker so they hold up nothing else. Order is kept within a
+// lane only.
+typedef enum {
+  ACTION_LANE_NORMAL = 0, // cycles, manual toggles
+  ACTION_LANE_URGENT,     // cancel, skip step, pause/resume, reboot
+  ACTION_LANE_LONG,       // LED test, firmware update
+  ACTION_LANE_COUNT
+} action_lane_t;
+
+typedef struct {
+  uint32_t depth;    // waiting now
+  uint32_t enqueued; // accepted since boot
+  uint32_t dropped;  // rejected because the lane was full
+  latency_hist wait; // µs from enqueue to start
+} action_lane_stats_t;
+
+action_lane_t http_server_action_lane(actions_t a);
+const char *http_server_lane_name(action_lane_t lane); // "normal", ...
+void http_server_get_lane_stats(action_lane_t lane, action_lane_stats_t *out);
+
+// Handler latency (µs from handler entry to return), per registered route
+typedef enum {
+  HTTP_ROUTE_STATUS,
+  HTTP_ROUTE_HISTORY,
+  HTTP_ROUTE_ACTION,
+  HTTP_ROUTE_ROOT,
+  HTTP_ROUTE_ACTUATORS,
+  HTTP_ROUTE_EVENTS, // stream setup only; the stream runs detached
+  HTTP_ROUTE_METRICS,
+  HTTP_ROUTE_ACTIONS, // POST /actions and GET /actions/<id>
+  HTTP_ROUTE_MAX
+} http_route_t;
+
+// Copy one route's histogram; HTTP_ROUTE_MAX merges all routes
+void http_server_get_latency(http_route_t route, latency_hist *out);
+
 #ifdef __cplusplus
 }
 #endif
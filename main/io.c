@@ -1,15 +1,17 @@
 // io.c — one-GPIO-per-device (Preset C)
 
-#include <stdlib.h>
 #include <string.h>
 #include <strings.h> // strcasecmp
 
 #include "driver/gpio.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "soc/gpio_reg.h"
 
 #include "dishwasher_programs.h"
 #include "io.h"
+#include "io_pcf8574.h"
 
 // ===== Pin maps (enum -> GPIO) =====
 static const gpio_num_t LED_GPIO[IO_LED_COUNT] = {
@@ -24,29 +26,66 @@ static const gpio_num_t SW_GPIO[IO_SW_COUNT] = {
   IO_PIN_SW_START,        // IO_SW_START
   IO_PIN_SW_CANCEL,       // IO_SW_CANCEL
   IO_PIN_SW_DELAY,        // IO_SW_DELAY
-  
+  IO_PIN_SW_QUICK_RINSE,  // IO_SW_QUICK_RINSE
 };
 
+// LEDs driven by native GPIO (the rest sit on the PCF8574)
+#define LED_ALL_BITS ((uint8_t)((1u << IO_LED_COUNT) - 1))
+#if IO_USE_PCF8574
+#define LED_PCF_BITS ((uint8_t)((1u << IO_PCF_LED_COUNT) - 1))
+#else
+#define LED_PCF_BITS ((uint8_t)0)
+#endif
+#define LED_NATIVE_BITS ((uint8_t)(LED_ALL_BITS & ~LED_PCF_BITS))
+
 // ===== Basic LED/Switch helpers =====
+// LED levels live in the pattern engine below; a direct set takes the LED
+// away from any pattern that was driving it.
+static void led_set_bits(uint8_t bits, bool on);
+
 void io_led_set(io_led_t led, bool on) {
   if ((int)led < 0 || led >= IO_LED_COUNT) return;
-  gpio_set_level(LED_GPIO[led], on ? 1 : 0);
+  led_set_bits((uint8_t)(1u << led), on);
 }
 
 void io_led_toggle(io_led_t led) {
   if ((int)led < 0 || led >= IO_LED_COUNT) return;
-  int cur = gpio_get_level(LED_GPIO[led]);
-  gpio_set_level(LED_GPIO[led], !cur);
+  led_set_bits((uint8_t)(1u << led), !io_led_get(led));
 }
 
 bool io_switch_pressed(io_switch_t sw) {
   if ((int)sw < 0 || sw >= IO_SW_COUNT) return false;
   // Active-low: pressed when 0
+#if IO_USE_PCF8574
+  return ((pcf_io_inputs() >> (IO_PCF_SW_SHIFT + sw)) & 1u) == 0;
+#else
   return gpio_get_level(SW_GPIO[sw]) == 0;
+#endif
 }
 
 // ===== Initialization =====
 esp_err_t io_init_onepin(void) {
+#if IO_USE_PCF8574
+  // Native: control_lock only. Expander: switches as inputs (released
+  // high), status LEDs OFF (high, active-low).
+  gpio_config_t led_cfg = {
+    .pin_bit_mask = 1ULL << IO_PIN_LED_CONTROL_LOCK,
+    .mode         = GPIO_MODE_OUTPUT,
+    .pull_up_en   = GPIO_PULLUP_DISABLE,
+    .pull_down_en = GPIO_PULLDOWN_DISABLE,
+    .intr_type    = GPIO_INTR_DISABLE
+  };
+  ESP_ERROR_CHECK(gpio_config(&led_cfg));
+  const uint8_t sw_bits = (uint8_t)(((1u << IO_SW_COUNT) - 1) << IO_PCF_SW_SHIFT);
+  const uint8_t led_off = (uint8_t)(LED_PCF_BITS << IO_PCF_LED_SHIFT);
+  esp_err_t err = pcf_io_init(sw_bits, led_off);
+  if (err != ESP_OK) return err;
+  io_led_pattern_stop(LED_ALL_BITS); // all OFF
+
+  _LOG_I("UI on PCF8574: 4 switches (P0-P3), 4 LEDs (P4-P7), control_lock on %d",
+         IO_PIN_LED_CONTROL_LOCK);
+  return ESP_OK;
+#else
   // LEDs as outputs (start OFF)
   const uint64_t led_mask =
       (1ULL << IO_PIN_LED_STATUS_WASHING) |
@@ -63,7 +102,7 @@ esp_err_t io_init_onepin(void) {
     .intr_type    = GPIO_INTR_DISABLE
   };
   ESP_ERROR_CHECK(gpio_config(&led_cfg));
-  for (int i = 0; i < IO_LED_COUNT; ++i) gpio_set_level(LED_GPIO[i], 0);
+  io_led_pattern_stop(LED_ALL_BITS); // all OFF
 
   // Switches as inputs with internal pull-ups
   const uint64_t sw_mask =
@@ -83,6 +122,7 @@ esp_err_t io_init_onepin(void) {
 
   _LOG_I("UI pins ready: 4 switches (16,17,18,19), 5 LEDs (21,22,23,13,14)");
   return ESP_OK;
+#endif
 }
 
 // ===== Name lookup for blink API =====
@@ -105,41 +145,193 @@ static bool name_to_led(const char *name, io_led_t *out) {
   return false;
 }
 
-// ===== Non-blocking per-LED blinker =====
+// ===== LED pattern engine =====
+// One esp_timer tick advances every active pattern, composes the LED bits and
+// writes them with a single W1TS/W1TC pair (all LED pins are in GPIO bank 0).
+// The timer only runs while a pattern is active.
+#define IO_LED_PATTERN_SLOTS 4
+
 typedef struct {
-  io_led_t   led;
-  uint32_t   on_ms;
-  uint32_t   off_ms;
-  int        count;     // 0 = infinite
-} blink_args_t;
+  const io_led_step_t *steps;
+  size_t   n;
+  size_t   idx;
+  int32_t  left_ms;   // time left in the current step (carries remainders)
+  int      repeat;    // passes left; 0 = forever
+  uint8_t  owned;     // LEDs this pattern drives
+  io_led_step_t inline_steps[2]; // storage for LED_Blink() patterns
+} led_pattern_t;
+
+static led_pattern_t s_pat[IO_LED_PATTERN_SLOTS];
+static uint8_t s_led_base = 0;       // levels of LEDs no pattern owns
+static uint8_t s_led_written = 0;    // last bits written to the pins
+static bool s_led_written_valid = false;
+static volatile bool s_led_pcf_dirty = false; // staged, not yet committed
+static esp_timer_handle_t s_led_timer = NULL;
+static portMUX_TYPE s_led_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t led_bits_to_gpio(uint8_t bits) {
+  uint32_t m = 0;
+  for (int i = 0; i < IO_LED_COUNT; ++i) {
+    if (bits & (1u << i)) m |= (1u << LED_GPIO[i]);
+  }
+  return m;
+}
+
+// Compose and write; caller holds s_led_mux
+static void led_flush_locked(void) {
+  uint8_t bits = s_led_base;
+  for (int k = 0; k < IO_LED_PATTERN_SLOTS; ++k) {
+    const led_pattern_t *p = &s_pat[k];
+    if (!p->owned) continue;
+    bits = (uint8_t)((bits & ~p->owned) | (p->steps[p->idx].leds & p->owned));
+  }
+  if (s_led_written_valid && bits == s_led_written) return;
+  if (LED_NATIVE_BITS) {
+    const uint32_t all = led_bits_to_gpio(LED_NATIVE_BITS);
+    const uint32_t on = led_bits_to_gpio(bits & LED_NATIVE_BITS);
+    REG_WRITE(GPIO_OUT_W1TS_REG, on);
+    REG_WRITE(GPIO_OUT_W1TC_REG, all & ~on);
+  }
+#if IO_USE_PCF8574
+  // Expander LEDs are active-low; staged here, written by led_commit()
+  pcf_io_stage((uint8_t)(LED_PCF_BITS << IO_PCF_LED_SHIFT),
+               (uint8_t)(~(bits & LED_PCF_BITS) << IO_PCF_LED_SHIFT));
+  s_led_pcf_dirty = true;
+#endif
+  s_led_written = bits;
+  s_led_written_valid = true;
+}
 
-static TaskHandle_t s_blink_task[IO_LED_COUNT] = {0};
-static volatile bool s_blink_stop[IO_LED_COUNT] = {0};
+// After leaving s_led_mux: push staged expander bits (one I2C write per tick)
+static inline void led_commit(void) {
+#if IO_USE_PCF8574
+  if (s_led_pcf_dirty) {
+    s_led_pcf_dirty = false;
+    pcf_io_commit();
+  }
+#endif
+}
 
-static void blink_task(void *pv) {
-  blink_args_t a = *(blink_args_t *)pv;
-  free(pv);
-  const TickType_t on_ticks  = pdMS_TO_TICKS(a.on_ms  ? a.on_ms  : 1);
-  const TickType_t off_ticks = pdMS_TO_TICKS(a.off_ms ? a.off_ms : 1);
+// Take LEDs away from running patterns; caller holds s_led_mux
+static void led_release_locked(uint8_t leds) {
+  for (int k = 0; k < IO_LED_PATTERN_SLOTS; ++k) {
+    s_pat[k].owned &= (uint8_t)~leds;
+  }
+}
 
-  _LOG_D("LED_Blink start: led=%d on=%ums off=%ums count=%d",
-         (int)a.led, (unsigned)a.on_ms, (unsigned)a.off_ms, a.count);
+static void led_tick(void *arg) {
+  (void)arg;
+  bool any = false;
+  portENTER_CRITICAL(&s_led_mux);
+  for (int k = 0; k < IO_LED_PATTERN_SLOTS; ++k) {
+    led_pattern_t *p = &s_pat[k];
+    if (!p->owned) continue;
+    p->left_ms -= IO_LED_TICK_MS;
+    while (p->owned && p->left_ms <= 0) {
+      if (++p->idx == p->n) {
+        p->idx = 0;
+        if (p->repeat > 0 && --p->repeat == 0) {
+          p->owned = 0; // finished: its LEDs fall back to base (off)
+          break;
+        }
+      }
+      p->left_ms += p->steps[p->idx].ms ? p->steps[p->idx].ms : 1;
+    }
+    if (p->owned) any = true;
+  }
+  led_flush_locked();
+  if (!any) {
+    // Stopped under the lock so a pattern started right now cannot lose
+    // its restart (esp_timer start/stop only take a nested spinlock)
+    esp_timer_stop(s_led_timer);
+  }
+  portEXIT_CRITICAL(&s_led_mux);
+  led_commit();
+}
+
+static esp_err_t led_timer_ensure(void) {
+  if (s_led_timer) return ESP_OK;
+  const esp_timer_create_args_t args = {
+    .callback = led_tick,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "led_tick",
+  };
+  return esp_timer_create(&args, &s_led_timer);
+}
+
+// Free the LEDs from older patterns and grab an empty slot; caller holds
+// s_led_mux. NULL when all slots are busy.
+static led_pattern_t *led_claim_locked(uint8_t leds) {
+  led_release_locked(leds);
+  for (int k = 0; k < IO_LED_PATTERN_SLOTS; ++k) {
+    if (!s_pat[k].owned) return &s_pat[k];
+  }
+  return NULL;
+}
+
+// Show step 0 now; caller holds s_led_mux
+static void led_arm_locked(led_pattern_t *p, uint8_t leds,
+                           const io_led_step_t *steps, size_t n, int repeat) {
+  p->steps = steps;
+  p->n = n;
+  p->idx = 0;
+  p->left_ms = steps[0].ms ? steps[0].ms : 1;
+  p->repeat = repeat;
+  p->owned = leds;
+  s_led_base &= (uint8_t)~leds;
+  led_flush_locked();
+}
 
-  int remaining = a.count;
-  while (!s_blink_stop[a.led] && (remaining != 0)) {
-    io_led_set(a.led, true);
-    vTaskDelay(on_ticks);
-    if (s_blink_stop[a.led]) break;
-    io_led_set(a.led, false);
-    vTaskDelay(off_ticks);
-    if (remaining > 0) remaining--;
+// Caller holds s_led_mux
+static void led_timer_kick_locked(void) {
+  if (!esp_timer_is_active(s_led_timer)) {
+    esp_timer_start_periodic(s_led_timer, IO_LED_TICK_MS * 1000);
   }
+}
+
+esp_err_t io_led_pattern_start(uint8_t leds, const io_led_step_t *steps,
+                               size_t n, int repeat) {
+  leds &= (uint8_t)((1u << IO_LED_COUNT) - 1);
+  if (!leds || !steps || n == 0 || repeat < 0) return ESP_ERR_INVALID_ARG;
+  esp_err_t err = led_timer_ensure();
+  if (err != ESP_OK) return err;
+
+  portENTER_CRITICAL(&s_led_mux);
+  led_pattern_t *slot = led_claim_locked(leds);
+  if (slot) {
+    led_arm_locked(slot, leds, steps, n, repeat);
+    led_timer_kick_locked();
+  }
+  portEXIT_CRITICAL(&s_led_mux);
+  led_commit();
+  return slot ? ESP_OK : ESP_ERR_NO_MEM;
+}
 
-  io_led_set(a.led, false);
-  _LOG_D("LED_Blink end: led=%d", (int)a.led);
-  s_blink_task[a.led] = NULL;
-  s_blink_stop[a.led] = false;
-  vTaskDelete(NULL);
+void io_led_pattern_stop(uint8_t leds) {
+  portENTER_CRITICAL(&s_led_mux);
+  led_release_locked(leds);
+  s_led_base &= (uint8_t)~leds;
+  led_flush_locked();
+  portEXIT_CRITICAL(&s_led_mux);
+  led_commit();
+}
+
+static void led_set_bits(uint8_t bits, bool on) {
+  portENTER_CRITICAL(&s_led_mux);
+  led_release_locked(bits);
+  if (on) s_led_base |= bits;
+  else    s_led_base &= (uint8_t)~bits;
+  led_flush_locked();
+  portEXIT_CRITICAL(&s_led_mux);
+  led_commit();
+}
+
+bool io_led_get(io_led_t led) {
+  if ((int)led < 0 || led >= IO_LED_COUNT) return false;
+  portENTER_CRITICAL(&s_led_mux);
+  const bool on = (s_led_written >> led) & 1u;
+  portEXIT_CRITICAL(&s_led_mux);
+  return on;
 }
 
 esp_err_t LED_Blink(const char *name, uint32_t time_on_ms, uint32_t time_off_ms, int count) {
@@ -152,27 +344,32 @@ esp_err_t LED_Blink(const char *name, uint32_t time_on_ms, uint32_t time_off_ms,
     _LOG_E("LED_Blink: both times are 0");
     return ESP_ERR_INVALID_ARG;
   }
-
-  if (s_blink_task[led]) {
-    s_blink_stop[led] = true;
-    for (int i = 0; i < 50 && s_blink_task[led]; ++i) vTaskDelay(pdMS_TO_TICKS(2)); // ~100 ms max
+  if (count < 0) count = 0;
+  const uint8_t bit = (uint8_t)(1u << led);
+  const io_led_step_t steps[2] = {
+    {.leds = bit, .ms = (uint16_t)(time_on_ms  > UINT16_MAX ? UINT16_MAX : (time_on_ms  ? time_on_ms  : 1))},
+    {.leds = 0,   .ms = (uint16_t)(time_off_ms > UINT16_MAX ? UINT16_MAX : (time_off_ms ? time_off_ms : 1))},
+  };
+  esp_err_t err = led_timer_ensure();
+  if (err != ESP_OK) return err;
+
+  // The two steps are copied into the slot, so no allocation per blink
+  portENTER_CRITICAL(&s_led_mux);
+  led_pattern_t *slot = led_claim_locked(bit);
+  if (slot) {
+    slot->inline_steps[0] = steps[0];
+    slot->inline_steps[1] = steps[1];
+    led_arm_locked(slot, bit, slot->inline_steps, 2, count); // 0 == infinite
+    led_timer_kick_locked();
   }
-
-  blink_args_t *args = (blink_args_t *)malloc(sizeof(blink_args_t));
-  if (!args) return ESP_ERR_NO_MEM;
-  args->led    = led;
-  args->on_ms  = (time_on_ms  == 0) ? 1 : time_on_ms;
-  args->off_ms = (time_off_ms == 0) ? 1 : time_off_ms;
-  args->count  = count; // 0 == infinite
-
-  s_blink_stop[led] = false;
-  BaseType_t ok = xTaskCreate(blink_task, "led_blink", 2048, args, 5, &s_blink_task[led]);
-  if (ok != pdPASS) {
-    free(args);
-    s_blink_task[led] = NULL;
-    _LOG_E("LED_Blink: failed to create task");
-    return ESP_FAIL;
+  portEXIT_CRITICAL(&s_led_mux);
+  led_commit();
+  if (!slot) {
+    _LOG_E("LED_Blink: no free pattern slot");
+    return ESP_ERR_NO_MEM;
   }
+  _LOG_D("LED_Blink start: led=%d on=%ums off=%ums count=%d",
+         (int)led, (unsigned)time_on_ms, (unsigned)time_off_ms, count);
   return ESP_OK;
 }
 
@@ -183,50 +380,27 @@ void LED_Blink_Cancel(const char *name) {
     _LOG_E("LED_Blink_Cancel: unknown LED name '%s'", name ? name : "(null)");
     return;
   }
-  if (s_blink_task[led]) {
-    s_blink_stop[led] = true;
-    for (int i = 0; i < 50 && s_blink_task[led]; ++i) vTaskDelay(pdMS_TO_TICKS(2));
-  }
+  io_led_pattern_stop((uint8_t)(1u << led));
 }
 
 // ===== Test helpers =====
-void io_test_all_leds_once(void) {
-  static const struct { io_led_t id; const char *name; } L[] = {
-    {IO_LED_STATUS_WASHING, "status_washing"},
-    {IO_LED_STATUS_SENSING, "status_sensing"},
-    {IO_LED_STATUS_DRYING,  "status_drying"},
-    {IO_LED_STATUS_CLEAN,   "status_clean"},
-    {IO_LED_CONTROL_LOCK,   "control_lock"},
-  };
-
-  for (size_t i = 0; i < sizeof(L)/sizeof(L[0]); ++i) {
-    _LOG_I("LED test: %s ON (5s)", L[i].name);
-    io_led_set(L[i].id, true);
-    vTaskDelay(pdMS_TO_TICKS(5000));
-    io_led_set(L[i].id, false);
-    _LOG_I("LED test: %s OFF", L[i].name);
-    vTaskDelay(pdMS_TO_TICKS(250));
-  }
-
-  _LOG_I("LED test: complete.");
-}
-
-// Optional: a simple poller example (software debounce)
-void ui_poll_task(void *arg) {
-  const TickType_t dt = pdMS_TO_TICKS(10);
-  uint8_t cnt_start=0,cnt_cancel=0,cnt_delay=0,cnt_quick=0;
-
-  while (1) {
-    cnt_start  = (io_switch_pressed(IO_SW_START)       ? (cnt_start  < 2 ? cnt_start+1  : 2) : 0);
-    cnt_cancel = (io_switch_pressed(IO_SW_CANCEL)      ? (cnt_cancel < 2 ? cnt_cancel+1 : 2) : 0);
-    cnt_delay  = (io_switch_pressed(IO_SW_DELAY)       ? (cnt_delay  < 2 ? cnt_delay+1  : 2) : 0);
-    cnt_quick  = (io_switch_pressed(IO_SW_QUICK_RINSE) ? (cnt_quick  < 2 ? cnt_quick+1  : 2) : 0);
-
-    if (cnt_start  == 2) { _LOG_I("Switch 'Start' pressed");       cnt_start=3;  }
-    if (cnt_cancel == 2) { _LOG_I("Switch 'Cancel' pressed");      cnt_cancel=3; }
-    if (cnt_delay  == 2) { _LOG_I("Switch 'Delay' pressed");       cnt_delay=3;  }
-    if (cnt_quick  == 2) { _LOG_I("Switch 'Quick Rinse' pressed"); cnt_quick=3;  }
+// Each LED on for 5 s, then 250 ms all-off, in order; runs on the LED timer
+#define LED_BIT(l) ((uint8_t)(1u << (l)))
+static const io_led_step_t s_led_test_seq[] = {
+  {LED_BIT(IO_LED_STATUS_WASHING), 5000}, {0, 250},
+  {LED_BIT(IO_LED_STATUS_SENSING), 5000}, {0, 250},
+  {LED_BIT(IO_LED_STATUS_DRYING),  5000}, {0, 250},
+  {LED_BIT(IO_LED_STATUS_CLEAN),   5000}, {0, 250},
+  {LED_BIT(IO_LED_CONTROL_LOCK),   5000}, {0, 250},
+};
 
-    vTaskDelay(dt);
+void io_test_all_leds_once(void) {
+  const esp_err_t err = io_led_pattern_start(
+      (uint8_t)((1u << IO_LED_COUNT) - 1), s_led_test_seq,
+      sizeof(s_led_test_seq) / sizeof(s_led_test_seq[0]), 1);
+  if (err != ESP_OK) {
+    _LOG_E("LED test: could not start (%s)", esp_err_to_name(err));
+    return;
   }
+  _LOG_I("LED test: started (each LED 5s, ~26s total, runs in background)");
 }
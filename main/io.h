@@ -1,13 +1,14 @@
 #ifndef OTA_DISH_IO_H
 #define OTA_DISH_IO_H
 
-// One-GPIO-per-device mode (Preset C):
+// One-GPIO-per-device mode (Preset C), or PCF8574 expander (IO_USE_PCF8574):
 // - Switches (active-low): Start, Cancel, Delay, Quick Rinse
 // - LEDs (active-high): status_washing, status_sensing, status_drying, status_clean, control_lock
 //
 // Reserved elsewhere: Relays=33,32,25,26,27  |  ADC=34
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>         // for uint32_t
 #include "esp_err.h"
 #include "driver/gpio.h"
@@ -33,6 +34,27 @@ extern "C" {
 #define IO_PIN_LED_STATUS_CLEAN    GPIO_NUM_13
 #define IO_PIN_LED_CONTROL_LOCK    GPIO_NUM_14
 
+// ---- Optional PCF8574 expander backend (chips/pfc8574.json) ----
+// 1: the four switches on P0..P3 and the first four LEDs (washing, sensing,
+//    drying, clean) on P4..P7, active-low (VCC -> resistor -> LED -> Pn);
+//    control_lock stays on its GPIO. The bus reuses the pins the status
+//    LEDs free up, so switches 16-19 and GPIO 13 become available.
+#ifndef IO_USE_PCF8574
+#define IO_USE_PCF8574 0
+#endif
+#define IO_PCF_I2C_PORT   0            // I2C_NUM_0
+#define IO_PCF_PIN_SDA    GPIO_NUM_21
+#define IO_PCF_PIN_SCL    GPIO_NUM_22
+#define IO_PCF_PIN_INT    GPIO_NUM_23  // open-drain, active-low
+#define IO_PCF_ADDR       0x20         // A2..A0 tied low
+#define IO_PCF_I2C_HZ     100000
+#define IO_PCF_SW_SHIFT   0            // IO_SW_* n  -> P(0+n)
+#define IO_PCF_LED_SHIFT  4            // IO_LED_* n -> P(4+n), n < 4
+#define IO_PCF_LED_COUNT  4
+
+// LED pattern engine tick; also the PCF8574 write-coalescing window
+#define IO_LED_TICK_MS    10
+
 // ---- Logical identifiers ----
 typedef enum {
   IO_LED_STATUS_WASHING = 0,
@@ -66,16 +88,47 @@ void io_led_set(io_led_t led, bool on);
 /** @brief Toggle an LED. */
 void io_led_toggle(io_led_t led);
 
-/** @brief One-shot test: turns each LED ON for 5s, then OFF. */
+/** @brief Current LED level as last written. */
+bool io_led_get(io_led_t led);
+
+/**
+ * @brief One-shot test: turns each LED ON for 5s, then OFF.
+ *        Runs on the LED pattern timer; returns immediately.
+ */
 void io_test_all_leds_once(void);
 
+/**
+ * @brief One step of an LED pattern: bit i of leds = LED io_led_t i ON,
+ *        held for ms milliseconds (10 ms resolution).
+ */
+typedef struct {
+  uint8_t  leds;
+  uint16_t ms;
+} io_led_step_t;
+
+/**
+ * @brief Play a step table on the LEDs in mask leds (bit i = io_led_t i).
+ *        Steps are not copied and must outlive the pattern (static const).
+ *        repeat = passes through the table, 0 = forever. LEDs taken over
+ *        from a running pattern are removed from it; a finished pattern
+ *        leaves its LEDs OFF. No tasks or allocations per pattern.
+ * @return ESP_ERR_NO_MEM if all pattern slots are busy.
+ */
+esp_err_t io_led_pattern_start(uint8_t leds, const io_led_step_t *steps,
+                               size_t n, int repeat);
+
+/** @brief Stop any pattern on the LEDs in mask leds and turn them OFF. */
+void io_led_pattern_stop(uint8_t leds);
+
 /** @brief Convenience helpers. */
 static inline void io_led_on (io_led_t led) { io_led_set(led, true);  }
 static inline void io_led_off(io_led_t led) { io_led_set(led, false); }
 
 /**
  * @brief Read a switch level (active-low). Returns true when pressed.
- *        (Debounce is the caller's responsibility if needed.)
+ *        Raw level, not debounced; io_input.h turns edges into events.
+ *        With IO_USE_PCF8574 this is the last value read on INT, not a bus
+ *        transaction.
  */
 bool io_switch_pressed(io_switch_t sw);
 
@@ -0,0 +1,178 @@
+// io_input.c — interrupt-driven switch input; see io_input.h
+
+#include "io_input.h"
+
+#include "dishwasher_programs.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+
+// FreeRTOS software timers rather than esp_timer: they can be (re)armed from
+// the GPIO ISR, and all callbacks run in the one timer service task, so the
+// per-switch state below needs no lock.
+
+#if !IO_USE_PCF8574
+static const gpio_num_t SW_PIN[IO_SW_COUNT] = {
+    IO_PIN_SW_START,
+    IO_PIN_SW_CANCEL,
+    IO_PIN_SW_DELAY,
+    IO_PIN_SW_QUICK_RINSE,
+};
+#endif
+
+static const char *const SW_NAME[IO_SW_COUNT] = {"Start", "Cancel", "Delay",
+                                                 "Quick Rinse"};
+static const char *const KIND_NAME[] = {"press", "release", "long-press"};
+
+static QueueHandle_t s_queue = NULL;
+static TimerHandle_t s_debounce[IO_SW_COUNT];
+static TimerHandle_t s_long[IO_SW_COUNT];
+static bool s_pressed[IO_SW_COUNT];  // debounced state
+static int64_t s_press_us[IO_SW_COUNT];
+static volatile uint32_t s_edges = 0;
+static uint32_t s_events = 0;
+static uint32_t s_dropped = 0;
+
+static void emit(io_switch_t sw, io_input_kind_t kind, int64_t now_us) {
+  const io_input_event_t ev = {
+      .t_us = now_us,
+      .held_ms = (kind == IO_INPUT_PRESS)
+                     ? 0
+                     : (uint32_t)((now_us - s_press_us[sw]) / 1000),
+      .sw = sw,
+      .kind = kind,
+  };
+  if (xQueueSend(s_queue, &ev, 0) != pdTRUE) {
+    s_dropped++;
+    _LOG_W("input queue full; dropped %s %s", SW_NAME[sw], KIND_NAME[kind]);
+    return;
+  }
+  s_events++;
+  _LOG_D("switch '%s' %s (held %lu ms)", SW_NAME[sw], KIND_NAME[kind],
+         (unsigned long)ev.held_ms);
+}
+
+#if !IO_USE_PCF8574
+static void IRAM_ATTR sw_isr(void *arg) {
+  const io_switch_t sw = (io_switch_t)(intptr_t)arg;
+  BaseType_t woken = pdFALSE;
+  gpio_intr_disable(SW_PIN[sw]); // until the debounce timer has sampled
+  s_edges++;
+  xTimerResetFromISR(s_debounce[sw], &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+#endif
+
+static void debounce_cb(TimerHandle_t t) {
+  const io_switch_t sw = (io_switch_t)(intptr_t)pvTimerGetTimerID(t);
+  const bool pressed = io_switch_pressed(sw);
+  if (pressed != s_pressed[sw]) {
+    const int64_t now = esp_timer_get_time();
+    s_pressed[sw] = pressed;
+    if (pressed) {
+      s_press_us[sw] = now;
+      xTimerReset(s_long[sw], 0);
+      emit(sw, IO_INPUT_PRESS, now);
+    } else {
+      xTimerStop(s_long[sw], 0);
+      emit(sw, IO_INPUT_RELEASE, now);
+    }
+  }
+#if !IO_USE_PCF8574
+  gpio_intr_enable(SW_PIN[sw]);
+  // An edge while masked was lost; if the level moved on, sample again
+  if (io_switch_pressed(sw) != s_pressed[sw]) {
+    gpio_intr_disable(SW_PIN[sw]);
+    xTimerReset(s_debounce[sw], 0);
+  }
+#endif
+}
+
+static void long_cb(TimerHandle_t t) {
+  const io_switch_t sw = (io_switch_t)(intptr_t)pvTimerGetTimerID(t);
+  if (s_pressed[sw]) {
+    emit(sw, IO_INPUT_LONG_PRESS, esp_timer_get_time());
+  }
+}
+
+esp_err_t io_input_start(void) {
+  if (s_queue) {
+    return ESP_OK;
+  }
+  s_queue = xQueueCreate(IO_INPUT_QUEUE_LEN, sizeof(io_input_event_t));
+  if (!s_queue) {
+    return ESP_ERR_NO_MEM;
+  }
+  for (int i = 0; i < IO_SW_COUNT; i++) {
+    s_debounce[i] = xTimerCreate("sw_db", pdMS_TO_TICKS(IO_INPUT_DEBOUNCE_MS),
+                                 pdFALSE, (void *)(intptr_t)i, debounce_cb);
+    s_long[i] = xTimerCreate("sw_long", pdMS_TO_TICKS(IO_INPUT_LONG_PRESS_MS),
+                             pdFALSE, (void *)(intptr_t)i, long_cb);
+    if (!s_debounce[i] || !s_long[i]) {
+      _LOG_E("input: failed to create timers");
+      return ESP_ERR_NO_MEM;
+    }
+    // A switch held through boot reports nothing until it is released
+    s_pressed[i] = io_switch_pressed((io_switch_t)i);
+  }
+
+#if IO_USE_PCF8574
+  // Edges arrive through io_input_notify() from the expander's INT read
+  _LOG_I("input: PCF8574 switches, debounce %d ms, long press %d ms",
+         IO_INPUT_DEBOUNCE_MS, IO_INPUT_LONG_PRESS_MS);
+#else
+  esp_err_t err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // already installed
+    _LOG_E("input: isr service failed (%s)", esp_err_to_name(err));
+    return err;
+  }
+  for (int i = 0; i < IO_SW_COUNT; i++) {
+    ESP_ERROR_CHECK(gpio_set_intr_type(SW_PIN[i], GPIO_INTR_ANYEDGE));
+    ESP_ERROR_CHECK(
+        gpio_isr_handler_add(SW_PIN[i], sw_isr, (void *)(intptr_t)i));
+    ESP_ERROR_CHECK(gpio_intr_enable(SW_PIN[i]));
+  }
+  _LOG_I("input: GPIO %d/%d/%d/%d on interrupts, debounce %d ms, long press "
+         "%d ms",
+         SW_PIN[0], SW_PIN[1], SW_PIN[2], SW_PIN[3], IO_INPUT_DEBOUNCE_MS,
+         IO_INPUT_LONG_PRESS_MS);
+#endif
+  return ESP_OK;
+}
+
+bool io_input_receive(io_input_event_t *ev, TickType_t wait) {
+  if (!s_queue || !ev) {
+    return false;
+  }
+  return xQueueReceive(s_queue, ev, wait) == pdTRUE;
+}
+
+void io_input_notify(uint32_t mask) {
+  if (!s_queue) {
+    return;
+  }
+  for (int i = 0; i < IO_SW_COUNT; i++) {
+    if (mask & (1u << i)) {
+      s_edges++;
+      xTimerReset(s_debounce[i], 0);
+    }
+  }
+}
+
+void io_input_get_counts(uint32_t *edges, uint32_t *events,
+                         uint32_t *dropped) {
+  if (edges) {
+    *edges = s_edges;
+  }
+  if (events) {
+    *events = s_events;
+  }
+  if (dropped) {
+    *dropped = s_dropped;
+  }
+}
@@ -0,0 +1,57 @@
+// io_input.h — interrupt-driven switch input: debounce, long press, events
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "io.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Nothing runs while the switches are idle. An edge on a switch (GPIO
+ * any-edge interrupt, or the PCF8574 INT read with IO_USE_PCF8574) arms a
+ * one-shot debounce timer for that switch; when it expires the level is read
+ * once and, if it differs from the debounced state, a PRESS or RELEASE event
+ * is queued. A PRESS also arms a one-shot long-press timer that queues
+ * LONG_PRESS if the switch is still held when it fires.
+ *
+ * On GPIO the switch interrupt is masked from the first edge until the
+ * debounce timer has sampled, so contact bounce costs one interrupt.
+ */
+
+#define IO_INPUT_DEBOUNCE_MS 30
+#define IO_INPUT_LONG_PRESS_MS 1500
+#define IO_INPUT_QUEUE_LEN 8
+
+typedef enum {
+  IO_INPUT_PRESS = 0,
+  IO_INPUT_RELEASE,
+  IO_INPUT_LONG_PRESS,
+} io_input_kind_t;
+
+typedef struct {
+  int64_t t_us;     // esp_timer time the event was decided
+  uint32_t held_ms; // RELEASE/LONG_PRESS: time since the PRESS
+  io_switch_t sw;
+  io_input_kind_t kind;
+} io_input_event_t;
+
+/** Arm the switch interrupts and timers. Call after io_init_onepin(). */
+esp_err_t io_input_start(void);
+
+/** Wait up to wait ticks for the next event. */
+bool io_input_receive(io_input_event_t *ev, TickType_t wait);
+
+/** Switches in mask (bit n = io_switch_t n) changed level. Task context. */
+void io_input_notify(uint32_t mask);
+
+/** Edges seen, events queued and events dropped on a full queue. */
+void io_input_get_counts(uint32_t *edges, uint32_t *events, uint32_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+// io_pcf8574.c — PCF8574 backend; see io_pcf8574.h
+// Only linked into the I/O path when IO_USE_PCF8574 is set (io.h).
+
+#include "io_pcf8574.h"
+
+#include "dishwasher_programs.h"
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "io.h"
+#include "io_input.h"
+
+#if IO_USE_PCF8574
+
+#define PCF_TASK_STACK 3072
+#define PCF_TASK_PRIO 6
+#define PCF_EV_FLUSH (1u << 0)
+#define PCF_EV_INT (1u << 1)
+#define PCF_POLL_MS 1000     // fallback input read if INT never fires
+#define PCF_XFER_TIMEOUT_MS 20
+
+static i2c_master_bus_handle_t s_bus = NULL;
+static i2c_master_dev_handle_t s_dev = NULL;
+static TaskHandle_t s_task = NULL;
+
+static uint8_t s_input_mask = 0;
+static uint8_t s_shadow = 0xFF;     // next byte to write
+static uint8_t s_written = 0xFF;    // last byte on the wire
+static bool s_written_valid = false;
+static volatile uint8_t s_in = 0xFF; // last port read
+static uint32_t s_writes = 0;
+static uint32_t s_reads = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR pcf_int_isr(void *arg) {
+  (void)arg;
+  BaseType_t woken = pdFALSE;
+  if (s_task) {
+    xTaskNotifyFromISR(s_task, PCF_EV_INT, eSetBits, &woken);
+  }
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+static void pcf_read(void) {
+  uint8_t v = 0xFF;
+  if (i2c_master_receive(s_dev, &v, 1, PCF_XFER_TIMEOUT_MS) != ESP_OK) {
+    _LOG_W("PCF8574 read failed");
+    return;
+  }
+  s_reads++;
+  const uint8_t changed = (uint8_t)((s_in ^ v) & s_input_mask);
+  s_in = v;
+  if (changed) {
+    io_input_notify((uint32_t)changed >> IO_PCF_SW_SHIFT);
+  }
+}
+
+static void pcf_flush(void) {
+  portENTER_CRITICAL(&s_mux);
+  const uint8_t out = s_shadow;
+  portEXIT_CRITICAL(&s_mux);
+  if (s_written_valid && out == s_written) {
+    return;
+  }
+  if (i2c_master_transmit(s_dev, &out, 1, PCF_XFER_TIMEOUT_MS) != ESP_OK) {
+    _LOG_W("PCF8574 write failed");
+    return;
+  }
+  s_writes++;
+  s_written = out;
+  s_written_valid = true;
+}
+
+static void pcf_task(void *arg) {
+  (void)arg;
+  for (;;) {
+    uint32_t ev = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &ev, pdMS_TO_TICKS(PCF_POLL_MS)) !=
+        pdTRUE) {
+      ev = PCF_EV_INT; // timeout: fallback read
+    }
+    if (ev & PCF_EV_INT) {
+      pcf_read();
+    }
+    if (ev & PCF_EV_FLUSH) {
+      pcf_flush();
+      // Hold off so every update staged during the next tick shares one write
+      vTaskDelay(pdMS_TO_TICKS(IO_LED_TICK_MS));
+    }
+  }
+}
+
+esp_err_t pcf_io_init(uint8_t input_mask, uint8_t initial_out) {
+  if (s_task) {
+    return ESP_OK;
+  }
+  s_input_mask = input_mask;
+  s_shadow = initial_out | input_mask;
+
+  const i2c_master_bus_config_t bus_cfg = {
+      .i2c_port = IO_PCF_I2C_PORT,
+      .sda_io_num = IO_PCF_PIN_SDA,
+      .scl_io_num = IO_PCF_PIN_SCL,
+      .clk_source = I2C_CLK_SRC_DEFAULT,
+      .glitch_ignore_cnt = 7,
+      .flags.enable_internal_pullup = true,
+  };
+  esp_err_t err = i2c_new_master_bus(&bus_cfg, &s_bus);
+  if (err != ESP_OK) {
+    _LOG_E("PCF8574: i2c bus init failed (%s)", esp_err_to_name(err));
+    return err;
+  }
+  const i2c_device_config_t dev_cfg = {
+      .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+      .device_address = IO_PCF_ADDR,
+      .scl_speed_hz = IO_PCF_I2C_HZ,
+  };
+  err = i2c_master_bus_add_device(s_bus, &dev_cfg, &s_dev);
+  if (err != ESP_OK) {
+    _LOG_E("PCF8574: add device 0x%02x failed (%s)", IO_PCF_ADDR,
+           esp_err_to_name(err));
+    return err;
+  }
+
+  // Known state before anything can interrupt: outputs, then inputs
+  pcf_flush();
+  pcf_read();
+
+  if (xTaskCreate(pcf_task, "pcf8574", PCF_TASK_STACK, NULL, PCF_TASK_PRIO,
+                  &s_task) != pdPASS) {
+    _LOG_E("PCF8574: failed to create task");
+    return ESP_ERR_NO_MEM;
+  }
+
+  // INT is open-drain, active low
+  const gpio_config_t int_cfg = {.pin_bit_mask = 1ULL << IO_PCF_PIN_INT,
+                                 .mode = GPIO_MODE_INPUT,
+                                 .pull_up_en = GPIO_PULLUP_ENABLE,
+                                 .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                                 .intr_type = GPIO_INTR_NEGEDGE};
+  ESP_ERROR_CHECK(gpio_config(&int_cfg));
+  err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // already installed
+    _LOG_E("PCF8574: isr service failed (%s)", esp_err_to_name(err));
+    return err;
+  }
+  ESP_ERROR_CHECK(gpio_isr_handler_add(IO_PCF_PIN_INT, pcf_int_isr, NULL));
+
+  _LOG_I("PCF8574 @0x%02x ready (SDA=%d SCL=%d INT=%d) in=0x%02x",
+         IO_PCF_ADDR, IO_PCF_PIN_SDA, IO_PCF_PIN_SCL, IO_PCF_PIN_INT,
+         (unsigned)s_in);
+  return ESP_OK;
+}
+
+void IRAM_ATTR pcf_io_stage(uint8_t mask, uint8_t bits) {
+  portENTER_CRITICAL_SAFE(&s_mux);
+  s_shadow = (uint8_t)(((s_shadow & ~mask) | (bits & mask)) | s_input_mask);
+  portEXIT_CRITICAL_SAFE(&s_mux);
+}
+
+void pcf_io_commit(void) {
+  if (s_task) {
+    xTaskNotify(s_task, PCF_EV_FLUSH, eSetBits);
+  }
+}
+
+uint8_t pcf_io_inputs(void) { return s_in; }
+
+void pcf_io_get_counts(uint32_t *writes, uint32_t *reads) {
+  if (writes) {
+    *writes = s_writes;
+  }
+  if (reads) {
+    *reads = s_reads;
+  }
+}
+
+#endif // IO_USE_PCF8574
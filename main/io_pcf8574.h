@@ -0,0 +1,44 @@
+// io_pcf8574.h — PCF8574 port-expander backend for io.c (IO_USE_PCF8574)
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The PCF8574 has no direction register: writing 1 releases a pin (weak
+ * pull-up, usable as input), writing 0 sinks current. The backend keeps a
+ * shadow of the output byte with every input pin held at 1, so LED updates
+ * never disturb the switches.
+ *
+ * - Outputs: io.c stages LED bits with pcf_io_stage(); pcf_io_commit() wakes
+ *   the I/O task, which writes the shadow once and then waits one LED tick,
+ *   so any burst of updates costs a single I2C write.
+ * - Inputs: the expander pulls INT low when an input changes; the ISR wakes
+ *   the task, which reads the port once (this also releases INT). A slow
+ *   fallback read covers a missed edge. Switch bits that changed are passed
+ *   to io_input_notify() for debouncing.
+ */
+
+/** Create the I2C bus/device, INT interrupt and I/O task; first read. */
+esp_err_t pcf_io_init(uint8_t input_mask, uint8_t initial_out);
+
+/** Replace the output bits in mask (input bits are forced to 1). ISR-safe. */
+void pcf_io_stage(uint8_t mask, uint8_t bits);
+
+/** Ask the I/O task to write the shadow if it changed. Not from an ISR. */
+void pcf_io_commit(void);
+
+/** Last port value read from the expander (bit n = Pn level). */
+uint8_t pcf_io_inputs(void);
+
+/** I2C transactions since boot (writes, reads) for bus-load checks. */
+void pcf_io_get_counts(uint32_t *writes, uint32_t *reads);
+
+#ifdef __cplusplus
+}
+#endif
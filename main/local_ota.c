@@ -15,6 +15,7 @@
 #include <arpa/inet.h>
 #include "local_wifi.h"
 #include "local_partitions.h"
+#include "event_bus.h"
 #ifndef TAG
 #define TAG PROJECT_NAME
 #endif
@@ -47,6 +48,14 @@ static void  _get_ota_task(void *param);                          // task entry
 
 static TaskHandle_t s_ota_task = NULL;
 
+// FirmwareStatus is only written here; each change is published once
+static void set_firmware_status(const char *status) {
+    setCharArray(ActiveStatus.FirmwareStatus, status);
+    bus_event_t ev = {.type = BUS_EV_FIRMWARE};
+    setCharArray(ev.firmware.status, status);
+    event_bus_publish(&ev);
+}
+
 // Optional: small event handler (currently unused)
 // static esp_err_t _http_event_handler(esp_http_client_event_t *evt) { return ESP_OK; }
 
@@ -104,7 +113,7 @@ void check_and_perform_ota(void) {
 
     // Accept ANY string starting with "OK - "
     if (strncasecmp(response, "OK - ", 5) == 0) {
-        setCharArray(ActiveStatus.FirmwareStatus,"Up To Date");
+        set_firmware_status("Up To Date");
         _LOG_I("Firmware is up-to-date");
         free(response);
         return;
@@ -127,7 +136,7 @@ void check_and_perform_ota(void) {
         _get_ota(url_copy); // spawns task and takes ownership of url_copy
         return;
     }
-    setCharArray(ActiveStatus.FirmwareStatus,"Server Error");
+    set_firmware_status("Server Error");
 
     _LOG_W("Unexpected response from server: %s", response);
     free(response);
@@ -181,13 +190,13 @@ static void _get_ota_task(void *param) {
     esp_https_ota_config_t ota_cfg = {
         .http_config = &http_cfg,
     };
-    setCharArray(ActiveStatus.FirmwareStatus,"Starting Update");
+    set_firmware_status("Starting Update");
     _LOG_I("Starting OTA update from %s ...", url);
 
     esp_err_t ret = esp_https_ota(&ota_cfg);
     _LOG_I("Flash finished");
     if (ret == ESP_OK) {
-        setCharArray(ActiveStatus.FirmwareStatus,"Pending Reboot");        
+        set_firmware_status("Pending Reboot");
         free(url);
         s_ota_task = NULL;
             // 1 minutes
@@ -198,7 +207,7 @@ static void _get_ota_task(void *param) {
         _LOG_I("Version: %s", APP_VERSION);
     esp_restart(); // never returns
     } else {
-        setCharArray(ActiveStatus.FirmwareStatus,"Firmware Failed");        
+        set_firmware_status("Firmware Failed");
         _LOG_E("OTA update failed: %s", esp_err_to_name(ret));
         free(url);
         s_ota_task = NULL;
@@ -57,6 +57,7 @@ static EventGroupHandle_t s_wifi_event_group = NULL;
 static esp_netif_t *s_wifi_netif = NULL;
 
 static volatile bool s_connected = false;          // true once we have IP
+static volatile uint32_t s_disconnects = 0;        // STA_DISCONNECTED events
 static volatile bool s_blocking_wait_active = false;
 static int s_retries_remaining = 0;
 
@@ -125,6 +126,7 @@ static void wifi_event_handler(void *arg,
 
         case WIFI_EVENT_STA_DISCONNECTED:
             s_connected = false;
+            s_disconnects++;
             xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
 
             if (s_blocking_wait_active) {
@@ -286,3 +288,7 @@ bool is_connected(void) {
     
     return s_connected;
 }
+
+uint32_t local_wifi_get_disconnects(void) {
+    return s_disconnects;
+}
@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +23,9 @@ esp_err_t local_wifi_init_and_connect(void);
 /** Returns true if currently connected (i.e., got IP and not disconnected). */
 bool is_connected(void);
 
+/** Disconnect events since boot; each one is followed by a reconnect try. */
+uint32_t local_wifi_get_disconnects(void);
+
 #ifdef __cplusplus
 }
 #endif
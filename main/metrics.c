@@ -0,0 +1,356 @@
+// metrics.c — Prometheus text exporter; see metrics.h
+// - Values are copied out of each module with its own getter, one family
+//   at a time, and formatted straight into the chunk buffer
+// - A line that does not fit in what is left of the buffer flushes it first
+
+#include "metrics.h"
+
+#include "actuator.h"
+#include "analog.h"
+#include "dishwasher_programs.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "event_bus.h"
+#include "http_conn.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "http_events.h"
+#include "http_server.h"
+#include "local_wifi.h"
+#include "logger.h"
+#include "status_cache.h"
+#include "status_watch.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef struct {
+  httpd_req_t *req;
+  size_t len;
+  bool failed; // a chunk could not be sent; the rest is skipped
+} mw_t;
+
+// httpd task only (see metrics.h)
+static char s_chunk[METRICS_CHUNK];
+static latency_hist s_hist;
+
+static void mw_flush(mw_t *w) {
+  if (!w->failed && w->len > 0 &&
+      httpd_resp_send_chunk(w->req, s_chunk, (ssize_t)w->len) != ESP_OK) {
+    w->failed = true;
+  }
+  w->len = 0;
+}
+
+static void mw_printf(mw_t *w, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void mw_printf(mw_t *w, const char *fmt, ...) {
+  if (w->failed) {
+    return;
+  }
+  va_list ap;
+  va_list again;
+  va_start(ap, fmt);
+  va_copy(again, ap);
+  int n = vsnprintf(s_chunk + w->len, sizeof(s_chunk) - w->len, fmt, ap);
+  if (n >= 0 && (size_t)n >= sizeof(s_chunk) - w->len && w->len > 0) {
+    // Did not fit behind what is buffered: send that, then write it again
+    mw_flush(w);
+    n = vsnprintf(s_chunk, sizeof(s_chunk), fmt, again);
+  }
+  va_end(again);
+  va_end(ap);
+  if (n > 0) {
+    const size_t room = sizeof(s_chunk) - w->len;
+    w->len += (size_t)n < room ? (size_t)n : room - 1;
+  }
+}
+
+static void mw_family(mw_t *w, const char *name, const char *type,
+                      const char *help) {
+  mw_printf(w, "# HELP dishwasher_%s %s\n# TYPE dishwasher_%s %s\n", name,
+            help, name, type);
+}
+
+static void mw_gauge(mw_t *w, const char *name, const char *help,
+                     double v) {
+  mw_family(w, name, "gauge", help);
+  mw_printf(w, "dishwasher_%s %.6g\n", name, v);
+}
+
+static void mw_counter(mw_t *w, const char *name, const char *help,
+                       uint64_t v) {
+  mw_family(w, name, "counter", help);
+  mw_printf(w, "dishwasher_%s %llu\n", name, (unsigned long long)v);
+}
+
+// Tasks whose stack head-room is exported; missing ones are skipped. Only
+// the first "sse" writer is found by name, so it stands for all of them.
+static const char *const STACK_TASKS[] = {
+    "action_long",
+    "action_worker",
+    "actuator",
+    "btn_monitor",
+    "httpd",
+    "pcf8574",
+    "run_program",
+    "sse",
+    "status_publish",
+    "status_watch",
+    "temp_monitor",
+    "temp_sampler",
+};
+
+static void write_system(mw_t *w) {
+  mw_family(w, "build_info", "gauge", "Firmware version, always 1");
+  mw_printf(w, "dishwasher_build_info{version=\"%s\"} 1\n", APP_VERSION);
+  mw_gauge(w, "uptime_seconds", "Seconds since boot",
+           (double)esp_timer_get_time() / 1e6);
+  mw_gauge(w, "heap_free_bytes", "Free heap now",
+           (double)esp_get_free_heap_size());
+  mw_gauge(w, "heap_min_free_bytes", "Lowest free heap since boot",
+           (double)esp_get_minimum_free_heap_size());
+
+  mw_family(w, "task_stack_free_bytes", "gauge",
+            "Stack never used by the task since it started");
+  for (size_t i = 0; i < sizeof(STACK_TASKS) / sizeof(STACK_TASKS[0]); i++) {
+    TaskHandle_t t = xTaskGetHandle(STACK_TASKS[i]);
+    if (t) {
+      mw_printf(w, "dishwasher_task_stack_free_bytes{task=\"%s\"} %u\n",
+                STACK_TASKS[i], (unsigned)uxTaskGetStackHighWaterMark(t));
+    }
+  }
+  mw_counter(w, "logger_dropped_total",
+             "Log messages dropped because the queue was full",
+             logger_get_drop_count());
+}
+
+static void write_analog(mw_t *w) {
+  static const char *const MODE[ANALOG_MODE_COUNT] = {"idle", "active",
+                                                      "heat"};
+  analog_sampler_stats_t s;
+  analog_get_sampler_stats(&s);
+  mw_family(w, "adc_samples_total", "counter",
+            "Temperature collections taken, by sampler mode");
+  for (int m = 0; m < ANALOG_MODE_COUNT; m++) {
+    mw_printf(w, "dishwasher_adc_samples_total{mode=\"%s\"} %u\n", MODE[m],
+              (unsigned)s.per_mode[m].samples);
+  }
+  mw_family(w, "adc_reads_total", "counter",
+            "ADC conversions, by sampler mode");
+  for (int m = 0; m < ANALOG_MODE_COUNT; m++) {
+    mw_printf(w, "dishwasher_adc_reads_total{mode=\"%s\"} %u\n", MODE[m],
+              (unsigned)s.per_mode[m].adc_reads);
+  }
+  mw_gauge(w, "adc_period_seconds", "Current collection period",
+           s.period_ms / 1000.0);
+  mw_gauge(w, "adc_oversample", "Current ADC reads per collection",
+           s.oversample_n);
+  mw_gauge(w, "adc_noise_raw_std_p95",
+           "Streaming p95 of the per-collection raw standard deviation",
+           s.raw_std_p95);
+  mw_counter(w, "adc_reads_blanked_total",
+             "ADC reads dropped inside an actuator blanking window",
+             s.reads_blanked);
+  mw_gauge(w, "temperature_fahrenheit", "Current water temperature",
+           ActiveStatus.CurrentTemp);
+}
+
+static void write_actuators(mw_t *w) {
+  actor_usage_t u[ACTOR_COUNT];
+  actor_usage_get(u);
+  const uint64_t mask = actuator_get_mask();
+  mw_family(w, "actuator_on", "gauge", "1 while the actuator is energized");
+  for (int a = 0; a < ACTOR_COUNT; a++) {
+    mw_printf(w, "dishwasher_actuator_on{actuator=\"%s\"} %d\n",
+              actor_name((actor_id_t)a),
+              (mask & actor_bit((actor_id_t)a)) != 0);
+  }
+  mw_family(w, "actuator_on_seconds_total", "counter",
+            "Time energized, including previous boots");
+  for (int a = 0; a < ACTOR_COUNT; a++) {
+    mw_printf(w,
+              "dishwasher_actuator_on_seconds_total{actuator=\"%s\"} %.3f\n",
+              actor_name((actor_id_t)a), (double)u[a].on_us / 1e6);
+  }
+  mw_family(w, "actuator_cycles_total", "counter",
+            "Off to on transitions, including previous boots");
+  for (int a = 0; a < ACTOR_COUNT; a++) {
+    mw_printf(w, "dishwasher_actuator_cycles_total{actuator=\"%s\"} %u\n",
+              actor_name((actor_id_t)a), (unsigned)u[a].cycles);
+  }
+}
+
+static void write_wifi(mw_t *w) {
+  wifi_ap_record_t ap;
+  if (is_connected() && esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+    mw_gauge(w, "wifi_rssi_dbm", "Signal of the current access point",
+             ap.rssi);
+  }
+  mw_gauge(w, "wifi_connected", "1 while the station has an IP",
+           is_connected());
+  mw_counter(w, "wifi_disconnects_total",
+             "Station disconnects, each followed by a reconnect",
+             local_wifi_get_disconnects());
+}
+
+// Histogram bucket bounds in µs (exported in seconds)
+static const uint32_t LE_US[] = {1000,   5000,   10000,   25000,
+                                 50000,  100000, 250000,  500000,
+                                 1000000, 2500000, 5000000};
+static const char *const ROUTE_NAME[HTTP_ROUTE_MAX] = {
+    [HTTP_ROUTE_STATUS] = "status",       [HTTP_ROUTE_HISTORY] = "history",
+    [HTTP_ROUTE_ACTION] = "action",       [HTTP_ROUTE_ROOT] = "root",
+    [HTTP_ROUTE_ACTUATORS] = "actuators", [HTTP_ROUTE_EVENTS] = "events",
+    [HTTP_ROUTE_METRICS] = "metrics",     [HTTP_ROUTE_ACTIONS] = "actions",
+};
+
+// One histogram series from a µs latency_hist. A bucket counts toward le
+// only when its whole range is <= le, so each cumulative count is a lower
+// bound (12.5% resolution).
+static void write_hist(mw_t *w, const char *name, const char *labels,
+                       const latency_hist *h) {
+  const size_t nb = latency_hist_buckets();
+  size_t i = 0;
+  uint32_t cum = 0;
+  for (size_t b = 0; b < sizeof(LE_US) / sizeof(LE_US[0]); b++) {
+    while (i + 1 < nb && latency_hist_lower(i + 1) - 1 <= LE_US[b]) {
+      cum += h->counts[i++];
+    }
+    mw_printf(w, "dishwasher_%s_bucket{%s,le=\"%g\"} %u\n", name, labels,
+              LE_US[b] / 1e6, (unsigned)cum);
+  }
+  mw_printf(w,
+            "dishwasher_%s_bucket{%s,le=\"+Inf\"} %u\n"
+            "dishwasher_%s_sum{%s} %.6f\n"
+            "dishwasher_%s_count{%s} %u\n",
+            name, labels, (unsigned)h->count, name, labels,
+            (double)h->sum / 1e6, name, labels, (unsigned)h->count);
+}
+
+static void write_http(mw_t *w) {
+  mw_family(w, "http_request_duration_seconds", "histogram",
+            "Handler time from entry to return, by route");
+  for (int r = 0; r < HTTP_ROUTE_MAX; r++) {
+    char labels[24];
+    http_server_get_latency((http_route_t)r, &s_hist);
+    snprintf(labels, sizeof(labels), "route=\"%s\"", ROUTE_NAME[r]);
+    write_hist(w, "http_request_duration_seconds", labels, &s_hist);
+  }
+
+  uint32_t clients, opened, frames;
+  http_events_get_counts(&clients, &opened, &frames);
+  mw_gauge(w, "sse_clients", "Open /events streams", clients);
+  mw_counter(w, "sse_frames_total", "Frames written to /events streams",
+             frames);
+  uint32_t copies, builds;
+  status_cache_get_counts(&copies, &builds);
+  mw_counter(w, "status_cache_copies_total",
+             "Status bodies served from the shared cache", copies);
+  mw_counter(w, "status_cache_builds_total",
+             "Status bodies rendered into the cache", builds);
+  uint32_t parked, total, timeouts;
+  status_watch_get_counts(&parked, &total, &timeouts);
+  mw_gauge(w, "longpoll_parked", "Parked /status?since= requests", parked);
+  mw_counter(w, "longpoll_timeouts_total",
+             "Long-polls answered unchanged at their timeout", timeouts);
+}
+
+// Session manager and per-client rate limits (http_conn.c)
+static void write_conns(mw_t *w) {
+  http_conn_stats_t s;
+  http_conn_get_stats(&s);
+  mw_gauge(w, "http_connections_open", "Open httpd sessions", s.open);
+  mw_gauge(w, "http_connections_pinned",
+           "Sessions held by /events streams and long-polls", s.pinned);
+  mw_counter(w, "http_connections_opened_total", "Sessions accepted",
+             s.opened);
+  mw_counter(w, "http_connections_purged_total",
+             "Idle sessions closed to make room", s.purged);
+  mw_counter(w, "http_connections_refused_total",
+             "Connections closed at once, client over its session limit",
+             s.refused);
+  mw_family(w, "http_rate_limited_total", "counter",
+            "Requests answered 429, by rate class");
+  for (int c = HTTP_RATE_NONE + 1; c < HTTP_RATE_CLASS_COUNT; c++) {
+    mw_printf(w, "dishwasher_http_rate_limited_total{class=\"%s\"} %u\n",
+              http_rate_class_name((http_rate_class_t)c),
+              (unsigned)s.limited[c]);
+  }
+}
+
+// Per-lane action queue; the wait histogram shares the HTTP bucket bounds
+static void write_actions(mw_t *w) {
+  static action_lane_stats_t st[ACTION_LANE_COUNT];
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    http_server_get_lane_stats((action_lane_t)l, &st[l]);
+  }
+  mw_family(w, "action_queue_depth", "gauge", "Actions waiting, by lane");
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    mw_printf(w, "dishwasher_action_queue_depth{lane=\"%s\"} %u\n",
+              http_server_lane_name((action_lane_t)l),
+              (unsigned)st[l].depth);
+  }
+  mw_family(w, "actions_enqueued_total", "counter",
+            "Actions accepted, by lane");
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    mw_printf(w, "dishwasher_actions_enqueued_total{lane=\"%s\"} %u\n",
+              http_server_lane_name((action_lane_t)l),
+              (unsigned)st[l].enqueued);
+  }
+  mw_family(w, "actions_dropped_total", "counter",
+            "Actions rejected because the lane was full");
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    mw_printf(w, "dishwasher_actions_dropped_total{lane=\"%s\"} %u\n",
+              http_server_lane_name((action_lane_t)l),
+              (unsigned)st[l].dropped);
+  }
+  mw_family(w, "action_wait_seconds", "histogram",
+            "Time from enqueue to start, by lane");
+  for (int l = 0; l < ACTION_LANE_COUNT; l++) {
+    char labels[24];
+    snprintf(labels, sizeof(labels), "lane=\"%s\"",
+             http_server_lane_name((action_lane_t)l));
+    write_hist(w, "action_wait_seconds", labels, &st[l].wait);
+  }
+}
+
+static void write_bus(mw_t *w) {
+  uint32_t published, dropped;
+  event_bus_get_totals(&published, &dropped);
+  mw_counter(w, "bus_published_total", "Events published", published);
+  mw_counter(w, "bus_dropped_total",
+             "Event deliveries dropped on full subscriber queues", dropped);
+  mw_family(w, "bus_subscriber_dropped_total", "counter",
+            "Deliveries dropped, by subscriber slot");
+  for (int s = 0; s < EVENT_BUS_MAX_SUBS; s++) {
+    event_bus_stats_t st;
+    if (event_bus_get_stats(s, &st)) {
+      mw_printf(w,
+                "dishwasher_bus_subscriber_dropped_total"
+                "{subscriber=\"%s\",slot=\"%d\"} %u\n",
+                st.name, s, (unsigned)st.dropped);
+    }
+  }
+}
+
+esp_err_t metrics_handler(httpd_req_t *req) {
+  mw_t w = {.req = req};
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  write_system(&w);
+  write_actions(&w);
+  write_analog(&w);
+  write_actuators(&w);
+  write_wifi(&w);
+  write_http(&w);
+  write_conns(&w);
+  write_bus(&w);
+  mw_flush(&w);
+  if (w.failed) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
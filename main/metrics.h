@@ -0,0 +1,30 @@
+// metrics.h — GET /metrics in the Prometheus text exposition format
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Every series is named dishwasher_* and read from counters the modules
+ * already keep; nothing here samples on its own. Counters (*_total) count
+ * from boot, so rate() over a scrape interval is what a dashboard wants.
+ * For example, heater duty is
+ * rate(dishwasher_actuator_on_seconds_total{actuator="HEAT"}[5m]).
+ *
+ * The body is written through one static METRICS_CHUNK buffer and sent in
+ * chunks as it fills. No heap is used, so a scrape still works when memory
+ * is short. The handler runs on the httpd task only, which is what makes
+ * the static buffer safe.
+ */
+
+#define METRICS_CHUNK 1024
+
+esp_err_t metrics_handler(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,14 +31,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "actuator.h"
 #include "analog.h"
-#include "buttons.h"
 #include "dishwasher_programs.h"
 #include "driver/gpio.h"
 #include "esp_sleep.h"
+#include "event_bus.h"
 #include "esp_wifi.h"
 #include "http_parser.h"
 #include "io.h"
+#include "io_input.h"
 #include "local_ota.h"
 #include "local_partitions.h"
 #include "local_time.h"
@@ -114,7 +116,8 @@ static void _init_setup(void) {
     counter--;
   }
   initialize_sntp_blocking();
-  init_switchesandleds();
+  ESP_ERROR_CHECK(io_init_onepin());
+  ESP_ERROR_CHECK(io_input_start());
   net_probe("10.0.0.123", 5514);
   // logger_flush();
   init_status();
@@ -123,20 +126,44 @@ static void _init_setup(void) {
   //  vTaskDelay(pdMS_TO_TICKS(1000000));
 
   // create background monitoring tasks (use reasonable stack sizes)
-  xTaskCreate(monitor_task_buttons, "monitor_task_buttons", 4096, NULL, 5,
-              NULL);
-  xTaskCreate(monitor_task_temperature, "monitor_task_temperature", 4096, NULL,
-              5, NULL);
-  xTaskCreate(update_published_status, "update_published_status", 4096, NULL, 5,
-              NULL);
+  // Names stay under configMAX_TASK_NAME_LEN; /metrics looks them up by name
+  xTaskCreate(monitor_task_buttons, "btn_monitor", 4096, NULL, 5, NULL);
+  xTaskCreate(monitor_task_temperature, "temp_monitor", 4096, NULL, 5, NULL);
+  xTaskCreate(update_published_status, "status_publish", 4096, NULL, 5, NULL);
   // wait (up to 60s) for wifi
 }
+// Front-panel switches → actions (same queue as the web UI). Cancel and
+// Skip need a long press so a brush against the panel cannot stop a cycle.
+typedef struct {
+  io_switch_t sw;
+  io_input_kind_t kind;
+  actions_t act;
+} button_action_t;
+static const button_action_t BUTTON_ACTIONS[] = {
+    {IO_SW_START, IO_INPUT_PRESS, ACTION_CYCLE_NORMAL},
+    {IO_SW_QUICK_RINSE, IO_INPUT_PRESS, ACTION_CYCLE_TESTER},
+    {IO_SW_CANCEL, IO_INPUT_LONG_PRESS, ACTION_ADMIN_CANCEL},
+    {IO_SW_DELAY, IO_INPUT_LONG_PRESS, ACTION_ADMIN_SKIP_STEP},
+};
+
 static void monitor_task_buttons(void *pvParameters) {
   (void)pvParameters;
-  // TODO: implement real button monitoring
+  io_input_event_t ev;
   while (1) {
-    // poll or wait on interrupts/queue
-    vTaskDelay(pdMS_TO_TICKS(200));
+    // Blocks until a debounced edge; idle switches never wake this task
+    if (!io_input_receive(&ev, portMAX_DELAY)) {
+      continue;
+    }
+    for (size_t i = 0; i < sizeof(BUTTON_ACTIONS) / sizeof(BUTTON_ACTIONS[0]);
+         i++) {
+      if (BUTTON_ACTIONS[i].sw != ev.sw || BUTTON_ACTIONS[i].kind != ev.kind) {
+        continue;
+      }
+      if (!http_server_enqueue_action(BUTTON_ACTIONS[i].act, 0)) {
+        _LOG_W("switch %d: action %d not queued", (int)ev.sw,
+               (int)BUTTON_ACTIONS[i].act);
+      }
+    }
   }
 }
 static void monitor_task_temperature(void *pvParameters) {
@@ -160,37 +187,60 @@ void print_status() {
          (long long)ActiveStatus.time_cycle_total, ActiveStatus.IPAddress);
 */
 };
+// Status LEDs for one step event: washing while a program runs, drying in
+// the cool-down, clean once it has finished
+static void show_step_leds(const bus_event_t *ev) {
+  const bool running = ev->step.running &&
+                       strcmp(ev->step.cycle_name, "fini") != 0;
+  const bool drying = running && strcmp(ev->step.cycle_name, "cool") == 0;
+  io_led_set(IO_LED_STATUS_WASHING, running && !drying);
+  io_led_set(IO_LED_STATUS_DRYING, drying);
+  io_led_set(IO_LED_STATUS_CLEAN, !running);
+}
+
+// Reacts to published state changes (logging + status LEDs); sleeps
+// otherwise
 static void update_published_status(void *pvParameters) {
   (void)pvParameters;
+  const int sub = event_bus_subscribe(
+      "status", BUS_EV_BIT(BUS_EV_STEP) | BUS_EV_BIT(BUS_EV_FIRMWARE) |
+                    BUS_EV_BIT(BUS_EV_ACTION) | BUS_EV_BIT(BUS_EV_ACTUATOR));
+  if (sub < 0) {
+    vTaskDelete(NULL);
+    return;
+  }
   _LOG_I("Starting");
+  bus_event_t ev;
   while (1) {
-    int count = 0;
-    if (strcmp(ActiveStatus.Cycle, "Off") == 0) {
-      _LOG_I("Cycle-Off");
-      vTaskDelay(pdMS_TO_TICKS(30000));
-      count++;
-      if (count > 10) {
-        count = 0;
-        printf("%s, Dishwasher is OFF; Dishes are in DIRTY state",
-               ActiveStatus.Cycle);
-      };
-    } else if (strcmp(ActiveStatus.Cycle, "fini") == 0) {
-      _LOG_I("Cycle-Finished");
-      vTaskDelay(pdMS_TO_TICKS(30000));
-      count++;
-      if (count > 10) {
-        count = 0;
-        printf("%s, Dishwasher is OFF; Dishes are in CLEAN state",
-               ActiveStatus.Cycle);
-      };
-    } else {
-      //   _LOG_I("Cycle-Processing");
-      print_status();
-      vTaskDelay(pdMS_TO_TICKS(30000));
+    if (!event_bus_receive(sub, &ev, portMAX_DELAY)) {
+      continue;
+    }
+    switch (ev.type) {
+    case BUS_EV_STEP:
+      if (ev.step.running) {
+        _LOG_I("Step %d/%d: %s->%s (cycle %d/%d)", ev.step.step,
+               ev.step.steps, ev.step.cycle_name, ev.step.step_name,
+               ev.step.cycle, ev.step.cycles);
+      } else {
+        _LOG_I("Program finished; Dishes are in CLEAN state");
+      }
+      show_step_leds(&ev);
+      break;
+    case BUS_EV_FIRMWARE:
+      _LOG_I("Firmware status: %s", ev.firmware.status);
+      break;
+    case BUS_EV_ACTION:
+      _LOG_I("Action %d done (%s)", ev.action.action,
+             ev.action.ok ? "ok" : "unknown");
+      break;
+    case BUS_EV_ACTUATOR:
+      _LOG_D("Actuators %s", return_masked_bits(ev.actuator.mask, ALL_ACTORS));
+      break;
+    default:
+      break;
     }
   }
-  _LOG_I("Finishing");
-} // run_program task: summarises and then blocks
+}
 
 void init_status(void) {
 
@@ -211,8 +261,7 @@ void init_status(void) {
 // app_main
 void app_main(void) {
 
-  gpio_mask_config_outputs(ALL_ACTORS);
-  gpio_mask_clear(HEAT | SPRAY | INLET | DRAIN | SOAP); // set all pins to off
+  ESP_ERROR_CHECK(actuator_start()); // relay pins as outputs, all off
 
   _start_temp_monitor();
 
@@ -224,6 +273,7 @@ void app_main(void) {
   esp_log_level_set("phy", ESP_LOG_WARN);
   esp_log_level_set("ota_dishwasher", ESP_LOG_VERBOSE);
   ESP_ERROR_CHECK(nvs_flash_init());
+  actuator_usage_load(); // logs; counters still run if it fails
   _init_setup();
 
   start_webserver();
@@ -0,0 +1,114 @@
+// program_defs.c — the program tables declared in program_defs.h. Built into
+// the firmware and the host replay tool, so no ESP-IDF headers here either.
+
+#include "program_defs.h"
+
+// Normal program
+
+static const ProgramLineStruct NormalProgramLines[] = {
+    {"init",   "setup", 1,           0,          0,   0,   0,                       0,        0},
+
+    {"Prep",   "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"Prep",   "Spray", 5 * MIN,     0,          0,   0,   SPRAY,                   0,        0},
+    {"Prep",   "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"wash",   "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"wash",   "Warm",  5 * MIN, 40 * MIN,      130, 140,  HEAT | SPRAY,           10*MIN,   20*MIN},
+    {"wash",   "soap",  1 * MIN,     0,         140, 150,  HEAT | SPRAY,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"wash",   "wash", 45 * MIN, 75 * MIN,     150, 150,  HEAT | SPRAY,            20*MIN,   30*MIN},
+    {"wash",   "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse1", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse1", "rinse", 5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse1", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse2", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse2", "rinse", 5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse2", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse3", "fill",  3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse3", "soap",  1 * MIN,     0,         140, 140,  HEAT | DRAIN,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"rinse3", "rinse",10 * MIN, 20 * MIN,     140, 140,  HEAT | SPRAY,            10*MIN,   20*MIN},
+    {"rinse3", "drain", 2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"cool",   "vent", 29 * MIN,     0,          0,   0,   HEAT,                    0,        0},
+    {"fini",   "clean", 0,           0,          0,   0,   0,                       0,        0}
+};
+
+
+static const ProgramLineStruct TesterProgramLines[] = {
+    {"init",   "setup",   1,           0,          0,   0,   0,                       0,        0},
+
+    {"Prep",   "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
+    {"Prep",   "Spray",  30 * SEC, 30 * SEC,     130, 130,  SPRAY,                    5*MIN,   10*MIN},
+    {"Prep",   "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"wash",   "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
+    {"wash",   "Warm",    0,        30 * SEC,    130, 130,  HEAT | SPRAY,             5*MIN,   10*MIN},
+    {"wash",   "soap",   30 * SEC,     0,         140, 140,  HEAT | SPRAY,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"wash",   "wash",   30 * SEC, 30 * SEC,     152, 152,  HEAT | SPRAY,            10*MIN,   15*MIN},
+    {"wash",   "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse1", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse1", "rinse",  30 * SEC,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse1", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse2", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse2", "rinse",  30 * SEC,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse2", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse3", "fill",   30 * SEC,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse3", "soap",   30 * SEC,     0,         140, 140,  HEAT | DRAIN,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"rinse3", "rinse",  30 * SEC, 30 * SEC,     140, 140,  HEAT | SPRAY,             5*MIN,   10*MIN},
+
+    {"rinse3", "drain",   2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+    {"cool",   "vent",   29 * MIN,     0,          0,   0,   HEAT,                    0,        0},
+    {"fini",   "clean",   0,           0,          0,   0,   0,                       0,        0}
+};
+
+static const ProgramLineStruct HiTempProgramLines[] = {
+    {"init",   "setup",  1,           0,          0,   0,   0,                       0,        0},
+
+    {"Prep",   "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"Prep",   "Spray",  5 * MIN,     0,          0,   0,   SPRAY,                   0,        0},
+    {"Prep",   "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"wash",   "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"wash",   "Warm",   0,       40 * MIN,     160, 160,  HEAT | SPRAY,            10*MIN,   20*MIN},
+    {"wash",   "soap",   1 * MIN,     0,         160, 160,  HEAT | SPRAY,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"wash",   "wash",  45 * MIN, 75 * MIN,     160, 160,  HEAT | SPRAY,            20*MIN,   30*MIN},
+    {"wash",   "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse1", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse1", "rinse",  5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse1", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse2", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse2", "rinse",  5 * MIN,     0,          0,   0,   HEAT | SPRAY,            0,        0},
+    {"rinse2", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"rinse3", "fill",   3 * MIN,     0,          0,   0,   INLET,                   0,        0},
+    {"rinse3", "soap",   1 * MIN,     0,         160, 160,  HEAT | DRAIN,            5*MIN,   10*MIN, SOAP, SOAP_PULSE_MS},
+    {"rinse3", "rinse", 10 * MIN, 20 * MIN,     160, 160,  HEAT | SPRAY,            10*MIN,   20*MIN},
+    {"rinse3", "drain",  2 * MIN,     0,          0,   0,   DRAIN,                   0,        0},
+
+    {"cool",   "vent",  29 * MIN,     0,         140, 140,  HEAT,                    10*MIN,   20*MIN},
+    {"fini",   "clean",  0,           0,          0,   0,   0,                       0,        0}
+};
+
+
+static const ProgramLineStruct CancelProgramLines[] = {
+    {"Cancel", "drain", 2 * MIN, 0, 0, 0, DRAIN, 0, 0},
+    {"fini",   "clean", 0,       0, 0, 0, 0,     0, 0}
+};
+
+
+Program_Entry Programs[NUM_PROGRAMS] = {
+    {"Tester", TesterProgramLines,
+     sizeof(TesterProgramLines) / sizeof(TesterProgramLines[0]),0},
+    {"Normal", NormalProgramLines,
+     sizeof(NormalProgramLines) / sizeof(NormalProgramLines[0]),0},
+    {"HiTemp", HiTempProgramLines,
+     sizeof(HiTempProgramLines) / sizeof(HiTempProgramLines[0]),0},
+    {"Cancel", CancelProgramLines,
+     sizeof(CancelProgramLines) / sizeof(CancelProgramLines[0]),0}};
@@ -0,0 +1,61 @@
+// program_defs.h — program line/table types shared by the firmware and the
+// host replay tool (tools/replay); the tables are in program_defs.c. Must not
+// include ESP-IDF headers.
+#ifndef PROGRAM_DEFS_H
+#define PROGRAM_DEFS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BIT64
+#define BIT64(n) (1ULL << (n))
+#endif
+
+// Relay outputs; plain pin numbers so this header builds without ESP-IDF
+#define HEAT (BIT64(32))  // GPIO_NUM_32
+#define SPRAY (BIT64(33)) // GPIO_NUM_33
+#define INLET (BIT64(25)) // GPIO_NUM_25
+#define DRAIN (BIT64(26)) // GPIO_NUM_26
+#define SOAP (BIT64(27))  // GPIO_NUM_27
+
+static const uint64_t ALL_ACTORS = HEAT | SPRAY | INLET | DRAIN | SOAP;
+#define NUM_PROGRAMS 4
+
+#define SEC (1) // 1 second is one second
+#define MIN (60)   // 60 seconds in one minute
+
+
+
+typedef struct {
+  char *name_cycle;
+  char *name_step;
+  uint32_t min_time;
+  uint32_t max_time;
+  int min_temp;
+  int max_temp;
+  uint64_t gpio_mask; // BIT64 mask for all pins to set HIGH
+  uint32_t min_time_at_temp; // NEW: apply only when min/max temp specified (else 0)
+  uint32_t max_time_at_temp; // NEW: apply only when min/max temp specified (else 0)
+  uint64_t pulse_mask; // actors switched on once at step start for pulse_ms
+  uint32_t pulse_ms;   // then off again by a timer (not held for the step)
+} ProgramLineStruct;
+
+// Detergent dispenser solenoid: a short pulse opens it; holding it for the
+// whole step only heats the coil
+#define SOAP_PULSE_MS 750
+
+
+typedef struct {
+  const char *name;
+  const ProgramLineStruct *lines;
+  size_t num_lines;
+  int64_t min_time;
+  int64_t max_time;
+  int num_cycles;  
+} Program_Entry;
+
+// Defined in program_defs.c; min_time/max_time/num_cycles are filled in at
+// boot by dishwasher_programs.c
+extern Program_Entry Programs[NUM_PROGRAMS];
+
+#endif // PROGRAM_DEFS_H
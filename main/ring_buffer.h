@@ -1,8 +1,12 @@
 // ring_buffer.h  — simple C11 ring buffer "template" via macro
 #pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#define RING_BUFFER_IS_POW2(CAP) ((((CAP) & ((CAP) - 1)) == 0))
+
 /* Usage:
    RING_BUFFER_DEFINE(prevTemp_rb, int, 16);
    static prevTemp_rb temps;                 // one buffer
@@ -27,9 +31,11 @@
     rb->head = 0; rb->count = 0; rb->sum = 0;                                         \
   }                                                                                   \
                                                                                       \
-  /* wrap index (portable; modulo). If CAP is a power of two and you                    \
-     care about speed, you can replace with: (i & ((CAP)-1)). */                      \
-  static inline size_t NAME##_wrap(size_t i) { return (i % (CAP)); }                  \
+  /* wrap index: mask when CAP is a power of two, modulo otherwise.                   \
+     The condition is a constant, so only one branch is compiled in. */               \
+  static inline size_t NAME##_wrap(size_t i) {                                        \
+    return RING_BUFFER_IS_POW2(CAP) ? (i & ((size_t)(CAP) - 1)) : (i % (CAP));        \
+  }                                                                                   \
                                                                                       \
   /* Push newest value; overwrites oldest when full */                                \
   static inline void NAME##_push(NAME *rb, TYPE v) {                                  \
@@ -51,7 +57,7 @@
      Caller must ensure i < rb->count */                                              \
   static inline TYPE NAME##_recent(const NAME *rb, size_t i) {                        \
     size_t newest = NAME##_wrap(rb->head + (CAP) - 1);                                \
-    return rb->buf[NAME##_wrap(newest - i)];                                          \
+    return rb->buf[NAME##_wrap(newest + (CAP) - i)];                                  \
   }                                                                                   \
                                                                                       \
   static inline size_t     NAME##_size(const NAME *rb)   { return rb->count; }        \
@@ -80,3 +86,216 @@
   static inline TYPE NAME##_newest(const NAME *rb) {                                  \
     return rb->buf[NAME##_wrap(rb->head + (CAP) - 1)];                                \
   }
+
+/* Single-producer / single-consumer lock-free FIFO.
+   One task (or ISR) pushes, one task pops; no locks, no critical sections.
+   head/tail are free-running 32-bit counters (lock-free on Xtensa); the
+   producer publishes a slot with a release store of head and the consumer
+   frees it with a release store of tail. CAP must be a power of two.
+   Unlike RING_BUFFER_DEFINE, push fails when full instead of overwriting.
+
+   RING_BUFFER_SPSC_DEFINE(sample_q, int, 64);
+   static sample_q q;                        // zero-initialised == empty
+   if (!sample_q_push(&q, v)) { dropped++; } // producer side
+   int v; while (sample_q_pop(&q, &v)) {...} // consumer side
+*/
+#define RING_BUFFER_SPSC_DEFINE(NAME, TYPE, CAP)                                      \
+  _Static_assert((CAP) > 0 && RING_BUFFER_IS_POW2(CAP),                                \
+                 "SPSC capacity must be a power of two");                             \
+  typedef struct {                                                                    \
+    TYPE                  buf[(CAP)];                                                 \
+    _Atomic uint32_t      head;   /* written by producer only */                      \
+    _Atomic uint32_t      tail;   /* written by consumer only */                      \
+  } NAME;                                                                             \
+                                                                                      \
+  /* Only while neither side is running */                                            \
+  static inline void NAME##_clear(NAME *q) {                                          \
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);                         \
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);                         \
+  }                                                                                   \
+                                                                                      \
+  /* Producer: false when full */                                                     \
+  static inline bool NAME##_push(NAME *q, TYPE v) {                                   \
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_relaxed);                \
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_acquire);                \
+    if ((uint32_t)(h - t) >= (uint32_t)(CAP)) return false;                           \
+    q->buf[h & ((uint32_t)(CAP) - 1)] = v;                                            \
+    atomic_store_explicit(&q->head, h + 1, memory_order_release);                     \
+    return true;                                                                      \
+  }                                                                                   \
+                                                                                      \
+  /* Consumer: false when empty */                                                    \
+  static inline bool NAME##_pop(NAME *q, TYPE *out) {                                 \
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);                \
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);                \
+    if (h == t) return false;                                                         \
+    *out = q->buf[t & ((uint32_t)(CAP) - 1)];                                         \
+    atomic_store_explicit(&q->tail, t + 1, memory_order_release);                     \
+    return true;                                                                      \
+  }                                                                                   \
+                                                                                      \
+  /* Consumer: look at the oldest item without removing it */                         \
+  static inline bool NAME##_peek(NAME *q, TYPE *out) {                                \
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);                \
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);                \
+    if (h == t) return false;                                                         \
+    *out = q->buf[t & ((uint32_t)(CAP) - 1)];                                         \
+    return true;                                                                      \
+  }                                                                                   \
+                                                                                      \
+  /* Either side; a snapshot that may be stale by the time it is used */              \
+  static inline size_t NAME##_size(NAME *q) {                                         \
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);                \
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_acquire);                \
+    return (size_t)(uint32_t)(h - t);                                                 \
+  }                                                                                   \
+  static inline size_t NAME##_capacity(void) { return (CAP); }
+
+/* Sliding-window companion: RING_BUFFER_DEFINE plus O(1) window queries.
+   Each push carries a caller time t (any monotonic unit, e.g. ms).
+   - min/max: monotonic deques of (value, push seq), amortized O(1) per push
+   - slope: running sums of t, t², x and x·t with t relative to the oldest
+     point (rebased in O(1) on every push), so the least-squares fit never
+     rescans the buffer. The sums are recomputed exactly once every CAP
+     pushes to cancel floating-point drift (amortized O(1)).
+
+   RING_BUFFER_WINDOW_DEFINE(temp_win, float, 60);
+   static temp_win w;                        // call temp_win_clear(&w) first
+   temp_win_push(&w, 151.2f, now_ms);
+   float lo = temp_win_min(&w), hi = temp_win_max(&w);
+   double slope, fitted;                     // slope in value units per t unit
+   if (temp_win_fit(&w, &slope, &fitted)) {...}
+*/
+#define RING_BUFFER_WINDOW_DEFINE(NAME, TYPE, CAP)                                    \
+  RING_BUFFER_DEFINE(NAME##_rb, TYPE, CAP);                                           \
+  typedef struct {                                                                    \
+    TYPE      v;                                                                      \
+    uint32_t  seq;                                                                    \
+  } NAME##_mono;                                                                      \
+  typedef struct {                                                                    \
+    NAME##_mono q[(CAP)];                                                             \
+    size_t      front;                                                                \
+    size_t      n;                                                                    \
+  } NAME##_deque;                                                                     \
+  typedef struct {                                                                    \
+    NAME##_rb     rb;                                                                 \
+    int64_t       t[(CAP)];     /* time of each slot, parallel to rb.buf */           \
+    uint32_t      seq;          /* pushes since clear (wraps harmlessly) */           \
+    NAME##_deque  lo;           /* increasing values → front is window min */         \
+    NAME##_deque  hi;           /* decreasing values → front is window max */         \
+    int64_t       t_base;       /* t of the oldest point; sums are relative */        \
+    double        st, stt, sx, stx;                                                   \
+    size_t        since_resum;                                                        \
+  } NAME;                                                                             \
+                                                                                      \
+  static inline void NAME##_clear(NAME *w) {                                          \
+    NAME##_rb_clear(&w->rb);                                                          \
+    w->seq = 0;                                                                       \
+    w->lo.front = w->lo.n = 0;                                                        \
+    w->hi.front = w->hi.n = 0;                                                        \
+    w->t_base = 0;                                                                    \
+    w->st = w->stt = w->sx = w->stx = 0.0;                                            \
+    w->since_resum = 0;                                                               \
+  }                                                                                   \
+                                                                                      \
+  /* Drop expired fronts, pop dominated backs, append (v, s) */                      \
+  static inline void NAME##_deque_push(NAME##_deque *d, TYPE v, uint32_t s,           \
+                                       int keep_max) {                                \
+    while (d->n && (uint32_t)(s - d->q[d->front].seq) >= (uint32_t)(CAP)) {           \
+      d->front = NAME##_rb_wrap(d->front + 1);                                        \
+      d->n--;                                                                         \
+    }                                                                                 \
+    while (d->n) {                                                                    \
+      TYPE b = d->q[NAME##_rb_wrap(d->front + d->n - 1)].v;                           \
+      if (keep_max ? (b > v) : (b < v)) break;                                        \
+      d->n--;                                                                         \
+    }                                                                                 \
+    NAME##_mono m = {v, s};                                                           \
+    d->q[NAME##_rb_wrap(d->front + d->n)] = m;                                        \
+    d->n++;                                                                           \
+  }                                                                                   \
+                                                                                      \
+  static inline size_t NAME##_oldest_idx(const NAME *w) {                             \
+    return (w->rb.count < (CAP)) ? 0 : w->rb.head;                                    \
+  }                                                                                   \
+                                                                                      \
+  /* Exact O(CAP) recomputation of the regression sums */                             \
+  static inline void NAME##_resum(NAME *w) {                                          \
+    size_t start = NAME##_oldest_idx(w);                                              \
+    w->t_base = w->t[NAME##_rb_wrap(start)];                                          \
+    w->st = w->stt = w->sx = w->stx = 0.0;                                            \
+    for (size_t k = 0; k < w->rb.count; ++k) {                                        \
+      size_t i = NAME##_rb_wrap(start + k);                                           \
+      double dt = (double)(w->t[i] - w->t_base);                                      \
+      double x = (double)w->rb.buf[i];                                                \
+      w->st += dt; w->stt += dt * dt; w->sx += x; w->stx += dt * x;                   \
+    }                                                                                 \
+    w->since_resum = 0;                                                               \
+  }                                                                                   \
+                                                                                      \
+  static inline void NAME##_push(NAME *w, TYPE v, int64_t t) {                        \
+    size_t idx = w->rb.head;                                                          \
+    if (w->rb.count == 0) {                                                           \
+      w->t_base = t;                                                                  \
+    }                                                                                 \
+    if (w->rb.count == (CAP)) { /* slot idx holds the point being evicted */          \
+      double dt = (double)(w->t[idx] - w->t_base);                                    \
+      double x = (double)w->rb.buf[idx];                                              \
+      w->st -= dt; w->stt -= dt * dt; w->sx -= x; w->stx -= dt * x;                   \
+    }                                                                                 \
+    {                                                                                 \
+      double dt = (double)(t - w->t_base);                                            \
+      double x = (double)v;                                                           \
+      w->st += dt; w->stt += dt * dt; w->sx += x; w->stx += dt * x;                   \
+    }                                                                                 \
+    w->t[idx] = t;                                                                    \
+    NAME##_rb_push(&w->rb, v);                                                        \
+    NAME##_deque_push(&w->lo, v, w->seq, 0);                                          \
+    NAME##_deque_push(&w->hi, v, w->seq, 1);                                          \
+    w->seq++;                                                                         \
+                                                                                      \
+    /* Rebase sums onto the new oldest point: t' = t - d */                          \
+    int64_t t_old = w->t[NAME##_rb_wrap(NAME##_oldest_idx(w))];                       \
+    if (t_old != w->t_base) {                                                         \
+      double d = (double)(t_old - w->t_base);                                         \
+      double n = (double)w->rb.count;                                                 \
+      w->stt += -2.0 * d * w->st + n * d * d;                                         \
+      w->stx -= d * w->sx;                                                            \
+      w->st -= n * d;                                                                 \
+      w->t_base = t_old;                                                              \
+    }                                                                                 \
+    if (++w->since_resum >= (CAP)) {                                                  \
+      NAME##_resum(w);                                                                \
+    }                                                                                 \
+  }                                                                                   \
+                                                                                      \
+  static inline size_t NAME##_size(const NAME *w)  { return w->rb.count; }            \
+  static inline TYPE   NAME##_newest(const NAME *w){ return NAME##_rb_newest(&w->rb); }\
+  static inline TYPE   NAME##_recent(const NAME *w, size_t i) {                       \
+    return NAME##_rb_recent(&w->rb, i);                                               \
+  }                                                                                   \
+  static inline double NAME##_mean(const NAME *w) {                                   \
+    return w->rb.count ? w->sx / (double)w->rb.count : 0.0;                           \
+  }                                                                                   \
+  /* Valid only if size() > 0 */                                                      \
+  static inline TYPE NAME##_min(const NAME *w) { return w->lo.q[w->lo.front].v; }     \
+  static inline TYPE NAME##_max(const NAME *w) { return w->hi.q[w->hi.front].v; }     \
+  static inline int64_t NAME##_oldest_t(const NAME *w) { return w->t_base; }          \
+  static inline int64_t NAME##_newest_t(const NAME *w) {                              \
+    return w->t[NAME##_rb_wrap(w->rb.head + (CAP) - 1)];                              \
+  }                                                                                   \
+                                                                                      \
+  /* Least-squares line through the window. slope is in TYPE units per t unit;     \
+     fitted is the line evaluated at the newest point. False if < 2 points or      \
+     all points share one t. */                                                       \
+  static inline bool NAME##_fit(const NAME *w, double *slope, double *fitted) {       \
+    double n = (double)w->rb.count;                                                   \
+    if (w->rb.count < 2) return false;                                                \
+    double den = n * w->stt - w->st * w->st;                                          \
+    if (den <= 0.0) return false;                                                     \
+    double b = (n * w->stx - w->st * w->sx) / den;                                    \
+    double a = (w->sx - b * w->st) / n;                                               \
+    if (slope) *slope = b;                                                            \
+    if (fitted) *fitted = a + b * (double)(NAME##_newest_t(w) - w->t_base);           \
+    return true;                                                                      \
+  }
@@ -0,0 +1,67 @@
+// run_capture.c — CAP record emitter; format documented in run_capture.h
+
+#include "run_capture.h"
+#include "actuator.h"
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+
+static volatile bool s_active = false;
+static int64_t s_last_sample_ms = 0;
+
+static inline long long uptime_ms(void) {
+  return (long long)(esp_timer_get_time() / 1000);
+}
+
+bool run_capture_active(void) { return RUN_CAPTURE_ENABLED && s_active; }
+
+void run_capture_begin(const char *program, time_t epoch) {
+  if (!RUN_CAPTURE_ENABLED) {
+    return;
+  }
+  s_last_sample_ms = 0;
+  s_active = true;
+  _LOG_I("CAP,H,%lld,%lld,%s", uptime_ms(), (long long)epoch,
+         SAFE_STR(program));
+}
+
+void run_capture_end(void) {
+  if (!run_capture_active()) {
+    return;
+  }
+  _LOG_I("CAP,E,%lld", uptime_ms());
+  s_active = false;
+}
+
+void run_capture_sample(int raw_mean, int mv_mean) {
+  if (!run_capture_active()) {
+    return;
+  }
+  const long long t = uptime_ms();
+  if (s_last_sample_ms != 0 && (t - s_last_sample_ms) < RUN_CAPTURE_SAMPLE_MS) {
+    return;
+  }
+  s_last_sample_ms = t;
+  _LOG_I("CAP,S,%lld,%d,%d,%llx", t, raw_mean, mv_mean,
+         (unsigned long long)actuator_get_mask());
+}
+
+void run_capture_action(int action) {
+  if (!run_capture_active()) {
+    return;
+  }
+  _LOG_I("CAP,A,%lld,%d", uptime_ms(), action);
+}
+
+void run_capture_decision(time_t epoch, int step, const char *kind,
+                          const char *arg) {
+  if (!run_capture_active()) {
+    return;
+  }
+  if (arg) {
+    _LOG_I("CAP,D,%lld,%lld,%d,%s,%s", uptime_ms(), (long long)epoch, step,
+           SAFE_STR(kind), arg);
+  } else {
+    _LOG_I("CAP,D,%lld,%lld,%d,%s", uptime_ms(), (long long)epoch, step,
+           SAFE_STR(kind));
+  }
+}
@@ -0,0 +1,41 @@
+// run_capture.h — record a live wash run for host replay (tools/replay)
+#pragma once
+
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Records are emitted as log lines (mirrored to the UDP log sink by
+ * logger.c), one record per line, comma separated after a "CAP," marker:
+ *   CAP,H,<t_ms>,<epoch_s>,<program>           run header
+ *   CAP,S,<t_ms>,<raw_mean>,<mv_mean>,<mask>   ADC sample + actuator latch (hex)
+ *   CAP,A,<t_ms>,<action>                      dispatched actions_t value
+ *   CAP,D,<t_ms>,<epoch_s>,<step>,<kind>[,<arg>]
+ *       decision: BEGIN, HEAT_ON, HEAT_OFF, END,<step_end_name>
+ *   CAP,E,<t_ms>                               run finished
+ * t_ms is uptime; epoch_s is the get_unix_epoch() value run_program() used.
+ * Samples are decimated to one per RUN_CAPTURE_SAMPLE_MS.
+ */
+#ifndef RUN_CAPTURE_ENABLED
+#define RUN_CAPTURE_ENABLED 1
+#endif
+#ifndef RUN_CAPTURE_SAMPLE_MS
+#define RUN_CAPTURE_SAMPLE_MS 1000
+#endif
+
+void run_capture_begin(const char *program, time_t epoch);
+void run_capture_end(void);
+bool run_capture_active(void);
+
+void run_capture_sample(int raw_mean, int mv_mean);
+void run_capture_action(int action);
+void run_capture_decision(time_t epoch, int step, const char *kind,
+                          const char *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+// status_cache.c — double-buffered /status bodies; see status_cache.h
+// - s_render_lock: one build at a time; its holder owns the back buffer
+//   and is the only writer of s_front
+// - s_swap_lock: held to copy out of the front buffer or to swap it
+
+#include "status_cache.h"
+
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "http_server.h"
+#include "status_cbor.h"
+#include "status_json.h"
+#include "status_watch.h"
+
+#include <string.h>
+
+typedef struct {
+  uint32_t version;
+  int64_t built_us;
+  size_t json_len; // 0: did not fit
+  size_t cbor_len;
+  char json[STATUS_JSON_MAX];
+  uint8_t cbor[STATUS_CBOR_MAX];
+} status_build_t;
+
+static status_build_t s_builds[2];
+static int s_front = -1; // none yet
+static SemaphoreHandle_t s_render_lock = NULL;
+static SemaphoreHandle_t s_swap_lock = NULL;
+static uint32_t s_copies = 0; // under s_swap_lock
+static uint32_t s_builds_made = 0;
+
+// Render state, s_render_lock holder only
+static status_view_t s_view;
+
+static bool is_fresh(const status_build_t *b) {
+  return b->version == status_watch_version() &&
+         esp_timer_get_time() - b->built_us < STATUS_CACHE_TTL_MS * 1000LL;
+}
+
+// s_render_lock held
+static void build_locked(void) {
+  if (s_front >= 0 && is_fresh(&s_builds[s_front])) {
+    return; // another reader built it while this one waited
+  }
+  const int back = (s_front == 0) ? 1 : 0;
+  status_build_t *b = &s_builds[back];
+  // Latency is filled here only, and builds never overlap
+  http_server_fill_status(&s_view, true);
+  b->version = s_view.version;
+  b->built_us = esp_timer_get_time();
+  b->json_len = status_json_render(&s_view, b->json, sizeof(b->json));
+  b->cbor_len = status_cbor_render(&s_view, b->cbor, sizeof(b->cbor));
+  if (b->json_len == 0) {
+    _LOG_E("status body exceeds %d bytes", STATUS_JSON_MAX);
+  }
+  xSemaphoreTake(s_swap_lock, portMAX_DELAY);
+  s_front = back;
+  s_builds_made++;
+  xSemaphoreGive(s_swap_lock);
+}
+
+esp_err_t status_cache_init(void) {
+  if (!s_render_lock) {
+    s_render_lock = xSemaphoreCreateMutex();
+  }
+  if (!s_swap_lock) {
+    s_swap_lock = xSemaphoreCreateMutex();
+  }
+  return (s_render_lock && s_swap_lock) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void status_cache_refresh(void) {
+  if (!s_render_lock || !s_swap_lock) {
+    return;
+  }
+  xSemaphoreTake(s_render_lock, portMAX_DELAY);
+  build_locked();
+  xSemaphoreGive(s_render_lock);
+}
+
+size_t status_cache_copy(status_cache_fmt_t fmt, void *out, size_t cap) {
+  if (!s_render_lock || !s_swap_lock) {
+    return 0;
+  }
+  // Second pass copies whatever the build produced, even if the version
+  // moved again meanwhile; the next request catches up
+  for (int pass = 0; pass < 2; pass++) {
+    xSemaphoreTake(s_swap_lock, portMAX_DELAY);
+    const status_build_t *b = (s_front >= 0) ? &s_builds[s_front] : NULL;
+    if (b && (pass == 1 || is_fresh(b))) {
+      const bool json = (fmt == STATUS_CACHE_JSON);
+      size_t len = json ? b->json_len : b->cbor_len;
+      if (len > cap) {
+        len = 0;
+      }
+      memcpy(out, json ? (const void *)b->json : (const void *)b->cbor, len);
+      s_copies++;
+      xSemaphoreGive(s_swap_lock);
+      return len;
+    }
+    xSemaphoreGive(s_swap_lock);
+    if (pass == 0) {
+      status_cache_refresh();
+    }
+  }
+  return 0;
+}
+
+void status_cache_get_counts(uint32_t *copies, uint32_t *builds) {
+  uint32_t c = 0;
+  uint32_t n = 0;
+  if (s_swap_lock) {
+    xSemaphoreTake(s_swap_lock, portMAX_DELAY);
+    c = s_copies;
+    n = s_builds_made;
+    xSemaphoreGive(s_swap_lock);
+  }
+  if (copies) {
+    *copies = c;
+  }
+  if (builds) {
+    *builds = n;
+  }
+}
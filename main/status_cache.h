@@ -0,0 +1,54 @@
+// status_cache.h — /status bodies rendered once and shared by all readers
+#pragma once
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each build holds the JSON and CBOR bodies from one status snapshot. A
+ * build stays current while status_watch_version() is unchanged and it is
+ * younger than STATUS_CACHE_TTL_MS. The TTL is what moves the running
+ * durations (elapsed, remaining) on.
+ *
+ * Builds happen in two places. The status watcher rebuilds as soon as the
+ * version moves. A reader that finds the build stale rebuilds lazily. Only
+ * one build runs at a time, and several readers missing together share it.
+ *
+ * There are two buffers. A build writes the back one and then swaps it in
+ * under a short lock. Readers copy bytes out of the front one under that
+ * same lock, so a reader holding a fresh build waits only on a memcpy. A
+ * reader whose build has gone stale renders it (or waits for the render
+ * already running) before it copies.
+ */
+
+#define STATUS_CACHE_TTL_MS 500
+
+typedef enum {
+  STATUS_CACHE_JSON = 0,
+  STATUS_CACHE_CBOR,
+} status_cache_fmt_t;
+
+/** Create the locks; call before anything reads or refreshes. */
+esp_err_t status_cache_init(void);
+
+/** Rebuild now unless the current build is still fresh (producer side). */
+void status_cache_refresh(void);
+
+/**
+ * Copy the current body in fmt into out, rebuilding first if it is stale.
+ * Returns the length, or 0 when the body did not fit (in the build, or in
+ * cap) or before status_cache_init().
+ */
+size_t status_cache_copy(status_cache_fmt_t fmt, void *out, size_t cap);
+
+/** Copies served, and builds made, since boot. */
+void status_cache_get_counts(uint32_t *copies, uint32_t *builds);
+
+#ifdef __cplusplus
+}
+#endif
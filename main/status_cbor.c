@@ -0,0 +1,71 @@
+// status_cbor.c — CBOR /status encoder; see status_cbor.h
+
+#include "status_cbor.h"
+
+#include "cbor_enc.h"
+
+size_t status_cbor_render(const status_view_t *v, uint8_t *buf, size_t cap) {
+  cbor_enc_t e = CBOR_ENC_INIT(buf, cap);
+  cbor_map(&e, v->trend_valid ? 27 : 26);
+  cbor_uint(&e, STATUS_CBOR_VERSION);
+  cbor_uint(&e, v->version);
+  cbor_uint(&e, STATUS_CBOR_PROGRAM);
+  cbor_text(&e, v->program);
+  cbor_uint(&e, STATUS_CBOR_CYCLE);
+  cbor_text(&e, v->cycle);
+  cbor_uint(&e, STATUS_CBOR_STEP);
+  cbor_text(&e, v->step);
+  cbor_uint(&e, STATUS_CBOR_CYCLE_INDEX);
+  cbor_int(&e, v->cycle_index);
+  cbor_uint(&e, STATUS_CBOR_CYCLES_TOTAL);
+  cbor_int(&e, v->cycles_total);
+  cbor_uint(&e, STATUS_CBOR_STEP_INDEX);
+  cbor_int(&e, v->step_index);
+  cbor_uint(&e, STATUS_CBOR_STEPS_TOTAL);
+  cbor_int(&e, v->steps_total);
+  cbor_uint(&e, STATUS_CBOR_TEMP_F);
+  cbor_int(&e, v->current_temp);
+  cbor_uint(&e, STATUS_CBOR_POWER);
+  cbor_int(&e, v->current_power);
+  cbor_uint(&e, STATUS_CBOR_DEVICE_MASK);
+  cbor_uint(&e, v->device_mask);
+  cbor_uint(&e, STATUS_CBOR_DEVICES);
+  cbor_text(&e, v->devices);
+  cbor_uint(&e, STATUS_CBOR_LEDS);
+  cbor_text(&e, v->leds);
+  cbor_uint(&e, STATUS_CBOR_HEAT_REQUESTED);
+  cbor_bool(&e, v->heat_requested);
+  cbor_uint(&e, STATUS_CBOR_HEAT_REACHED);
+  cbor_bool(&e, v->heat_reached);
+  cbor_uint(&e, STATUS_CBOR_SKIP_STEP);
+  cbor_bool(&e, v->skip_step);
+  cbor_uint(&e, STATUS_CBOR_SOAP_DISPENSED);
+  cbor_bool(&e, v->soap_dispensed);
+  cbor_uint(&e, STATUS_CBOR_FIRMWARE);
+  cbor_text(&e, v->firmware_status);
+  cbor_uint(&e, STATUS_CBOR_IP);
+  cbor_text(&e, v->ip);
+  cbor_uint(&e, STATUS_CBOR_ELAPSED_MS);
+  cbor_int(&e, v->elapsed_ms);
+  cbor_uint(&e, STATUS_CBOR_REMAINING_MS);
+  cbor_int(&e, v->remaining_ms);
+  cbor_uint(&e, STATUS_CBOR_START_MS);
+  cbor_int(&e, v->start_epoch_ms);
+  cbor_uint(&e, STATUS_CBOR_END_MS);
+  cbor_int(&e, v->end_epoch_ms);
+  cbor_uint(&e, STATUS_CBOR_LAST_TRANSITION);
+  cbor_int(&e, v->last_transition);
+  cbor_uint(&e, STATUS_CBOR_CYCLE_START);
+  cbor_int(&e, v->time_cycle_start);
+  cbor_uint(&e, STATUS_CBOR_CYCLE_TOTAL);
+  cbor_int(&e, v->time_cycle_total);
+  if (v->trend_valid) {
+    cbor_uint(&e, STATUS_CBOR_TREND);
+    cbor_array(&e, 4);
+    cbor_float(&e, v->rate_f_per_min);
+    cbor_int(&e, v->secs_to_min_temp);
+    cbor_int(&e, v->secs_to_max_temp);
+    cbor_float(&e, v->overshoot_f);
+  }
+  return e.overflow ? 0 : e.len;
+}
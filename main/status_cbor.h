@@ -0,0 +1,75 @@
+// status_cbor.h — /status and /history as CBOR with integer keys
+#pragma once
+
+#include "status_json.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Same data as the JSON bodies, for pollers that parse it by the thousand.
+ * Keys are the small integers below (one byte each on the wire). Times are
+ * raw numbers: durations in ms, instants in Unix epoch ms. The client does
+ * the MM:SS / time-of-day formatting that the JSON does on the device.
+ * Keys are only ever appended, so decoders should ignore unknown ones.
+ */
+
+// Keys of the /status map
+typedef enum {
+  STATUS_CBOR_VERSION = 0,           // uint, status_watch_version()
+  STATUS_CBOR_PROGRAM = 1,           // text
+  STATUS_CBOR_CYCLE = 2,             // text
+  STATUS_CBOR_STEP = 3,              // text
+  STATUS_CBOR_CYCLE_INDEX = 4,       // int
+  STATUS_CBOR_CYCLES_TOTAL = 5,      // int
+  STATUS_CBOR_STEP_INDEX = 6,        // int
+  STATUS_CBOR_STEPS_TOTAL = 7,       // int
+  STATUS_CBOR_TEMP_F = 8,            // int, °F as in CurrentTemp
+  STATUS_CBOR_POWER = 9,             // int
+  STATUS_CBOR_DEVICE_MASK = 10,      // uint, GPIO bit mask of on actuators
+  STATUS_CBOR_DEVICES = 11,          // text
+  STATUS_CBOR_LEDS = 12,             // text
+  STATUS_CBOR_HEAT_REQUESTED = 13,   // bool
+  STATUS_CBOR_HEAT_REACHED = 14,     // bool
+  STATUS_CBOR_SKIP_STEP = 15,        // bool
+  STATUS_CBOR_SOAP_DISPENSED = 16,   // bool
+  STATUS_CBOR_FIRMWARE = 17,         // text
+  STATUS_CBOR_IP = 18,               // text
+  STATUS_CBOR_ELAPSED_MS = 19,       // int, -1 unknown
+  STATUS_CBOR_REMAINING_MS = 20,     // int, -1 unknown
+  STATUS_CBOR_START_MS = 21,         // int, epoch ms, 0 not started
+  STATUS_CBOR_END_MS = 22,           // int, epoch ms, 0 unknown
+  STATUS_CBOR_LAST_TRANSITION = 23,  // int, as stored in ActiveStatus
+  STATUS_CBOR_TREND = 24,            // [rate °F/min (float), s to min,
+                                     //  s to max, overshoot °F (float)];
+                                     //  only while the trend is valid
+  STATUS_CBOR_CYCLE_START = 25,      // int, as stored in ActiveStatus
+  STATUS_CBOR_CYCLE_TOTAL = 26,      // int, as stored in ActiveStatus
+} status_cbor_key_t;
+
+#define STATUS_CBOR_MAX 256 // worst case /status body is ~240 bytes
+
+/** Encode v; returns the length, or 0 if it did not fit in cap. */
+size_t status_cbor_render(const status_view_t *v, uint8_t *buf, size_t cap);
+
+/*
+ * /history: map {0: tier, 1: bucket_ms, 2: first_seq, 3: first_epoch_s,
+ * 4: [_ bucket, ...]} where each bucket is [min, max, mean] in 0.1 °F, or
+ * null for an interval without samples. The bucket array is
+ * indefinite-length so it can be streamed; it may end early if the ring
+ * overtakes the reader.
+ */
+typedef enum {
+  HISTORY_CBOR_TIER = 0,
+  HISTORY_CBOR_BUCKET_MS = 1,
+  HISTORY_CBOR_FIRST_SEQ = 2,
+  HISTORY_CBOR_FIRST_EPOCH_S = 3,
+  HISTORY_CBOR_BUCKETS = 4,
+} history_cbor_key_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,249 @@
+// status_json.c — /status JSON renderer; see status_json.h
+
+#include "status_json.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define EST_OFFSET_SECONDS (-5 * 3600)
+
+// Append-only writer; once anything is cut off, every later append fails
+typedef struct {
+  char *buf;
+  size_t cap;
+  size_t len;
+  bool first;
+  bool overflow;
+} jw_t;
+
+static void jw_printf(jw_t *w, const char *fmt, ...) {
+  if (w->overflow) {
+    return;
+  }
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(w->buf + w->len, w->cap - w->len, fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= w->cap - w->len) {
+    w->overflow = true;
+    return;
+  }
+  w->len += (size_t)n;
+}
+
+static void jw_key(jw_t *w, const char *key) {
+  jw_printf(w, w->first ? "\"%s\":" : ",\"%s\":", key);
+  w->first = false;
+}
+
+static void jw_putc(jw_t *w, char c) {
+  if (w->overflow || w->len + 1 >= w->cap) {
+    w->overflow = true;
+    return;
+  }
+  w->buf[w->len++] = c;
+  w->buf[w->len] = '\0';
+}
+
+// Status strings are short device-side labels, but escape them anyway so a
+// stray quote cannot break the document
+static void jw_str(jw_t *w, const char *key, const char *val) {
+  jw_key(w, key);
+  jw_putc(w, '"');
+  for (const char *p = val ? val : ""; *p && !w->overflow; ++p) {
+    const unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') {
+      jw_putc(w, '\\');
+      jw_putc(w, (char)c);
+    } else if (c < 0x20) {
+      jw_printf(w, "\\u%04x", c);
+    } else {
+      jw_putc(w, (char)c);
+    }
+  }
+  jw_putc(w, '"');
+}
+
+static void jw_int(jw_t *w, const char *key, int64_t val) {
+  jw_key(w, key);
+  jw_printf(w, "%" PRId64, val);
+}
+
+static void jw_float(jw_t *w, const char *key, float val) {
+  jw_key(w, key);
+  jw_printf(w, "%.2f", (double)val);
+}
+
+static void jw_bool(jw_t *w, const char *key, bool b) {
+  jw_key(w, key);
+  jw_printf(w, b ? "true" : "false");
+}
+
+static void jw_null(jw_t *w, const char *key) {
+  jw_key(w, key);
+  jw_printf(w, "null");
+}
+
+const char *status_ms_to_mmss(int64_t ms, char out[8]) {
+  if (ms < 0) {
+    strcpy(out, "--:--");
+    return out;
+  }
+  int64_t secs = ms / 1000;
+  int mm = (int)(secs / 60);
+  int ss = (int)(secs % 60);
+  snprintf(out, 8, "%02d:%02d", mm, ss);
+  return out;
+}
+
+void status_format_est_time_ms(int64_t epoch_ms, char out[16]) {
+  if (epoch_ms <= 0) {
+    strcpy(out, "--:--");
+    return;
+  }
+  time_t t = (time_t)(epoch_ms / 1000) + EST_OFFSET_SECONDS;
+  struct tm tmv;
+  gmtime_r(&t, &tmv);
+  int hh = tmv.tm_hour % 12;
+  if (hh == 0) {
+    hh = 12;
+  }
+  const char *ampm = (tmv.tm_hour >= 12) ? "PM" : "AM";
+  snprintf(out, 16, "%02d:%02d %s", hh, tmv.tm_min, ampm);
+}
+
+// A field is written when there is no previous view or it differs from it.
+// Views are zeroed before they are filled, so whole-array compares are exact.
+#define CHANGED(f) (!prev || memcmp(&prev->f, &v->f, sizeof(v->f)) != 0)
+
+size_t status_json_render_delta(const status_view_t *prev,
+                                const status_view_t *v, char *buf,
+                                size_t cap) {
+  jw_t w = {.buf = buf, .cap = cap, .len = 0, .first = true};
+  char text[112]; // Program summary: three names plus four indices
+
+  jw_printf(&w, "{");
+  if (CHANGED(version)) {
+    jw_int(&w, "version", v->version);
+  }
+  if (CHANGED(program) || CHANGED(cycle) || CHANGED(step) ||
+      CHANGED(cycle_index) || CHANGED(cycles_total) || CHANGED(step_index) ||
+      CHANGED(steps_total)) {
+    snprintf(text, sizeof(text),
+             "%s->%s->%s Cycle %ld of %ld, step %ld of %ld", v->program,
+             v->cycle, v->step, (long)v->cycle_index, (long)v->cycles_total,
+             (long)v->step_index, (long)v->steps_total);
+    jw_str(&w, "Program", text);
+  }
+  if (CHANGED(program)) {
+    jw_str(&w, "ProgramName", v->program);
+  }
+  if (CHANGED(cycle)) {
+    jw_str(&w, "Cycle", v->cycle);
+  }
+  if (CHANGED(step)) {
+    jw_str(&w, "Step", v->step);
+  }
+  if (CHANGED(cycle_index)) {
+    jw_int(&w, "CycleIndex", v->cycle_index);
+  }
+  if (CHANGED(cycles_total)) {
+    jw_int(&w, "CyclesTotal", v->cycles_total);
+  }
+  if (CHANGED(step_index)) {
+    jw_int(&w, "StepIndex", v->step_index);
+  }
+  if (CHANGED(steps_total)) {
+    jw_int(&w, "StepsTotal", v->steps_total);
+  }
+  if (CHANGED(last_transition)) {
+    jw_int(&w, "LastTransition", v->last_transition);
+  }
+  if (CHANGED(time_cycle_start)) {
+    jw_int(&w, "time_cycle_start", v->time_cycle_start);
+  }
+  if (CHANGED(time_cycle_total)) {
+    jw_int(&w, "time_cycle_total", v->time_cycle_total);
+  }
+  if (CHANGED(current_temp)) {
+    jw_int(&w, "CurrentTemp", v->current_temp);
+  }
+  if (CHANGED(current_power)) {
+    jw_int(&w, "CurrentPower", v->current_power);
+  }
+  if (CHANGED(device_mask)) {
+    jw_int(&w, "ActiveDeviceMask", (int64_t)v->device_mask);
+  }
+  if (CHANGED(devices)) {
+    jw_str(&w, "ActiveDevices", v->devices);
+  }
+  if (CHANGED(leds)) {
+    jw_str(&w, "ActiveLEDs", v->leds);
+  }
+  if (CHANGED(heat_requested)) {
+    jw_bool(&w, "HEAT_REQUESTED", v->heat_requested);
+  }
+  if (CHANGED(heat_reached)) {
+    jw_bool(&w, "HEAT_REACHED", v->heat_reached);
+  }
+  if (CHANGED(skip_step)) {
+    jw_bool(&w, "SkipStep", v->skip_step);
+  }
+  if (CHANGED(firmware_status)) {
+    jw_str(&w, "FirmwareStatus", v->firmware_status);
+  }
+  if (CHANGED(ip)) {
+    jw_str(&w, "IPAddress", v->ip);
+  }
+  if (v->trend_valid &&
+      (CHANGED(trend_valid) || CHANGED(rate_f_per_min) ||
+       CHANGED(secs_to_min_temp) || CHANGED(secs_to_max_temp) ||
+       CHANGED(overshoot_f))) {
+    jw_float(&w, "heat_rate_f_per_min", v->rate_f_per_min);
+    jw_int(&w, "secs_to_min_temp", v->secs_to_min_temp);
+    jw_int(&w, "secs_to_max_temp", v->secs_to_max_temp);
+    jw_float(&w, "overshoot_f", v->overshoot_f);
+  } else if (prev && !v->trend_valid && CHANGED(trend_valid)) {
+    // A full render just leaves them out; a delta has to clear what the
+    // client merged earlier
+    jw_null(&w, "heat_rate_f_per_min");
+    jw_null(&w, "secs_to_min_temp");
+    jw_null(&w, "secs_to_max_temp");
+    jw_null(&w, "overshoot_f");
+  }
+  // Latency describes the server, not the machine; full renders only
+  if (!prev && v->http_count) {
+    jw_int(&w, "http_p50_us", v->http_p50_us);
+    jw_int(&w, "http_p99_us", v->http_p99_us);
+    jw_int(&w, "http_max_us", v->http_max_us);
+  }
+  if (CHANGED(elapsed_ms)) {
+    jw_str(&w, "since_start_mmss", status_ms_to_mmss(v->elapsed_ms, text));
+  }
+  if (CHANGED(remaining_ms)) {
+    jw_str(&w, "remaining_mmss", status_ms_to_mmss(v->remaining_ms, text));
+    jw_str(&w, "eta_finish_mmss", status_ms_to_mmss(v->remaining_ms, text));
+  }
+  if (CHANGED(start_epoch_ms)) {
+    status_format_est_time_ms(v->start_epoch_ms, text);
+    jw_str(&w, "start_time_est", text);
+  }
+  if (CHANGED(end_epoch_ms)) {
+    status_format_est_time_ms(v->end_epoch_ms, text);
+    jw_str(&w, "end_time_est", text);
+  }
+  if (CHANGED(soap_dispensed)) {
+    jw_bool(&w, "soap_has_dispensed", v->soap_dispensed);
+  }
+  jw_printf(&w, "}\n");
+  return w.overflow ? 0 : w.len;
+}
+
+#undef CHANGED
+
+size_t status_json_render(const status_view_t *v, char *buf, size_t cap) {
+  return status_json_render_delta(NULL, v, buf, cap);
+}
@@ -0,0 +1,88 @@
+// status_json.h — /status body rendered into one caller-owned buffer
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The HTTP handler copies everything /status reports into a status_view_t
+ * first (one pass over ActiveStatus and the other sources), then renders the
+ * JSON from that copy with no further reads of shared state, no heap and no
+ * socket writes; the caller sends the buffer in one go.
+ *
+ * Plain C with no ESP-IDF headers so tools/bench can time it on the host.
+ */
+
+#define STATUS_JSON_MAX 1536 // worst case body, all strings full length
+
+typedef struct {
+  uint32_t version; // status_watch_version() when filled
+  // Program position (ActiveStatus)
+  char program[10];
+  char cycle[10];
+  char step[10];
+  int32_t cycle_index, cycles_total;
+  int32_t step_index, steps_total;
+  int64_t last_transition; // ActiveStatus.LastTransitionMs as stored
+  int64_t time_cycle_start; // ActiveStatus, as stored
+  int64_t time_cycle_total;
+  // Machine state
+  int current_temp;
+  int current_power;
+  uint64_t device_mask;
+  char devices[8];
+  char leds[8];
+  bool heat_requested;
+  bool heat_reached;
+  bool skip_step;
+  bool soap_dispensed;
+  char firmware_status[20];
+  char ip[16];
+  // Timing, ms; -1 when unknown (elapsed/remaining), 0 when not started
+  int64_t elapsed_ms;
+  int64_t remaining_ms;
+  int64_t start_epoch_ms;
+  int64_t end_epoch_ms;
+  // Heating trend (analog_get_trend)
+  bool trend_valid;
+  float rate_f_per_min;
+  int32_t secs_to_min_temp;
+  int32_t secs_to_max_temp;
+  float overshoot_f;
+  // Handler latency over all routes
+  uint32_t http_count;
+  uint32_t http_p50_us, http_p99_us, http_max_us;
+} status_view_t;
+
+/**
+ * Render v as a JSON object (with trailing newline) into buf. Returns the
+ * length, or 0 if it did not fit in cap.
+ */
+size_t status_json_render(const status_view_t *v, char *buf, size_t cap);
+
+/**
+ * Like status_json_render(), but only the keys whose source fields differ
+ * between prev and v (all keys when prev is NULL; server latency only then).
+ * Keys that a full render omits (the heating trend once it turns invalid)
+ * are sent as null.
+ * Both views must have been zeroed before filling. Nothing changed renders
+ * "{}\n" (STATUS_JSON_EMPTY_LEN bytes).
+ */
+size_t status_json_render_delta(const status_view_t *prev,
+                                const status_view_t *v, char *buf, size_t cap);
+#define STATUS_JSON_EMPTY_LEN 3
+
+/** "MM:SS", or "--:--" for a negative duration. */
+const char *status_ms_to_mmss(int64_t ms, char out[8]);
+
+/** "hh:mm AM" in EST, or "--:--" for epoch_ms <= 0. */
+void status_format_est_time_ms(int64_t epoch_ms, char out[16]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,206 @@
+// status_watch.c — status version and long-poll parking; see status_watch.h
+// - The watcher task is the only writer of the version and the only task
+//   that answers parked requests
+// - The bus wait is capped so deadlines of newly parked requests are met
+//   within WATCH_TICK_MS even when nothing is published
+
+#include "status_watch.h"
+
+#include "dishwasher_programs.h"
+#include "event_bus.h"
+#include "http_conn.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "http_server.h"
+#include "status_cache.h"
+#include "status_json.h"
+
+#define WATCH_TASK_STACK 3072
+#define WATCH_TASK_PRIO 4
+#define WATCH_TICK_MS 1000
+
+typedef struct {
+  bool claimed;
+  httpd_req_t *req; // detached; NULL until then
+  uint32_t since;
+  TickType_t deadline;
+  bool cbor;
+} parked_t;
+
+static parked_t s_parked[STATUS_WATCH_MAX_PARKED];
+static volatile uint32_t s_version = 0;
+static int s_sub = -1;
+static uint32_t s_total = 0;
+static uint32_t s_timeouts = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Watcher task only
+static char s_body[STATUS_JSON_MAX];
+
+uint32_t status_watch_version(void) { return s_version; }
+
+// Whether ev changes anything /status shows; last_temp tracks whole degrees
+static bool is_change(const bus_event_t *ev, int *last_temp) {
+  switch (ev->type) {
+  case BUS_EV_STEP:
+  case BUS_EV_ACTUATOR:
+  case BUS_EV_FIRMWARE:
+    return true;
+  case BUS_EV_TEMP:
+    if (ev->temp.temp_f_int != *last_temp) {
+      *last_temp = ev->temp.temp_f_int;
+      return true;
+    }
+    return false;
+  default:
+    return false;
+  }
+}
+
+static void answer(httpd_req_t *req, bool cbor) {
+  http_conn_pin(httpd_req_to_sockfd(req), false);
+  const size_t len = status_cache_copy(
+      cbor ? STATUS_CACHE_CBOR : STATUS_CACHE_JSON, s_body, sizeof(s_body));
+  if (len == 0) {
+    httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                        "status too large");
+  } else {
+    httpd_resp_set_type(req, cbor ? "application/cbor" : "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_send(req, s_body, (ssize_t)len);
+  }
+  httpd_req_async_handler_complete(req);
+}
+
+// Answer every parked request whose version moved or whose time is up
+static void answer_due(void) {
+  const uint32_t version = s_version;
+  const TickType_t now = xTaskGetTickCount();
+  for (int i = 0; i < STATUS_WATCH_MAX_PARKED; i++) {
+    portENTER_CRITICAL(&s_mux);
+    httpd_req_t *req = s_parked[i].req;
+    const bool cbor = s_parked[i].cbor;
+    const bool moved = req && s_parked[i].since != version;
+    const bool expired = req && (int32_t)(now - s_parked[i].deadline) >= 0;
+    if (moved || expired) {
+      s_parked[i].req = NULL;
+      s_parked[i].claimed = false;
+      if (!moved) {
+        s_timeouts++;
+      }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    if (moved || expired) {
+      answer(req, cbor);
+    }
+  }
+}
+
+static void watch_task(void *arg) {
+  (void)arg;
+  int last_temp = INT32_MIN;
+  for (;;) {
+    bus_event_t ev;
+    bool changed = false;
+    if (event_bus_receive(s_sub, &ev, pdMS_TO_TICKS(WATCH_TICK_MS))) {
+      changed = is_change(&ev, &last_temp);
+      // Everything already queued counts as the same change
+      while (event_bus_receive(s_sub, &ev, 0)) {
+        changed |= is_change(&ev, &last_temp);
+      }
+    }
+    if (changed) {
+      s_version++;
+      // Build the new body now, before the parked requests and the next
+      // pollers ask for it
+      status_cache_refresh();
+    }
+    answer_due();
+  }
+}
+
+esp_err_t status_watch_start(void) {
+  if (s_sub >= 0) {
+    return ESP_OK;
+  }
+  s_sub = event_bus_subscribe(
+      "status_watch", BUS_EV_BIT(BUS_EV_STEP) | BUS_EV_BIT(BUS_EV_TEMP) |
+                          BUS_EV_BIT(BUS_EV_ACTUATOR) |
+                          BUS_EV_BIT(BUS_EV_FIRMWARE));
+  if (s_sub < 0) {
+    return ESP_ERR_NO_MEM;
+  }
+  s_version = 1;
+  if (xTaskCreate(watch_task, "status_watch", WATCH_TASK_STACK, NULL,
+                  WATCH_TASK_PRIO, NULL) != pdPASS) {
+    event_bus_unsubscribe(s_sub);
+    s_sub = -1;
+    s_version = 0;
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+esp_err_t status_watch_park(httpd_req_t *req, uint32_t since,
+                            uint32_t timeout_ms, bool cbor) {
+  if (s_sub < 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (timeout_ms > STATUS_WATCH_MAX_TIMEOUT_MS) {
+    timeout_ms = STATUS_WATCH_MAX_TIMEOUT_MS;
+  }
+  int slot = -1;
+  portENTER_CRITICAL(&s_mux);
+  for (int i = 0; i < STATUS_WATCH_MAX_PARKED; i++) {
+    if (!s_parked[i].claimed) {
+      s_parked[i].claimed = true;
+      slot = i;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (slot < 0) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  httpd_req_t *detached = NULL;
+  const esp_err_t err = httpd_req_async_handler_begin(req, &detached);
+  if (err == ESP_OK) {
+    // Before the slot is published, so answer() always unpins after this
+    http_conn_pin(httpd_req_to_sockfd(detached), true);
+  }
+  portENTER_CRITICAL(&s_mux);
+  if (err == ESP_OK) {
+    // A version change between the caller's check and now is picked up
+    // by the watcher's next pass, within WATCH_TICK_MS
+    s_parked[slot].since = since;
+    s_parked[slot].cbor = cbor;
+    s_parked[slot].deadline =
+        xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+    s_parked[slot].req = detached;
+    s_total++;
+  } else {
+    s_parked[slot].claimed = false;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  return err;
+}
+
+void status_watch_get_counts(uint32_t *parked, uint32_t *total,
+                             uint32_t *timeouts) {
+  uint32_t n = 0;
+  portENTER_CRITICAL(&s_mux);
+  for (int i = 0; i < STATUS_WATCH_MAX_PARKED; i++) {
+    n += s_parked[i].req != NULL;
+  }
+  if (total) {
+    *total = s_total;
+  }
+  if (timeouts) {
+    *timeouts = s_timeouts;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  if (parked) {
+    *parked = n;
+  }
+}
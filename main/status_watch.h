@@ -0,0 +1,51 @@
+// status_watch.h — status version counter and /status?since= long-poll
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The version starts at 1 and goes up by one for every change a client
+ * would see in the machine state. That means a step or program change, an
+ * actuator change, a firmware status change, or a new whole-degree
+ * temperature. Durations that just run on (elapsed, remaining) do not count.
+ *
+ * GET /status?since=N returns at once when the version is not N. Otherwise
+ * the request is detached with httpd_req_async_handler_begin() and parked
+ * here. The watcher task answers it with the new status when the version
+ * moves, or with the unchanged status once its timeout expires. Clients read
+ * the version from the body and send it back as since=.
+ */
+
+#define STATUS_WATCH_MAX_PARKED 4
+#define STATUS_WATCH_DEFAULT_TIMEOUT_MS 25000
+#define STATUS_WATCH_MAX_TIMEOUT_MS 60000
+
+/** Subscribe to the event bus and start the watcher task. */
+esp_err_t status_watch_start(void);
+
+/** Current status version (0 before status_watch_start()). */
+uint32_t status_watch_version(void);
+
+/**
+ * Park req until the version differs from since or timeout_ms passes; the
+ * answer is JSON, or CBOR (status_cbor.h) when cbor is set.
+ * On ESP_OK the request belongs to the watcher and the handler must not
+ * touch it again. Any error leaves req with the caller, to answer at once.
+ */
+esp_err_t status_watch_park(httpd_req_t *req, uint32_t since,
+                            uint32_t timeout_ms, bool cbor);
+
+/** Requests parked now, parked since boot, and answered on timeout. */
+void status_watch_get_counts(uint32_t *parked, uint32_t *total,
+                             uint32_t *timeouts);
+
+#ifdef __cplusplus
+}
+#endif
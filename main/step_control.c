@@ -0,0 +1,143 @@
+// step_control.c — decision logic lifted from run_program() unchanged in
+// behaviour; see step_control.h. No ESP-IDF includes (host-buildable).
+
+#include "step_control.h"
+#include <string.h>
+
+void step_ctl_begin(step_ctl_t *c, const ProgramLineStruct *line, time_t now) {
+  memset(c, 0, sizeof(*c));
+  c->line = line;
+
+  c->base_min = (line->min_time > 0) ? (int)line->min_time : 0;
+  c->base_max = (line->max_time > 0) ? (int)line->max_time : c->base_min; // fallback
+  c->at_min = (line->min_time_at_temp > 0) ? (int)line->min_time_at_temp : 0;
+  c->at_max = (line->max_time_at_temp > 0) ? (int)line->max_time_at_temp : 0;
+
+  c->has_temp_targets = (line->min_temp > 0) || (line->max_temp > 0);
+  c->heat_requested = ((line->gpio_mask & HEAT) != 0);
+  c->max_t = (line->max_temp > 0) ? line->max_temp : 0;
+  c->band_low = (c->max_t > 0) ? (c->max_t - STEP_CTL_HYSTERESIS_F) : 0;
+
+  c->line_start = now;
+  c->must_not_end_before = now + c->base_min;
+  c->must_end_by = now + c->base_max;
+}
+
+step_ctl_result_t step_ctl_tick(step_ctl_t *c, int temp_f, time_t now,
+                                bool skip_requested) {
+  step_ctl_result_t r = {0, STEP_END_NONE};
+  const ProgramLineStruct *line = c->line;
+
+  if (skip_requested) {
+    r.end = STEP_END_SKIPPED;
+    return r;
+  }
+
+  if (c->has_temp_targets) {
+    // Mark the first time we reach min_temp
+    if (!c->heat_reached && line->min_temp > 0 && temp_f >= line->min_temp) {
+      c->heat_reached = true;
+      r.events |= STEP_EV_MIN_TEMP_REACHED;
+    }
+
+    // When we FIRST reach >= min_temp, clamp windows to at-temp spec
+    if (!c->at_temp_started && line->min_temp > 0 &&
+        temp_f >= line->min_temp) {
+      c->at_temp_started = true;
+      c->at_temp_t0 = now;
+      r.events |= STEP_EV_AT_TEMP_STARTED;
+
+      int elapsed = (int)(c->at_temp_t0 - c->line_start);
+      c->original_remaining_at_hit =
+          (c->base_max > 0) ? (c->base_max - elapsed) : 0;
+
+      time_t new_min_end = c->at_temp_t0 + (c->at_min > 0 ? c->at_min : 0);
+      time_t new_max_end = c->at_temp_t0 + (c->at_max > 0 ? c->at_max : 0);
+
+      if (c->at_min > 0 && c->base_max > 0 &&
+          (c->at_temp_t0 + c->at_min) > (c->line_start + c->base_max)) {
+        r.events |= STEP_EV_AT_MIN_PAST_MAX;
+      }
+
+      if (c->at_min > 0 && new_min_end > c->must_not_end_before) {
+        c->must_not_end_before = new_min_end;
+      }
+      if (c->at_max > 0) {
+        c->must_end_by = new_max_end;
+      }
+
+      c->adjusted_remaining = (int)(c->must_not_end_before - c->at_temp_t0);
+      if (c->adjusted_remaining < 0) {
+        c->adjusted_remaining = 0;
+      }
+    }
+
+    // Track at-temp elapsed for end-of-step report
+    if (c->at_temp_started) {
+      c->at_temp_elapsed = now - c->at_temp_t0;
+    }
+
+    // Over-max warning once per line until cooled below hysteresis band
+    if (c->max_t > 0) {
+      if (!c->over_max_warned && temp_f > c->max_t) {
+        c->over_max_warned = true;
+        r.events |= STEP_EV_OVER_MAX;
+      } else if (c->over_max_warned && temp_f <= c->band_low) {
+        // cooled sufficiently; allow a future warning if it spikes again
+        c->over_max_warned = false;
+        r.events |= STEP_EV_OVER_MAX_RESET;
+      }
+    }
+
+    // Hysteresis thermostat around max_temp
+    if (c->max_t > 0) {
+      bool desired_heat = false;
+      if (c->heat_requested) {
+        if (!c->heat_on) {
+          if (temp_f <= c->band_low) {
+            desired_heat = true;
+          }
+        } else {
+          desired_heat = (temp_f < c->max_t);
+        }
+      }
+
+      if (desired_heat && !c->heat_on) {
+        c->heat_on = true;
+        r.events |= STEP_EV_HEAT_RESUMED;
+      } else if (!desired_heat && c->heat_on) {
+        c->heat_on = false;
+        r.events |= STEP_EV_HEAT_PAUSED;
+      }
+    }
+  } else if (c->heat_on) {
+    // No temperature targets: force HEAT off
+    c->heat_on = false;
+    r.events |= STEP_EV_HEAT_PAUSED;
+  }
+
+  // Exit conditions
+  bool min_satisfied = (now >= c->must_not_end_before);
+  bool max_reached = (c->must_end_by > 0 && now >= c->must_end_by);
+
+  // an explicit at_max ends the step even if min is not yet met
+  if (max_reached && (c->at_max > 0)) {
+    r.end = STEP_END_MAX_AT_REACHED;
+  } else if (max_reached && min_satisfied) {
+    r.end = STEP_END_MIN_AND_MAX_REACHED;
+  }
+  return r;
+}
+
+const char *step_end_name(step_end_t e) {
+  switch (e) {
+  case STEP_END_SKIPPED:
+    return "skipped";
+  case STEP_END_MAX_AT_REACHED:
+    return "max_at_reached";
+  case STEP_END_MIN_AND_MAX_REACHED:
+    return "min_and_max_reached";
+  default:
+    return "running";
+  }
+}
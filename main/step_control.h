@@ -0,0 +1,93 @@
+// step_control.h — per-line decision logic of run_program(), free of RTOS and
+// GPIO calls so the host replay tool (tools/replay) runs the exact same code.
+// run_program() owns the clock, sleeping and actuators; step_ctl_tick() only
+// decides.
+#ifndef STEP_CONTROL_H
+#define STEP_CONTROL_H
+
+#include "program_defs.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STEP_CTL_TICK_MS 5000 // run_program() polls the controller this often
+#define STEP_CTL_HYSTERESIS_F 3 // heater resumes at max_temp - 3°F
+
+// Why a line ended (STEP_END_NONE while it is still running)
+typedef enum {
+  STEP_END_NONE = 0,
+  STEP_END_SKIPPED,             // SkipStep requested
+  STEP_END_MAX_AT_REACHED,      // explicit max_time_at_temp elapsed
+  STEP_END_MIN_AND_MAX_REACHED, // min window satisfied and max window hit
+} step_end_t;
+
+// Edge-triggered events raised by one tick (bit flags)
+enum {
+  STEP_EV_MIN_TEMP_REACHED = 1u << 0, // first time CurrentTemp >= min_temp
+  STEP_EV_AT_TEMP_STARTED = 1u << 1,  // windows clamped to at-temp spec
+  STEP_EV_AT_MIN_PAST_MAX = 1u << 2,  // min_time_at_temp overruns max_time
+  STEP_EV_OVER_MAX = 1u << 3,         // temp exceeded max_temp (once per band)
+  STEP_EV_OVER_MAX_RESET = 1u << 4,   // cooled back below the band
+  STEP_EV_HEAT_RESUMED = 1u << 5,     // heater must switch on
+  STEP_EV_HEAT_PAUSED = 1u << 6,      // heater must switch off
+};
+
+typedef struct {
+  const ProgramLineStruct *line;
+
+  // Base/at-temp constraints (seconds)
+  int base_min;
+  int base_max;
+  int at_min;
+  int at_max;
+
+  // Thermostat
+  bool has_temp_targets;
+  bool heat_requested;
+  bool heat_on;
+  bool heat_reached;
+  int max_t;
+  int band_low;
+  bool over_max_warned;
+
+  // Windows
+  time_t line_start;
+  time_t must_not_end_before;
+  time_t must_end_by;
+
+  // At-temp tracking
+  bool at_temp_started;
+  time_t at_temp_t0;
+  int original_remaining_at_hit;
+  int adjusted_remaining;
+  time_t at_temp_elapsed;
+} step_ctl_t;
+
+typedef struct {
+  uint32_t events; // STEP_EV_* raised by this tick
+  step_end_t end;  // != STEP_END_NONE → leave the line
+} step_ctl_result_t;
+
+/** Reset controller state for a new program line starting at now. */
+void step_ctl_begin(step_ctl_t *c, const ProgramLineStruct *line, time_t now);
+
+/**
+ * One decision pass: skip check, min-temp/at-temp tracking, over-max guard,
+ * hysteresis thermostat and exit conditions. c->heat_on holds the desired
+ * heater state afterwards.
+ */
+step_ctl_result_t step_ctl_tick(step_ctl_t *c, int temp_f, time_t now,
+                                bool skip_requested);
+
+/** Short label for logs and captures. */
+const char *step_end_name(step_end_t e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STEP_CONTROL_H
@@ -0,0 +1,167 @@
+// temp_history.c — multi-resolution min/max/mean temperature history
+// - Static storage only (~16.5 KB); no allocation after boot
+// - O(1) per sample: a sample touches the open tier-0 bucket; closing a
+//   bucket folds it into the next tier's open bucket
+// - Readers copy under a short spinlock section in caller-sized batches
+
+#include "temp_history.h"
+#include "dishwasher_programs.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t bucket_ms;
+  uint16_t capacity;
+  temp_history_bucket_t *buf;
+
+  bool started;
+  int64_t origin_ms;  // start of seq 0 (uptime ms; never wraps)
+  uint32_t next_seq;  // seq of the open bucket
+
+  // open bucket accumulator (tenths of °F)
+  int32_t acc_min;
+  int32_t acc_max;
+  int64_t acc_sum;
+  uint32_t acc_n;
+} tier_t;
+
+static temp_history_bucket_t s_buf0[600];
+static temp_history_bucket_t s_buf1[720];
+static temp_history_bucket_t s_buf2[1440];
+
+static tier_t s_tiers[TEMP_HISTORY_TIERS] = {
+    {.bucket_ms = 1000, .capacity = 600, .buf = s_buf0},
+    {.bucket_ms = 10000, .capacity = 720, .buf = s_buf1},
+    {.bucket_ms = 60000, .capacity = 1440, .buf = s_buf2},
+};
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline int64_t now_ms(void) {
+  return esp_timer_get_time() / 1000;
+}
+
+static inline int16_t clamp_df(int64_t v) {
+  if (v <= INT16_MIN)
+    return INT16_MIN + 1; // keep TEMP_HISTORY_EMPTY unambiguous
+  if (v > INT16_MAX)
+    return INT16_MAX;
+  return (int16_t)v;
+}
+
+static void tier_add(int k, int64_t t_ms, int32_t mn, int32_t mx,
+                     int64_t sum, uint32_t n);
+
+// Close the open bucket of tier k, store it and fold it into tier k+1
+static void tier_close(int k) {
+  tier_t *T = &s_tiers[k];
+  temp_history_bucket_t b = {TEMP_HISTORY_EMPTY, TEMP_HISTORY_EMPTY,
+                             TEMP_HISTORY_EMPTY};
+  if (T->acc_n) {
+    b.min_df = clamp_df(T->acc_min);
+    b.max_df = clamp_df(T->acc_max);
+    b.mean_df = clamp_df(T->acc_sum / (int64_t)T->acc_n);
+  }
+  T->buf[T->next_seq % T->capacity] = b;
+  const int64_t start_ms =
+      T->origin_ms + (int64_t)T->next_seq * (int64_t)T->bucket_ms;
+  T->next_seq++;
+
+  if (T->acc_n && k + 1 < TEMP_HISTORY_TIERS) {
+    tier_add(k + 1, start_ms, T->acc_min, T->acc_max, T->acc_sum, T->acc_n);
+  }
+  T->acc_n = 0;
+  T->acc_sum = 0;
+}
+
+// Add an aggregate (min/max/sum over n samples) that belongs at time t_ms
+static void tier_add(int k, int64_t t_ms, int32_t mn, int32_t mx,
+                     int64_t sum, uint32_t n) {
+  tier_t *T = &s_tiers[k];
+  if (!T->started) {
+    T->started = true;
+    T->origin_ms = t_ms - (t_ms % T->bucket_ms);
+    T->next_seq = 0;
+  }
+  if (t_ms < T->origin_ms) {
+    return; // cannot happen with a monotonic clock; never corrupt the ring
+  }
+  const uint32_t seq = (uint32_t)((t_ms - T->origin_ms) / T->bucket_ms);
+  if (seq > T->next_seq) {
+    // Long gap: anything older than capacity would be overwritten anyway
+    if (seq - T->next_seq > T->capacity) {
+      tier_close(k);
+      if (seq - T->next_seq > T->capacity) {
+        T->next_seq = seq - T->capacity;
+      }
+    }
+    while (T->next_seq < seq) {
+      tier_close(k);
+    }
+  }
+  if (T->acc_n == 0) {
+    T->acc_min = mn;
+    T->acc_max = mx;
+  } else {
+    if (mn < T->acc_min)
+      T->acc_min = mn;
+    if (mx > T->acc_max)
+      T->acc_max = mx;
+  }
+  T->acc_sum += sum;
+  T->acc_n += n;
+}
+
+void temp_history_add(float temp_f) {
+  if (isnan(temp_f)) {
+    return;
+  }
+  const int32_t df = (int32_t)lroundf(temp_f * 10.0f);
+  const int64_t t = now_ms();
+  portENTER_CRITICAL(&s_mux);
+  tier_add(0, t, df, df, df, 1);
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool temp_history_info(int tier, temp_history_info_t *out) {
+  if (tier < 0 || tier >= TEMP_HISTORY_TIERS || !out) {
+    return false;
+  }
+  portENTER_CRITICAL(&s_mux);
+  const tier_t *T = &s_tiers[tier];
+  out->bucket_ms = T->bucket_ms;
+  out->capacity = T->capacity;
+  out->next_seq = T->next_seq;
+  out->first_seq =
+      (T->next_seq > T->capacity) ? (T->next_seq - T->capacity) : 0;
+  out->origin_ms = T->origin_ms;
+  portEXIT_CRITICAL(&s_mux);
+  out->now_ms = now_ms();
+  return true;
+}
+
+size_t temp_history_read(int tier, uint32_t seq, temp_history_bucket_t *out,
+                         size_t max, uint32_t *start_seq) {
+  if (tier < 0 || tier >= TEMP_HISTORY_TIERS || !out || max == 0) {
+    return 0;
+  }
+  size_t n = 0;
+  portENTER_CRITICAL(&s_mux);
+  const tier_t *T = &s_tiers[tier];
+  const uint32_t first =
+      (T->next_seq > T->capacity) ? (T->next_seq - T->capacity) : 0;
+  if (seq < first) {
+    seq = first;
+  }
+  if (start_seq) {
+    *start_seq = seq;
+  }
+  while (n < max && seq < T->next_seq) {
+    out[n++] = T->buf[seq % T->capacity];
+    seq++;
+  }
+  portEXIT_CRITICAL(&s_mux);
+  return n;
+}
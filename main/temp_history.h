@@ -0,0 +1,57 @@
+// temp_history.h — fixed-memory multi-resolution temperature history
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Three tiers, each a ring of min/max/mean buckets (tenths of °F):
+ *   tier 0:  1 s buckets × 600  → last 10 min
+ *   tier 1: 10 s buckets × 720  → last 2 h
+ *   tier 2: 60 s buckets × 1440 → last 24 h
+ * Tier 0 is fed by the ADC sampler; each closed bucket is folded into the
+ * next tier, so no tier ever rescans raw samples. Buckets are addressed by a
+ * monotonically increasing sequence number: start of bucket seq is
+ * origin_ms + seq * bucket_ms (uptime ms). Intervals without samples are
+ * stored as TEMP_HISTORY_EMPTY buckets so the timeline stays linear.
+ */
+#define TEMP_HISTORY_TIERS 3
+#define TEMP_HISTORY_EMPTY INT16_MIN
+
+typedef struct {
+  int16_t min_df;  // tenths of °F
+  int16_t max_df;
+  int16_t mean_df;
+} temp_history_bucket_t;
+
+typedef struct {
+  uint32_t bucket_ms; // bucket width
+  uint16_t capacity;  // buckets retained
+  uint32_t first_seq; // oldest retained bucket
+  uint32_t next_seq;  // one past the newest closed bucket
+  int64_t origin_ms;  // uptime ms at the start of seq 0
+  int64_t now_ms;     // uptime ms when the info was taken
+} temp_history_info_t;
+
+/** Add one sample (°F) at the current uptime. Called by the ADC sampler. */
+void temp_history_add(float temp_f);
+
+/** Describe a tier. Returns false for an invalid tier index. */
+bool temp_history_info(int tier, temp_history_info_t *out);
+
+/**
+ * Copy up to max closed buckets of a tier, starting at sequence seq (clamped
+ * to the oldest retained bucket). *start_seq receives the sequence of out[0].
+ * Returns the number of buckets copied.
+ */
+size_t temp_history_read(int tier, uint32_t seq, temp_history_bucket_t *out,
+                         size_t max, uint32_t *start_seq);
+
+#ifdef __cplusplus
+}
+#endif
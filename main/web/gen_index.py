@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Build the gzipped web UI embedded by main/CMakeLists.txt.
+
+Fills @ACTIONS@ in the template with one button row per GROUP of
+ACTIONS_TABLE (http_server.h, the same table ROUTES is built from) and
+@VERSION@ with the firmware version, then writes a reproducible gzip
+(no name, mtime 0) so an unchanged page yields an unchanged image.
+"""
+
+import argparse
+import gzip
+import html
+import re
+
+XX_RE = re.compile(r"XX\(\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*\)")
+
+
+def action_rows(header_text):
+    rows = []
+    for group, name, _token in XX_RE.findall(header_text):
+        if not rows or rows[-1][0] != group:
+            rows.append((group, []))
+        rows[-1][1].append(name)
+    out = []
+    for group, names in rows:
+        g = html.escape(group)
+        buttons = "".join(
+            '<button class="btn" data-uri="/action/{0}/{1}">{1}</button>'.format(
+                g, html.escape(n))
+            for n in names)
+        out.append('<div class="row"><span class="group">{0}:</span>{1}</div>'
+                   .format(g, buttons))
+    return "\n".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--template", required=True)
+    ap.add_argument("--actions", required=True, help="http_server.h")
+    ap.add_argument("--version", default="dev")
+    ap.add_argument("--out", required=True)
+    args = ap.parse_args()
+
+    with open(args.template, encoding="utf-8") as f:
+        page = f.read()
+    with open(args.actions, encoding="utf-8") as f:
+        rows = action_rows(f.read())
+    if not rows:
+        raise SystemExit("gen_index: no ACTIONS_TABLE entries in " + args.actions)
+
+    page = page.replace("@ACTIONS@", rows)
+    page = page.replace("@VERSION@", html.escape(args.version or "dev"))
+    # Indentation and blank lines only cost bytes
+    page = "\n".join(l.strip() for l in page.splitlines() if l.strip()) + "\n"
+
+    with open(args.out, "wb") as raw:
+        with gzip.GzipFile(filename="", mode="wb", compresslevel=9,
+                           fileobj=raw, mtime=0) as gz:
+            gz.write(page.encode("utf-8"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,161 @@
+// ring_bench.c — host microbenchmark for main/ring_buffer.h
+//
+// 1. Single-thread push cost of RING_BUFFER_DEFINE with a power-of-two
+//    capacity (mask wrap) vs a non-power-of-two one (modulo wrap).
+// 2. Cross-thread throughput of RING_BUFFER_SPSC_DEFINE vs a locked bounded
+//    queue that copies items under a mutex and blocks on condition variables,
+//    which is what xQueueSend/xQueueReceive do under the hood. The FreeRTOS
+//    kernel is not available on the host, so this is a model of the queue,
+//    not the queue itself; on target the SPSC ring also skips the scheduler
+//    calls a queue makes on every send/receive.
+//
+// Build (from the repo root):
+//   cc -O2 -Wall -pthread -Imain -o ring_bench tools/bench/ring_bench.c
+// Run:
+//   ./ring_bench [items]
+
+#include "ring_buffer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+RING_BUFFER_DEFINE(pow2_rb, int, 64);
+RING_BUFFER_DEFINE(odd_rb, int, 60);
+RING_BUFFER_SPSC_DEFINE(spsc_q, int, 64);
+
+#define LOCKED_CAP 64
+
+typedef struct {
+  int buf[LOCKED_CAP];
+  size_t head, tail, count;
+  pthread_mutex_t mu;
+  pthread_cond_t not_empty, not_full;
+} locked_q_t;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long g_items;
+static spsc_q g_spsc;
+static locked_q_t g_locked = {.mu = PTHREAD_MUTEX_INITIALIZER,
+                              .not_empty = PTHREAD_COND_INITIALIZER,
+                              .not_full = PTHREAD_COND_INITIALIZER};
+
+// ---------------- single thread ----------------
+static volatile long long g_sink;
+
+static void bench_wrap(void) {
+  static pow2_rb a;
+  static odd_rb b;
+  pow2_rb_clear(&a);
+  odd_rb_clear(&b);
+
+  double t0 = now_s();
+  for (long i = 0; i < g_items; i++) {
+    pow2_rb_push(&a, (int)i);
+  }
+  double t1 = now_s();
+  for (long i = 0; i < g_items; i++) {
+    odd_rb_push(&b, (int)i);
+  }
+  double t2 = now_s();
+  g_sink = pow2_rb_sum(&a) + odd_rb_sum(&b);
+
+  printf("push  mask (CAP 64): %6.2f ns/item\n", (t1 - t0) * 1e9 / g_items);
+  printf("push  mod  (CAP 60): %6.2f ns/item\n", (t2 - t1) * 1e9 / g_items);
+}
+
+// ---------------- SPSC ----------------
+static void *spsc_producer(void *arg) {
+  (void)arg;
+  for (long i = 0; i < g_items; i++) {
+    while (!spsc_q_push(&g_spsc, (int)i)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static void *spsc_consumer(void *arg) {
+  long long *sum = arg;
+  int v;
+  for (long i = 0; i < g_items;) {
+    if (spsc_q_pop(&g_spsc, &v)) {
+      *sum += v;
+      i++;
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+// ---------------- locked queue ----------------
+static void *locked_producer(void *arg) {
+  (void)arg;
+  locked_q_t *q = &g_locked;
+  for (long i = 0; i < g_items; i++) {
+    pthread_mutex_lock(&q->mu);
+    while (q->count == LOCKED_CAP) {
+      pthread_cond_wait(&q->not_full, &q->mu);
+    }
+    q->buf[q->head] = (int)i;
+    q->head = (q->head + 1) % LOCKED_CAP;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mu);
+  }
+  return NULL;
+}
+
+static void *locked_consumer(void *arg) {
+  long long *sum = arg;
+  locked_q_t *q = &g_locked;
+  for (long i = 0; i < g_items; i++) {
+    pthread_mutex_lock(&q->mu);
+    while (q->count == 0) {
+      pthread_cond_wait(&q->not_empty, &q->mu);
+    }
+    *sum += q->buf[q->tail];
+    q->tail = (q->tail + 1) % LOCKED_CAP;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mu);
+  }
+  return NULL;
+}
+
+static void run_pair(const char *label, void *(*prod)(void *),
+                     void *(*cons)(void *)) {
+  pthread_t p, c;
+  long long sum = 0;
+  double t0 = now_s();
+  pthread_create(&c, NULL, cons, &sum);
+  pthread_create(&p, NULL, prod, NULL);
+  pthread_join(p, NULL);
+  pthread_join(c, NULL);
+  double dt = now_s() - t0;
+
+  const long long want = (long long)g_items * (g_items - 1) / 2;
+  printf("%-20s %6.2f Mitems/s%s\n", label, g_items / dt / 1e6,
+         sum == want ? "" : "  (CHECKSUM MISMATCH)");
+}
+
+int main(int argc, char **argv) {
+  g_items = (argc > 1) ? atol(argv[1]) : 10000000L;
+  if (g_items <= 0) {
+    fprintf(stderr, "usage: %s [items]\n", argv[0]);
+    return 2;
+  }
+
+  bench_wrap();
+  run_pair("spsc  ring:", spsc_producer, spsc_consumer);
+  run_pair("locked queue:", locked_producer, locked_consumer);
+  return 0;
+}
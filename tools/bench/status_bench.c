@@ -0,0 +1,203 @@
+// status_bench.c — host benchmark for the /status body (main/status_json.c)
+//
+// Compares what one GET /status costs on the wire side:
+// 1. The previous handler: one httpd_resp_sendstr_chunk() per key, quote,
+//    colon and value. esp_http_server writes every chunk as three sends
+//    (size line, data, CRLF), modelled here as three write()s.
+// 2. status_json_render() into one buffer, sent with a single write(), which
+//    is what httpd_resp_send() does for a small body.
+// Both write into a socketpair drained by a second thread, so every send is
+// a real syscall. lwIP on the device costs more per send than Linux does, so
+// the ratio is a lower bound for the target.
+//
+// Build (from the repo root):
+//   cc -O2 -Wall -pthread -Imain -o status_bench
+//      tools/bench/status_bench.c main/status_json.c
+// Run:
+//   ./status_bench [requests]
+
+#include "status_json.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static long g_sends;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void *drain(void *arg) {
+  const int fd = *(int *)arg;
+  char buf[4096];
+  while (read(fd, buf, sizeof(buf)) > 0) {
+  }
+  return NULL;
+}
+
+static void send_all(int fd, const char *p, size_t n) {
+  g_sends++;
+  while (n > 0) {
+    const ssize_t w = write(fd, p, n);
+    if (w <= 0) {
+      perror("write");
+      exit(1);
+    }
+    p += w;
+    n -= (size_t)w;
+  }
+}
+
+// httpd_resp_sendstr_chunk(): "<hex len>\r\n", data, "\r\n"
+static void chunk(int fd, const char *s) {
+  char hdr[16];
+  const size_t n = strlen(s);
+  const int h = snprintf(hdr, sizeof(hdr), "%zx\r\n", n);
+  send_all(fd, hdr, (size_t)h);
+  send_all(fd, s, n);
+  send_all(fd, "\r\n", 2);
+}
+
+static void old_prop(int fd, bool *first, const char *key, const char *val,
+                     bool quoted) {
+  chunk(fd, *first ? "" : ",");
+  *first = false;
+  chunk(fd, "\"");
+  chunk(fd, key);
+  chunk(fd, quoted ? "\":\"" : "\":");
+  chunk(fd, val);
+  if (quoted) {
+    chunk(fd, "\"");
+  }
+}
+
+// The removed handle_status(): same fields it used to send
+static void old_status(int fd, const status_view_t *v) {
+  char text[64], num[24];
+  bool first = true;
+  chunk(fd, "{");
+  snprintf(text, sizeof(text), "%s->%s->%s Cycle %ld of %ld, step %ld of %ld",
+           v->program, v->cycle, v->step, (long)v->cycle_index,
+           (long)v->cycles_total, (long)v->step_index, (long)v->steps_total);
+  old_prop(fd, &first, "Program", text, true);
+  snprintf(num, sizeof(num), "%d", v->current_temp);
+  old_prop(fd, &first, "CurrentTemp", num, false);
+  snprintf(num, sizeof(num), "%.2f", (double)v->rate_f_per_min);
+  old_prop(fd, &first, "heat_rate_f_per_min", num, false);
+  snprintf(num, sizeof(num), "%d", (int)v->secs_to_min_temp);
+  old_prop(fd, &first, "secs_to_min_temp", num, false);
+  snprintf(num, sizeof(num), "%d", (int)v->secs_to_max_temp);
+  old_prop(fd, &first, "secs_to_max_temp", num, false);
+  snprintf(num, sizeof(num), "%.2f", (double)v->overshoot_f);
+  old_prop(fd, &first, "overshoot_f", num, false);
+  snprintf(num, sizeof(num), "%d", (int)v->http_p50_us);
+  old_prop(fd, &first, "http_p50_us", num, false);
+  snprintf(num, sizeof(num), "%d", (int)v->http_p99_us);
+  old_prop(fd, &first, "http_p99_us", num, false);
+  snprintf(num, sizeof(num), "%d", (int)v->http_max_us);
+  old_prop(fd, &first, "http_max_us", num, false);
+  old_prop(fd, &first, "since_start_mmss",
+           status_ms_to_mmss(v->elapsed_ms, text), true);
+  old_prop(fd, &first, "remaining_mmss",
+           status_ms_to_mmss(v->remaining_ms, text), true);
+  old_prop(fd, &first, "eta_finish_mmss",
+           status_ms_to_mmss(v->remaining_ms, text), true);
+  status_format_est_time_ms(v->start_epoch_ms, text);
+  old_prop(fd, &first, "start_time_est", text, true);
+  status_format_est_time_ms(v->end_epoch_ms, text);
+  old_prop(fd, &first, "end_time_est", text, true);
+  old_prop(fd, &first, "soap_has_dispensed",
+           v->soap_dispensed ? "true" : "false", false);
+  chunk(fd, "}\n");
+  send_all(fd, "0\r\n\r\n", 5); // terminating chunk
+}
+
+static size_t new_status(int fd, const status_view_t *v) {
+  static char body[STATUS_JSON_MAX];
+  const size_t len = status_json_render(v, body, sizeof(body));
+  if (len == 0) {
+    fprintf(stderr, "render overflow\n");
+    exit(1);
+  }
+  send_all(fd, body, len);
+  return len;
+}
+
+static const status_view_t SAMPLE = {
+    .program = "Normal",
+    .cycle = "Wash",
+    .step = "heat",
+    .cycle_index = 2,
+    .cycles_total = 5,
+    .step_index = 7,
+    .steps_total = 18,
+    .last_transition = 1760000000,
+    .current_temp = 131,
+    .device_mask = (1ULL << 32) | (1ULL << 33),
+    .devices = "HS",
+    .firmware_status = "Up To Date",
+    .ip = "192.168.100.123",
+    .heat_requested = true,
+    .elapsed_ms = 1234567,
+    .remaining_ms = 2345678,
+    .start_epoch_ms = 1760000000000LL,
+    .end_epoch_ms = 1760003600000LL,
+    .trend_valid = true,
+    .rate_f_per_min = 1.75f,
+    .secs_to_min_temp = 120,
+    .secs_to_max_temp = 300,
+    .overshoot_f = 0.5f,
+    .http_count = 100,
+    .http_p50_us = 850,
+    .http_p99_us = 4200,
+    .http_max_us = 9100,
+};
+
+int main(int argc, char **argv) {
+  const long n = (argc > 1) ? atol(argv[1]) : 20000L;
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [requests]\n", argv[0]);
+    return 2;
+  }
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+    perror("socketpair");
+    return 2;
+  }
+  pthread_t th;
+  pthread_create(&th, NULL, drain, &sv[1]);
+
+  g_sends = 0;
+  double t0 = now_s();
+  for (long i = 0; i < n; i++) {
+    old_status(sv[0], &SAMPLE);
+  }
+  const double old_us = (now_s() - t0) * 1e6 / n;
+  const double old_sends = (double)g_sends / n;
+
+  g_sends = 0;
+  size_t len = 0;
+  t0 = now_s();
+  for (long i = 0; i < n; i++) {
+    len = new_status(sv[0], &SAMPLE);
+  }
+  const double new_us = (now_s() - t0) * 1e6 / n;
+  const double new_sends = (double)g_sends / n;
+
+  close(sv[0]);
+  pthread_join(th, NULL);
+
+  printf("chunked per property: %7.2f us/request, %5.1f sends\n", old_us,
+         old_sends);
+  printf("single buffer:        %7.2f us/request, %5.1f sends (%zu bytes, "
+         "more fields)\n",
+         new_us, new_sends, len);
+  return 0;
+}
@@ -0,0 +1,223 @@
+// status_cache_bench.c — host model of /status throughput with and without
+// the shared body cache (main/status_cache.c)
+//
+// One "httpd" thread answers back-to-back requests for a fixed time, the
+// way the single httpd task does on the device. Each answer is one write()
+// into a socketpair drained by another thread.
+// 1. Render per request: fill a view (string copies, duration math) and
+//    status_json_render() it. This is what every hit cost before the cache.
+// 2. Cached: copy the front buffer out under a mutex. A build happens when
+//    the version moves or the build is older than the TTL. A producer
+//    thread bumps the version at --hz (10 Hz is a temperature that changes
+//    every sample) and builds at once, as the status watcher does.
+// The printed requests/s compare the two paths on this CPU. The device is
+// slower on both, but the share of time spent rendering is similar.
+//
+// Build (from the repo root):
+//   cc -O2 -Wall -pthread -Imain -o status_cache_bench
+//      tools/bench/status_cache_bench.c main/status_json.c
+// Run:
+//   ./status_cache_bench [seconds] [hz]
+
+#include "status_json.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TTL_MS 500 // STATUS_CACHE_TTL_MS
+
+typedef struct {
+  uint32_t version;
+  double built_s;
+  size_t len;
+  char json[STATUS_JSON_MAX];
+} build_t;
+
+static build_t g_builds[2];
+static int g_front = -1;
+static pthread_mutex_t g_render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_swap_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint g_version = 1;
+static atomic_bool g_stop;
+static long g_builds_made;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void *drain(void *arg) {
+  const int fd = *(int *)arg;
+  char buf[8192];
+  while (read(fd, buf, sizeof(buf)) > 0) {
+  }
+  return NULL;
+}
+
+static void send_all(int fd, const char *p, size_t n) {
+  while (n > 0) {
+    const ssize_t w = write(fd, p, n);
+    if (w <= 0) {
+      perror("write");
+      exit(1);
+    }
+    p += w;
+    n -= (size_t)w;
+  }
+}
+
+static const status_view_t SAMPLE = {
+    .program = "Normal",
+    .cycle = "Wash",
+    .step = "heat",
+    .cycle_index = 2,
+    .cycles_total = 5,
+    .step_index = 7,
+    .steps_total = 18,
+    .last_transition = 1760000000,
+    .current_temp = 131,
+    .device_mask = (1ULL << 32) | (1ULL << 33),
+    .devices = "HS",
+    .firmware_status = "Up To Date",
+    .ip = "192.168.100.123",
+    .heat_requested = true,
+    .start_epoch_ms = 1760000000000LL,
+    .end_epoch_ms = 1760003600000LL,
+    .trend_valid = true,
+    .rate_f_per_min = 1.75f,
+    .secs_to_min_temp = 120,
+    .secs_to_max_temp = 300,
+    .overshoot_f = 0.5f,
+    .http_count = 100,
+    .http_p50_us = 850,
+    .http_p99_us = 4200,
+    .http_max_us = 9100,
+};
+
+// Stands in for http_server_fill_status()
+static void fill_view(status_view_t *v) {
+  memset(v, 0, sizeof(*v));
+  *v = SAMPLE;
+  v->version = atomic_load(&g_version);
+  const int64_t ms = (int64_t)(now_s() * 1000.0);
+  v->elapsed_ms = ms % 3600000;
+  v->remaining_ms = 3600000 - v->elapsed_ms;
+}
+
+static size_t render(char *out, size_t cap) {
+  status_view_t v;
+  fill_view(&v);
+  const size_t len = status_json_render(&v, out, cap);
+  if (len == 0) {
+    fprintf(stderr, "render overflow\n");
+    exit(1);
+  }
+  return len;
+}
+
+static bool is_fresh(const build_t *b, double now) {
+  return b->version == atomic_load(&g_version) &&
+         now - b->built_s < TTL_MS / 1000.0;
+}
+
+// Same steps as status_cache.c build_locked()
+static void build(void) {
+  pthread_mutex_lock(&g_render_lock);
+  if (g_front < 0 || !is_fresh(&g_builds[g_front], now_s())) {
+    const int back = (g_front == 0) ? 1 : 0;
+    build_t *b = &g_builds[back];
+    b->version = atomic_load(&g_version);
+    b->built_s = now_s();
+    b->len = render(b->json, sizeof(b->json));
+    pthread_mutex_lock(&g_swap_lock);
+    g_front = back;
+    g_builds_made++;
+    pthread_mutex_unlock(&g_swap_lock);
+  }
+  pthread_mutex_unlock(&g_render_lock);
+}
+
+static size_t cached_copy(char *out) {
+  for (int pass = 0; pass < 2; pass++) {
+    pthread_mutex_lock(&g_swap_lock);
+    if (g_front >= 0 && (pass == 1 || is_fresh(&g_builds[g_front], now_s()))) {
+      const build_t *b = &g_builds[g_front];
+      memcpy(out, b->json, b->len);
+      const size_t len = b->len;
+      pthread_mutex_unlock(&g_swap_lock);
+      return len;
+    }
+    pthread_mutex_unlock(&g_swap_lock);
+    build();
+  }
+  return 0;
+}
+
+static void *producer(void *arg) {
+  const double period = 1.0 / *(double *)arg;
+  while (!atomic_load(&g_stop)) {
+    usleep((useconds_t)(period * 1e6));
+    atomic_fetch_add(&g_version, 1);
+    build();
+  }
+  return NULL;
+}
+
+static double run(int fd, double seconds, bool cached, long *count) {
+  static char body[STATUS_JSON_MAX];
+  long n = 0;
+  const double t0 = now_s();
+  double t = t0;
+  while (t - t0 < seconds) {
+    const size_t len = cached ? cached_copy(body) : render(body, sizeof(body));
+    send_all(fd, body, len);
+    n++;
+    if ((n & 255) == 0) {
+      t = now_s();
+    }
+  }
+  *count = n;
+  return (double)n / (now_s() - t0);
+}
+
+int main(int argc, char **argv) {
+  const double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+  double hz = (argc > 2) ? atof(argv[2]) : 10.0;
+  if (seconds <= 0 || hz <= 0) {
+    fprintf(stderr, "usage: %s [seconds] [hz]\n", argv[0]);
+    return 2;
+  }
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+    perror("socketpair");
+    return 2;
+  }
+  pthread_t drainer;
+  pthread_create(&drainer, NULL, drain, &sv[1]);
+
+  long n_old, n_new;
+  const double old_rps = run(sv[0], seconds, false, &n_old);
+
+  pthread_t prod;
+  pthread_create(&prod, NULL, producer, &hz);
+  const double new_rps = run(sv[0], seconds, true, &n_new);
+  atomic_store(&g_stop, true);
+  pthread_join(prod, NULL);
+
+  close(sv[0]);
+  pthread_join(drainer, NULL);
+
+  printf("render per request: %10.0f requests/s (%ld in %.1f s)\n", old_rps,
+         n_old, seconds);
+  printf("shared cache:       %10.0f requests/s (%ld in %.1f s, %ld builds "
+         "at %.0f Hz changes)\n",
+         new_rps, n_new, seconds, g_builds_made, hz);
+  return 0;
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Sustained-load test for GET /status (or any GET path) on the device.
+
+Each client thread keeps one keep-alive connection and sends requests back
+to back for --seconds. The script prints requests/s, errors and latency
+percentiles over all clients. Run it against the firmware before and after
+a change, with the same --clients, to compare.
+
+    tools/bench/status_load.py 192.168.1.50 --clients 4 --seconds 30
+    tools/bench/status_load.py 192.168.1.50 --path /status.cbor
+
+Keep --clients under the device's socket limit. Clients that cannot
+connect are counted as errors.
+
+The firmware limits each client address to a burst of 20 /status reads
+refilled at 10/s (main/http_conn.c), so from one host this measures 429s
+within a second. Flash a build made with
+`idf.py -DHTTP_CONN_RATE_LIMIT=0 build` for before/after runs.
+"""
+
+import argparse
+import http.client
+import threading
+import time
+
+
+def client(host, port, path, deadline, out):
+    lat = []
+    errors = 0
+    conn = None
+    while time.monotonic() < deadline:
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(host, port, timeout=5)
+            t0 = time.monotonic()
+            conn.request("GET", path)
+            resp = conn.getresponse()
+            resp.read()
+            # Only 200s count: 429 (per-client rate limit) and 5xx
+            # answers are quick and would flatter the numbers
+            if resp.status == 200:
+                lat.append(time.monotonic() - t0)
+            else:
+                errors += 1
+            if resp.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            if conn is not None:
+                conn.close()
+            conn = None
+            time.sleep(0.05)
+    if conn is not None:
+        conn.close()
+    out.append((lat, errors))
+
+
+def pct(sorted_values, q):
+    if not sorted_values:
+        return float("nan")
+    i = min(len(sorted_values) - 1, int(q * len(sorted_values)))
+    return sorted_values[i]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--path", default="/status")
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--seconds", type=float, default=20.0)
+    args = ap.parse_args()
+
+    results = []
+    deadline = time.monotonic() + args.seconds
+    threads = [
+        threading.Thread(target=client,
+                         args=(args.host, args.port, args.path, deadline,
+                               results))
+        for _ in range(args.clients)
+    ]
+    t0 = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - t0
+
+    lat = sorted(x for r in results for x in r[0])
+    errors = sum(r[1] for r in results)
+    print("{} x {} for {:.1f} s: {} ok, {} errors, {:.1f} requests/s".format(
+        args.clients, args.path, elapsed, len(lat), errors,
+        len(lat) / elapsed))
+    print("latency ms: p50 {:.1f}  p90 {:.1f}  p99 {:.1f}  max {:.1f}".format(
+        pct(lat, 0.50) * 1e3, pct(lat, 0.90) * 1e3, pct(lat, 0.99) * 1e3,
+        (lat[-1] if lat else float("nan")) * 1e3))
+
+
+if __name__ == "__main__":
+    main()
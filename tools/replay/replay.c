@@ -0,0 +1,385 @@
+// replay.c — host replay of a captured wash run (see main/run_capture.h)
+//
+// Feeds the recorded ADC samples through the firmware's mV → °F conversion
+// (analog_convert.h) and run_program()'s per-line decision logic
+// (step_control.c) as fast as the host allows, waking where the firmware
+// would (tick, dispatched action, or a temperature change on a thermostat
+// line; see wait_step_event()), then diffs the resulting heater toggles and
+// step ends against the decisions recorded on the device.
+//
+// Build (from the repo root):
+//   cc -O2 -Wall -Imain -o replay tools/replay/replay.c main/step_control.c
+//      main/program_defs.c
+// Capture: collect the UDP log mirror (logger.c) during a run, e.g.
+//   nc -ul 5514 > run.log
+// Run:
+//   ./replay run.log [run_index] [tolerance_s]
+// Exit status: 0 = no divergence, 1 = divergences, 2 = bad input.
+
+#include "analog_convert.h"
+#include "http_server.h"
+#include "program_defs.h"
+#include "step_control.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_TOLERANCE_S (STEP_CTL_TICK_MS / 1000)
+
+typedef struct {
+  long long t_ms;
+  int raw;
+  int mv;
+} sample_t;
+
+typedef struct {
+  long long t_ms;
+  int action;
+} action_t;
+
+typedef enum { DEC_BEGIN, DEC_HEAT_ON, DEC_HEAT_OFF, DEC_END } dec_kind_t;
+
+typedef struct {
+  long long epoch;
+  int step;
+  dec_kind_t kind;
+  char arg[24];
+} decision_t;
+
+#define VEC(T)                                                                 \
+  struct {                                                                     \
+    T *v;                                                                      \
+    size_t n, cap;                                                             \
+  }
+#define VEC_PUSH(vec, item)                                                    \
+  do {                                                                         \
+    if ((vec).n == (vec).cap) {                                                \
+      (vec).cap = (vec).cap ? (vec).cap * 2 : 256;                             \
+      (vec).v = realloc((vec).v, (vec).cap * sizeof(*(vec).v));                \
+      if (!(vec).v) {                                                          \
+        perror("realloc");                                                     \
+        exit(2);                                                               \
+      }                                                                        \
+    }                                                                          \
+    (vec).v[(vec).n++] = (item);                                               \
+  } while (0)
+
+typedef VEC(sample_t) sample_vec_t;
+typedef VEC(action_t) action_vec_t;
+typedef VEC(decision_t) decision_vec_t;
+
+typedef struct {
+  char program[16];
+  long long t0_ms;
+  long long epoch0;
+  long long end_ms;
+  sample_vec_t samples;
+  action_vec_t actions;
+  decision_vec_t decisions;
+} capture_t;
+
+static const char *KIND_NAMES[] = {"BEGIN", "HEAT_ON", "HEAT_OFF", "END"};
+
+static bool parse_kind(const char *s, dec_kind_t *out) {
+  for (int k = 0; k <= DEC_END; ++k) {
+    if (strcmp(s, KIND_NAMES[k]) == 0) {
+      *out = (dec_kind_t)k;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Load the run_index-th H..E block of CAP records from a log file
+static bool load_capture(FILE *f, int run_index, capture_t *cap) {
+  char line[512];
+  int run = -1;
+  bool in_run = false;
+  memset(cap, 0, sizeof(*cap));
+
+  while (fgets(line, sizeof(line), f)) {
+    char *p = strstr(line, "CAP,");
+    if (!p) {
+      continue;
+    }
+    p[strcspn(p, "\r\n")] = '\0';
+    char type = p[4];
+    const char *rec = p + 6;
+    if (type == 'H') {
+      run++;
+      in_run = (run == run_index);
+      if (in_run) {
+        if (sscanf(rec, "%lld,%lld,%15s", &cap->t0_ms, &cap->epoch0,
+                   cap->program) != 3) {
+          return false;
+        }
+        cap->end_ms = cap->t0_ms;
+      }
+      continue;
+    }
+    if (!in_run) {
+      continue;
+    }
+    long long t = 0;
+    if (type == 'S') {
+      sample_t s;
+      if (sscanf(rec, "%lld,%d,%d", &s.t_ms, &s.raw, &s.mv) == 3) {
+        VEC_PUSH(cap->samples, s);
+        t = s.t_ms;
+      }
+    } else if (type == 'A') {
+      action_t a;
+      if (sscanf(rec, "%lld,%d", &a.t_ms, &a.action) == 2) {
+        VEC_PUSH(cap->actions, a);
+        t = a.t_ms;
+      }
+    } else if (type == 'D') {
+      decision_t d = {0};
+      char kind[16] = {0};
+      if (sscanf(rec, "%lld,%lld,%d,%15[^,],%23s", &t, &d.epoch, &d.step, kind,
+                 d.arg) >= 4 &&
+          parse_kind(kind, &d.kind)) {
+        VEC_PUSH(cap->decisions, d);
+      }
+    } else if (type == 'E') {
+      sscanf(rec, "%lld", &t);
+      if (t > cap->end_ms) {
+        cap->end_ms = t;
+      }
+      return true;
+    }
+    if (t > cap->end_ms) {
+      cap->end_ms = t;
+    }
+  }
+  return run >= run_index;
+}
+
+static const Program_Entry *find_program(const char *name) {
+  for (int i = 0; i < NUM_PROGRAMS; ++i) {
+    if (strcmp(Programs[i].name, name) == 0) {
+      return &Programs[i];
+    }
+  }
+  return NULL;
+}
+
+// CurrentTemp as the firmware would have published it at t_ms
+static int temp_at(const capture_t *cap, size_t *cursor, long long t_ms) {
+  while (*cursor + 1 < cap->samples.n &&
+         cap->samples.v[*cursor + 1].t_ms <= t_ms) {
+    (*cursor)++;
+  }
+  if (cap->samples.n == 0 || cap->samples.v[*cursor].t_ms > t_ms) {
+    return 0; // init_status() value before the first sample
+  }
+  return analog_temp_f_round(analog_temp_f_from_mv(cap->samples.v[*cursor].mv));
+}
+
+static bool skip_between(const capture_t *cap, long long from_ms,
+                         long long to_ms) {
+  for (size_t i = 0; i < cap->actions.n; ++i) {
+    const action_t *a = &cap->actions.v[i];
+    if (a->action == ACTION_ADMIN_SKIP_STEP && a->t_ms > from_ms &&
+        a->t_ms <= to_ms) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// When run_program()'s wait_step_event() would return after t_ms: at the
+// tick, or earlier on a dispatched action or (thermostat lines) on a sample
+// that changes the published temperature
+static long long next_wake(const capture_t *cap, long long t_ms,
+                           long long tick_ms, bool temp_matters,
+                           int last_temp) {
+  long long wake = tick_ms;
+  for (size_t i = 0; i < cap->actions.n; ++i) {
+    const long long at = cap->actions.v[i].t_ms;
+    if (at > t_ms && at < wake) {
+      wake = at;
+    }
+  }
+  if (temp_matters) {
+    for (size_t i = 0; i < cap->samples.n; ++i) {
+      const sample_t *s = &cap->samples.v[i];
+      if (s->t_ms <= t_ms) {
+        continue;
+      }
+      if (s->t_ms >= wake) {
+        break;
+      }
+      if (analog_temp_f_round(analog_temp_f_from_mv(s->mv)) != last_temp) {
+        wake = s->t_ms;
+        break;
+      }
+    }
+  }
+  return wake;
+}
+
+static inline long long epoch_at(const capture_t *cap, long long t_ms) {
+  return cap->epoch0 + (t_ms - cap->t0_ms) / 1000;
+}
+
+// Mirror of run_program()'s line loop on a simulated clock
+static void simulate(const capture_t *cap, const Program_Entry *prog,
+                     decision_vec_t *out, long long *sim_end_ms) {
+  long long t = cap->t0_ms;
+  long long last_tick = t;
+  size_t cursor = 0;
+
+  for (size_t li = 0; li < prog->num_lines && t <= cap->end_ms; ++li) {
+    const int step = (int)li + 1;
+    step_ctl_t ctl;
+    step_ctl_begin(&ctl, &prog->lines[li], (time_t)epoch_at(cap, t));
+    decision_t d = {epoch_at(cap, t), step, DEC_BEGIN, ""};
+    VEC_PUSH(*out, d);
+
+    long long next_tick = t + STEP_CTL_TICK_MS;
+    for (;;) {
+      const bool skip = skip_between(cap, last_tick, t);
+      last_tick = t;
+      const long long now = epoch_at(cap, t);
+      const int temp = temp_at(cap, &cursor, t);
+      step_ctl_result_t r = step_ctl_tick(&ctl, temp, (time_t)now, skip);
+      if (r.events & STEP_EV_HEAT_RESUMED) {
+        decision_t h = {now, step, DEC_HEAT_ON, ""};
+        VEC_PUSH(*out, h);
+      } else if (r.events & STEP_EV_HEAT_PAUSED) {
+        decision_t h = {now, step, DEC_HEAT_OFF, ""};
+        VEC_PUSH(*out, h);
+      }
+      if (r.end != STEP_END_NONE) {
+        decision_t e = {now, step, DEC_END, ""};
+        snprintf(e.arg, sizeof(e.arg), "%s", step_end_name(r.end));
+        VEC_PUSH(*out, e);
+        break;
+      }
+      if (t > cap->end_ms) {
+        break; // capture ended mid-line
+      }
+      t = next_wake(cap, t, next_tick, ctl.has_temp_targets, temp);
+      if (t == next_tick) {
+        next_tick += STEP_CTL_TICK_MS;
+      }
+    }
+  }
+  *sim_end_ms = t;
+}
+
+// n-th decision of (step, kind) in a list, or NULL
+static const decision_t *nth_match(const decision_t *v, size_t n, int step,
+                                   dec_kind_t kind, int ordinal) {
+  for (size_t i = 0; i < n; ++i) {
+    if (v[i].step == step && v[i].kind == kind && ordinal-- == 0) {
+      return &v[i];
+    }
+  }
+  return NULL;
+}
+
+static int count_kind(const decision_t *v, size_t n, int step,
+                      dec_kind_t kind) {
+  int c = 0;
+  for (size_t i = 0; i < n; ++i) {
+    c += (v[i].step == step && v[i].kind == kind);
+  }
+  return c;
+}
+
+// Report every recorded decision missing, late/early or different in the
+// replay, and every replayed decision the device did not make.
+static int diff_decisions(const decision_t *rec, size_t nrec,
+                          const decision_t *sim, size_t nsim, int steps,
+                          long long tol_s) {
+  int divergences = 0;
+  for (int step = 1; step <= steps; ++step) {
+    for (int k = DEC_HEAT_ON; k <= DEC_END; ++k) {
+      const int nr = count_kind(rec, nrec, step, (dec_kind_t)k);
+      const int ns = count_kind(sim, nsim, step, (dec_kind_t)k);
+      const int n = nr > ns ? nr : ns;
+      for (int i = 0; i < n; ++i) {
+        const decision_t *r = nth_match(rec, nrec, step, (dec_kind_t)k, i);
+        const decision_t *s = nth_match(sim, nsim, step, (dec_kind_t)k, i);
+        if (r && s) {
+          const long long dt = s->epoch - r->epoch;
+          const bool arg_diff = (k == DEC_END) && strcmp(r->arg, s->arg) != 0;
+          if (dt > tol_s || dt < -tol_s || arg_diff) {
+            printf("DIVERGE step=%d %s#%d recorded@%+lld %s replay@%+lld %s "
+                   "(dt=%+llds)\n",
+                   step, KIND_NAMES[k], i, r->epoch, r->arg, s->epoch, s->arg,
+                   dt);
+            divergences++;
+          }
+        } else if (r) {
+          printf("MISSING step=%d %s#%d recorded@%lld %s (replay never did "
+                 "it)\n",
+                 step, KIND_NAMES[k], i, r->epoch, r->arg);
+          divergences++;
+        } else {
+          printf("EXTRA   step=%d %s#%d replay@%lld %s (device never did it)\n",
+                 step, KIND_NAMES[k], i, s->epoch, s->arg);
+          divergences++;
+        }
+      }
+    }
+  }
+  return divergences;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <capture.log> [run_index] [tolerance_s]\n",
+            argv[0]);
+    return 2;
+  }
+  const int run_index = (argc > 2) ? atoi(argv[2]) : 0;
+  const long long tol_s = (argc > 3) ? atoll(argv[3]) : DEFAULT_TOLERANCE_S;
+
+  FILE *f = fopen(argv[1], "r");
+  if (!f) {
+    perror(argv[1]);
+    return 2;
+  }
+  capture_t cap;
+  const bool ok = load_capture(f, run_index, &cap);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "no CAP run #%d in %s\n", run_index, argv[1]);
+    return 2;
+  }
+  const Program_Entry *prog = find_program(cap.program);
+  if (!prog) {
+    fprintf(stderr, "unknown program '%s'\n", cap.program);
+    return 2;
+  }
+
+  decision_vec_t sim = {0};
+  long long sim_end_ms = 0;
+  const clock_t c0 = clock();
+  simulate(&cap, prog, &sim, &sim_end_ms);
+  const clock_t c1 = clock();
+
+  const double sim_hours = (double)(sim_end_ms - cap.t0_ms) / 3.6e6;
+  const double cpu_ms = 1000.0 * (double)(c1 - c0) / CLOCKS_PER_SEC;
+  printf("run #%d program=%s samples=%zu actions=%zu recorded_decisions=%zu "
+         "replayed_decisions=%zu\n",
+         run_index, cap.program, cap.samples.n, cap.actions.n,
+         cap.decisions.n, sim.n);
+  printf("simulated %.3f h in %.3f ms CPU (%.3f ms CPU per simulated hour)\n",
+         sim_hours, cpu_ms, sim_hours > 0 ? cpu_ms / sim_hours : 0.0);
+
+  const int div = diff_decisions(cap.decisions.v, cap.decisions.n, sim.v,
+                                 sim.n, (int)prog->num_lines, tol_s);
+  printf("%d divergence(s) at tolerance %llds\n", div, tol_s);
+
+  free(cap.samples.v);
+  free(cap.actions.v);
+  free(cap.decisions.v);
+  free(sim.v);
+  return div ? 1 : 0;
+}